@@ -0,0 +1,505 @@
+import ctypes
+from ctypes import c_char_p, c_int, c_void_p, c_ubyte, POINTER
+import argparse
+import json
+import multiprocessing
+import platform
+import sys
+import socket
+import struct
+import time
+
+FRAME = struct.Struct('<IB3x8s')  # can_frame как его передает socat: cobid, длина, данные
+SIMULATED_NODES = 64  # заменитель отвечает только узлам 1..64, остальные считаются отсутствующими
+BACK_TO_BACK_ROUNDS = 300  # повторов блочного чтения и сразу записи к одному узлу в check_sdo_transfers
+
+
+class PdoRecord(ctypes.Structure):
+    """
+    Запись PDO (struct PdoRecord в can_dll.h).
+    """
+    _fields_ = [('timestamp_ns', ctypes.c_uint64),
+                ('cobid', ctypes.c_uint16),
+                ('len', ctypes.c_uint8),
+                ('reserved', c_ubyte * 5),
+                ('data', c_ubyte * 8)]
+
+
+class IoStats(ctypes.Structure):
+    """
+    Счетчики системных вызовов (struct IoStats в can_dll.h).
+    """
+    _fields_ = [('rxSyscalls', ctypes.c_uint64),
+                ('rxFrames', ctypes.c_uint64),
+                ('txSyscalls', ctypes.c_uint64),
+                ('txFrames', ctypes.c_uint64)]
+
+
+class BenchResult(ctypes.Structure):
+    """
+    Результат микробенчмарка (struct BenchResult в can_dll.h).
+    """
+    _fields_ = [('name', ctypes.c_char * 32),
+                ('iterations', ctypes.c_uint64),
+                ('total_ns', ctypes.c_uint64)]
+
+
+class SimulatorStats(ctypes.Structure):
+    """
+    Счетчики симулятора узлов (struct SimulatorStats в can_dll.h).
+    """
+    _fields_ = [('rxFrames', ctypes.c_uint64),
+                ('txFrames', ctypes.c_uint64),
+                ('sdoRequests', ctypes.c_uint64),
+                ('sdoAborts', ctypes.c_uint64),
+                ('tpdoFrames', ctypes.c_uint64),
+                ('emcyFrames', ctypes.c_uint64),
+                ('txSyscalls', ctypes.c_uint64),
+                ('overruns', ctypes.c_uint64)]
+
+
+class LatencyHistogram(ctypes.Structure):
+    """
+    Гистограмма задержек в наносекундах (struct LatencyHistogram в can_dll.h).
+    """
+    _fields_ = [('count', ctypes.c_uint64),
+                ('sum_ns', ctypes.c_uint64),
+                ('buckets', ctypes.c_uint64 * 256)]
+
+
+TRACE_STAGES = ['kernel', 'dispatch', 'callback_wait', 'callback_run', 'sdo_wake', 'total']  # trace_stage_* в can_dll.h
+
+
+class TraceStats(ctypes.Structure):
+    """
+    Разбивка задержек по этапам (struct TraceStats в can_dll.h).
+    """
+    _fields_ = [('stamped', ctypes.c_uint64),
+                ('unstamped', ctypes.c_uint64),
+                ('sampled', ctypes.c_uint64),
+                ('dropped', ctypes.c_uint64),
+                ('stages', LatencyHistogram * len(TRACE_STAGES))]
+
+
+def responder(port: int, ready, peers):
+    """
+    Заменитель socat и узлов CANopen: отвечает на SDO запросы через локальный UDP.
+
+    @param port: Порт на котором слушаем.
+    @param ready: Событие готовности сокета.
+    @param peers: Очередь, в которую кладем адрес подключившейся dll.
+    """
+    sock = socket.socket(socket.AF_INET, socket.SOCK_DGRAM)
+    sock.bind(('127.0.0.1', port))
+    ready.set()
+    objects = {}
+    while True:
+        data, addr = sock.recvfrom(64)
+        if len(data) < FRAME.size:
+            continue
+        cobid, _, payload = FRAME.unpack(data[:FRAME.size])
+        cobid &= 0x7FF
+        if cobid == 0:  # стартовый пакет ConnectToUDPServer, отвечаем heartbeat чтобы подключение прошло
+            sock.sendto(FRAME.pack(0x700 + 0x7F, 1, b'\x05'), addr)
+            peers.put(addr)
+            continue
+        if not 0x601 <= cobid <= 0x600 + SIMULATED_NODES:
+            continue
+        node = cobid - 0x600
+        command = payload[0]
+        key = (node, payload[1] | payload[2] << 8, payload[3])
+        if command == 0x40:  # чтение, отвечаем 4 байтами
+            answer = bytes([0x43]) + payload[1:4] + struct.pack('<I', objects.get(key, 0))
+        elif command & 0xE0 == 0x20:  # запись
+            objects[key] = struct.unpack('<I', payload[4:8])[0]
+            answer = bytes([0x60]) + payload[1:4] + bytes(4)
+        else:
+            continue
+        sock.sendto(FRAME.pack(0x580 + node, 8, answer), addr)
+
+
+def flood(addr, count: int):
+    """
+    Генератор потока PDO: отправляет count пакетов на адрес dll так быстро, как может.
+    """
+    sock = socket.socket(socket.AF_INET, socket.SOCK_DGRAM)
+    frames = [FRAME.pack(0x181 + i % 0x7F, 8, struct.pack('<Q', i)) for i in range(1024)]
+    for i in range(count):
+        sock.sendto(frames[i & 1023], addr)
+
+
+def percentile(values: list, p: float) -> float:
+    """
+    Перцентиль по отсортированному списку.
+    """
+    return values[min(len(values) - 1, int(len(values) * p))]
+
+
+def histogram_percentile(histogram: LatencyHistogram, p: float) -> int:
+    """
+    Нижняя граница ячейки гистограммы dll, в которую попадает перцентиль p, в наносекундах.
+    """
+    target = histogram.count * p
+    accumulated = 0
+    for i, count in enumerate(histogram.buckets):
+        accumulated += count
+        if count and accumulated >= target:
+            return i if i < 8 else (8 + i % 8) << (i // 8 - 1)
+    return 0
+
+
+def trace_breakdown(dll: ctypes.CDLL, worker) -> dict:
+    """
+    Разбивка задержек принятых пакетов по этапам за весь прогон (--trace): от приема ядром до конца пути пакета.
+    """
+    stats = TraceStats()
+    dll.GetTraceStats(worker, ctypes.byref(stats))
+    result = {'name': 'latency_trace', 'kernel_stamped': stats.stamped, 'unstamped': stats.unstamped}
+    for stage, histogram in zip(TRACE_STAGES, stats.stages):
+        if histogram.count:
+            result[f'{stage}_p50_us'] = round(histogram_percentile(histogram, 0.50) / 1e3, 2)
+            result[f'{stage}_p99_us'] = round(histogram_percentile(histogram, 0.99) / 1e3, 2)
+    return result
+
+
+def bench_codec(dll: ctypes.CDLL, iterations: int) -> list:
+    """
+    Микробенчмарки разбора пакетов внутри dll (RunBenchmark): makeSDOhead, verifySDO, классификация cobid
+    и разбор PDO/EMCY через dispatchFrame без callback и с пустым callback. Запускается на отдельном Worker без подключения.
+
+    @return: Список словарей с результатами в наносекундах на операцию.
+    """
+    worker = dll.CreateWorker()
+    results = (BenchResult * 8)()
+    count = dll.RunBenchmark(worker, iterations, results, len(results))
+    dll.DestroyWorker(worker)
+    return [{
+        'name': 'codec_' + result.name.decode(),
+        'iterations': result.iterations,
+        'ns_per_op': round(result.total_ns / result.iterations, 2),
+    } for result in results[:max(count, 0)]]
+
+
+def bench_sdo(dll: ctypes.CDLL, worker, count: int, node: int) -> dict:
+    """
+    Измеряет задержку ответа и процессорное время на одну SDO транзакцию чтения.
+
+    @return: Словарь с результатами в микросекундах.
+    """
+    buffer = (c_ubyte * 5)()
+    latencies = []
+    errors = 0
+    cpu_start = time.process_time()
+    wall_start = time.perf_counter()
+    for i in range(count):
+        t0 = time.perf_counter()
+        if dll.ReadSDO(worker, node, 0x6411, 1 + i % 8, buffer, 200) < 0:
+            errors += 1
+        latencies.append((time.perf_counter() - t0) * 1e6)
+    wall = time.perf_counter() - wall_start
+    cpu = time.process_time() - cpu_start
+    latencies.sort()
+    return {
+        'name': 'sdo_read',
+        'count': count,
+        'errors': errors,
+        'p50_us': round(percentile(latencies, 0.50), 1),
+        'p99_us': round(percentile(latencies, 0.99), 1),
+        'cpu_us_per_op': round(cpu / count * 1e6, 1),
+        'ops_per_s': round(count / wall),
+    }
+
+
+def check_sdo_transfers(dll: ctypes.CDLL, worker, simulator, node: int) -> dict:
+    """
+    Проверяет сегментированные и блочные UploadSDO/DownloadSDO через симулятор: объекты размером 5, 7, 8, 889
+    и 127 * 7 + 1 байт (больше одного блока) туда и обратно, с crc и без, затем блочное чтение и сразу блочную запись
+    к тому же узлу BACK_TO_BACK_ROUNDS раз.
+
+    @return: Словарь с количеством проверок и ошибок, в mismatches - описание расхождений.
+    """
+    sizes = [5, 7, 8, 889, 127 * 7 + 1]
+    capacity = max(sizes) + 16
+    buffer = (c_ubyte * capacity)()
+    checks = 0
+    mismatches = []
+    for crc in (True, False):
+        dll.SimSetBlockCrc(simulator, 1 if crc else 0)
+        for block in (0, 1):
+            for size in sizes:
+                sub_index = size & 0xFF
+                checks += 2
+                data = bytes((i * 7 + size + block) & 0xFF for i in range(size))
+                source = (c_ubyte * size).from_buffer_copy(data)
+                result = dll.DownloadSDO(worker, node, 0x2000 + block, sub_index, source, size, block, 500)
+                stored = dll.SimGetDomain(simulator, node, 0x2000 + block, sub_index, buffer, capacity)
+                if result != 1 or bytes(buffer[:max(stored, 0)]) != data:
+                    mismatches.append(f'download size={size} block={block} crc={crc}: {result} stored={stored}')
+                data = data[::-1]
+                dll.SimSetDomain(simulator, node, 0x2100 + block, sub_index, (c_ubyte * size).from_buffer_copy(data), size)
+                result = dll.UploadSDO(worker, node, 0x2100 + block, sub_index, buffer, capacity, block, 500)
+                if result != size or bytes(buffer[:size]) != data:
+                    mismatches.append(f'upload size={size} block={block} crc={crc}: {result}')
+    dll.SimSetBlockCrc(simulator, 1)
+    size = 127 * 7 + 1
+    for attempt in range(BACK_TO_BACK_ROUNDS):  # подтверждение конца блочного чтения должно уйти раньше следующей записи
+        checks += 2
+        data = bytes((i + attempt) & 0xFF for i in range(size))
+        dll.SimSetDomain(simulator, node, 0x2101, 1, (c_ubyte * size).from_buffer_copy(data), size)
+        result = dll.UploadSDO(worker, node, 0x2101, 1, buffer, capacity, 1, 500)
+        if result != size or bytes(buffer[:size]) != data:
+            mismatches.append(f'back-to-back upload #{attempt}: {result}')
+        data = data[::-1]
+        result = dll.DownloadSDO(worker, node, 0x2001, 1, (c_ubyte * size).from_buffer_copy(data), size, 1, 500)
+        stored = dll.SimGetDomain(simulator, node, 0x2001, 1, buffer, capacity)
+        if result != 1 or bytes(buffer[:max(stored, 0)]) != data:
+            mismatches.append(f'back-to-back download #{attempt}: {result} stored={stored}')
+    return {'name': 'sdo_transfers', 'checks': checks, 'errors': len(mismatches), 'mismatches': mismatches}
+
+
+def bench_sdo_timeout(dll: ctypes.CDLL, worker, timeout_ms: int) -> dict:
+    """
+    Измеряет процессорное время ожидания ответа от несуществующего узла (весь таймаут).
+    """
+    buffer = (c_ubyte * 5)()
+    cpu_start = time.process_time()
+    t0 = time.perf_counter()
+    result = dll.ReadSDO(worker, SIMULATED_NODES + 1, 0x1000, 0, buffer, timeout_ms)  # этот узел заменитель не обслуживает
+    wall = time.perf_counter() - t0
+    return {
+        'name': 'sdo_timeout',
+        'result': result,
+        'wall_ms': round(wall * 1e3, 1),
+        'cpu_ms': round((time.process_time() - cpu_start) * 1e3, 1),
+    }
+
+
+def bench_pdo_rx(dll: ctypes.CDLL, worker, addr, count: int) -> dict:
+    """
+    Измеряет скорость приема PDO потоком чтения и количество системных вызовов на пакет.
+    """
+    records = (PdoRecord * 65536)()
+    before, after = IoStats(), IoStats()
+    dll.GetIOStats(worker, ctypes.byref(before))
+    generator = multiprocessing.Process(target=flood, args=(addr, count))
+    t0 = time.perf_counter()
+    generator.start()
+    received = 0
+    last = time.perf_counter()
+    while time.perf_counter() - last < 0.5:  # ждем пока поток пакетов не иссякнет
+        n = dll.DrainPDO(worker, records, len(records))
+        if n > 0:
+            received += n
+            last = time.perf_counter()
+        else:
+            time.sleep(0.001)
+    generator.join()
+    dll.GetIOStats(worker, ctypes.byref(after))
+    frames = after.rxFrames - before.rxFrames
+    return {
+        'name': 'pdo_rx',
+        'sent': count,
+        'received': received,
+        'frames_per_s': round(received / (last - t0)),
+        'syscalls_per_frame': round((after.rxSyscalls - before.rxSyscalls) / max(frames, 1), 3),
+    }
+
+
+def bench_sim_pdo_rx(dll: ctypes.CDLL, worker, simulator, nodes: int, period_us: int, duration: float) -> dict:
+    """
+    Измеряет скорость приема TPDO от симулятора dll: все узлы 1..nodes отправляют по четыре TPDO с периодом period_us.
+    """
+    records = (PdoRecord * 65536)()
+    before, after = SimulatorStats(), SimulatorStats()
+    for node in range(1, nodes + 1):
+        for pdo in range(1, 5):
+            dll.SimSetTPDO(simulator, node, pdo, period_us, 8)
+    received = 0
+    dll.GetSimulatorStats(simulator, ctypes.byref(before))
+    t0 = time.perf_counter()
+    while time.perf_counter() - t0 < duration:
+        n = dll.DrainPDO(worker, records, len(records))
+        if n > 0:
+            received += n
+        else:
+            time.sleep(0.001)
+    wall = time.perf_counter() - t0
+    dll.GetSimulatorStats(simulator, ctypes.byref(after))
+    for node in range(1, nodes + 1):
+        for pdo in range(1, 5):
+            dll.SimSetTPDO(simulator, node, pdo, 0, 8)
+    sent = after.tpdoFrames - before.tpdoFrames
+    return {
+        'name': 'sim_pdo_rx',
+        'offered_fps': round(nodes * 4 * 1e6 / period_us),
+        'sent': sent,
+        'received': received,
+        'frames_per_s': round(received / wall),
+        'loss': round(1 - received / max(sent, 1), 4),
+        'sim_overruns': after.overruns - before.overruns,
+    }
+
+
+def bench_pdo_tx(dll: ctypes.CDLL, worker, count: int, batch: int) -> dict:
+    """
+    Измеряет скорость отправки PDO через WritePDOBatch (batch > 1) или WritePDO (batch = 1).
+    """
+    frames = (PdoRecord * batch)(*[PdoRecord(0, 0x201 + i % 0x7F, 8) for i in range(batch)])
+    payload = (c_ubyte * 8)()
+    before, after = IoStats(), IoStats()
+    dll.GetIOStats(worker, ctypes.byref(before))
+    t0 = time.perf_counter()
+    for _ in range(count // batch):
+        if batch > 1:
+            dll.WritePDOBatch(worker, frames, batch)
+        else:
+            dll.WritePDO(worker, 1, 0x200, payload, 8)
+    wall = time.perf_counter() - t0
+    dll.GetIOStats(worker, ctypes.byref(after))
+    sent = after.txFrames - before.txFrames
+    return {
+        'name': 'pdo_tx_batch' if batch > 1 else 'pdo_tx',
+        'batch': batch,
+        'sent': sent,
+        'frames_per_s': round(sent / wall),
+        'syscalls_per_frame': round((after.txSyscalls - before.txSyscalls) / max(sent, 1), 3),
+    }
+
+
+def compare(results: list, baseline: list, tolerance: float) -> list:
+    """
+    Сравнивает результаты с сохраненными результатами другой сборки dll.
+    Метрики *_per_s лучше больше, *_us, *_ms, *_ns, ns_per_op и *_per_frame лучше меньше.
+
+    @param tolerance: Допустимое ухудшение (0.2 - на 20%).
+    @return: Список словарей с ухудшившимися метриками.
+    """
+    old = {result['name']: result for result in baseline}
+    regressions = []
+    for result in results:
+        reference = old.get(result['name'])
+        if reference is None:
+            continue
+        for key, value in result.items():
+            before = reference.get(key)
+            if not isinstance(value, (int, float)) or not isinstance(before, (int, float)) or before <= 0:
+                continue
+            if key.endswith('_per_s'):
+                worse = value < before * (1 - tolerance)
+            elif key.endswith(('_us', '_ms', '_ns', 'ns_per_op', '_per_frame')):
+                worse = value > before * (1 + tolerance)
+            else:
+                continue
+            if worse:
+                regressions.append({'name': result['name'], 'metric': key, 'baseline': before, 'value': value})
+    return regressions
+
+
+if __name__ == "__main__":
+    parser = argparse.ArgumentParser(description='Бенчмарк разбора пакетов, SDO транзакций и потока PDO dll через локальный UDP')
+    parser.add_argument('--dll', default='can_dll.dll', help='путь к dll')
+    parser.add_argument('--port', type=int, default=2100, help='порт заменителя socat')
+    parser.add_argument('--count', type=int, default=5000, help='количество SDO транзакций')
+    parser.add_argument('--iterations', type=int, default=1000000, help='операций в каждом микробенчмарке')
+    parser.add_argument('--responder', choices=['sim', 'python'], default='sim',
+                        help='sim - симулятор узлов внутри dll, python - заменитель в отдельном процессе (для старых сборок dll)')
+    parser.add_argument('--trace', action='store_true', help='трассировка задержек по этапам (время приема ядром, поток чтения, callback)')
+    parser.add_argument('--output', help='файл для сохранения результатов в json')
+    parser.add_argument('--baseline', help='файл результатов другой сборки dll, ухудшение больше --tolerance завершает бенчмарк с кодом 1')
+    parser.add_argument('--tolerance', type=float, default=0.2, help='допустимое ухудшение метрик относительно --baseline')
+    args = parser.parse_args()
+
+    dll = ctypes.CDLL(args.dll)
+    dll.CreateWorker.restype = POINTER(c_void_p)
+    dll.DestroyWorker.argtypes = [POINTER(c_void_p)]
+    dll.CreateSocket.argtypes = [POINTER(c_void_p)]
+    dll.ConnectToUDPServer.argtypes = [POINTER(c_void_p), c_char_p, c_int]
+    dll.ReadSDO.argtypes = [POINTER(c_void_p), c_int, c_int, c_int, POINTER(c_ubyte), c_int]
+    dll.WritePDO.argtypes = [POINTER(c_void_p), c_int, c_int, POINTER(c_ubyte), c_int]
+    dll.WritePDOBatch.argtypes = [POINTER(c_void_p), POINTER(PdoRecord), c_int]
+    dll.EnablePDORing.argtypes = [POINTER(c_void_p), c_int]
+    dll.DrainPDO.argtypes = [POINTER(c_void_p), POINTER(PdoRecord), c_int]
+    dll.GetIOStats.argtypes = [POINTER(c_void_p), POINTER(IoStats)]
+    dll.Disconnect.argtypes = [POINTER(c_void_p)]
+    if args.trace:
+        dll.EnableLatencyTrace.argtypes = [POINTER(c_void_p), c_int, c_int]
+        dll.GetTraceStats.argtypes = [POINTER(c_void_p), POINTER(TraceStats)]
+    if args.responder == 'sim' and not hasattr(dll, 'CreateSimulator'):
+        raise SystemExit('в dll нет симулятора узлов, используйте --responder python')
+    if hasattr(dll, 'RunBenchmark'):
+        dll.RunBenchmark.argtypes = [POINTER(c_void_p), c_int, POINTER(BenchResult), c_int]
+    if args.responder == 'sim':
+        dll.CreateSimulator.argtypes = [c_char_p, c_int]
+        dll.CreateSimulator.restype = c_void_p
+        dll.DestroySimulator.argtypes = [c_void_p]
+        dll.SimAddNode.argtypes = [c_void_p, c_int]
+        dll.SimSetObject.argtypes = [c_void_p, c_int, c_int, c_int, ctypes.c_uint32, c_int]
+        dll.SimSetTPDO.argtypes = [c_void_p, c_int, c_int, c_int, c_int]
+        dll.SimSetDomain.argtypes = [c_void_p, c_int, c_int, c_int, POINTER(c_ubyte), c_int]
+        dll.SimGetDomain.argtypes = [c_void_p, c_int, c_int, c_int, POINTER(c_ubyte), c_int]
+        dll.SimSetBlockCrc.argtypes = [c_void_p, c_int]
+        dll.UploadSDO.argtypes = [POINTER(c_void_p), c_int, c_int, c_int, POINTER(c_ubyte), c_int, c_int, c_int]
+        dll.DownloadSDO.argtypes = [POINTER(c_void_p), c_int, c_int, c_int, POINTER(c_ubyte), c_int, c_int, c_int]
+        dll.GetSimulatorStats.argtypes = [c_void_p, POINTER(SimulatorStats)]
+
+    results = bench_codec(dll, args.iterations) if hasattr(dll, 'RunBenchmark') else []
+
+    server = simulator = None
+    if args.responder == 'sim':
+        simulator = dll.CreateSimulator(b'127.0.0.1', args.port)
+        if not simulator:
+            raise SystemExit('не удалось запустить симулятор узлов')
+        for node in range(1, SIMULATED_NODES + 1):  # узел SIMULATED_NODES + 1 не отвечает, на нем меряется таймаут
+            dll.SimAddNode(simulator, node)
+        for sub_index in range(1, 9):
+            dll.SimSetObject(simulator, 12, 0x6411, sub_index, sub_index, 4)
+    else:
+        ready = multiprocessing.Event()
+        peers = multiprocessing.Queue()
+        server = multiprocessing.Process(target=responder, args=(args.port, ready, peers), daemon=True)
+        server.start()
+        ready.wait()
+
+    worker = dll.CreateWorker()
+    dll.EnablePDORing(worker, 65536)
+    if args.trace:
+        dll.EnableLatencyTrace(worker, 0, 0)
+    if dll.CreateSocket(worker) < 0 or dll.ConnectToUDPServer(worker, b'127.0.0.1', args.port) < 0:
+        raise SystemExit('не удалось подключиться к заменителю socat')
+
+    # python заменитель отвечает из другого процесса, поэтому process_time считает только время dll и интерпретатора
+    results += [bench_sdo(dll, worker, args.count, 12),
+                bench_sdo_timeout(dll, worker, 500)]
+    if simulator:
+        results.append(check_sdo_transfers(dll, worker, simulator, 12))
+        results.append(bench_sim_pdo_rx(dll, worker, simulator, SIMULATED_NODES, 2000, 2.0))
+    else:
+        results.append(bench_pdo_rx(dll, worker, peers.get(), args.count * 20))
+    results += [bench_pdo_tx(dll, worker, args.count * 20, 1),
+                bench_pdo_tx(dll, worker, args.count * 20, 256)]
+    if args.trace:
+        results.append(trace_breakdown(dll, worker))
+    for result in results:
+        print(json.dumps(result))
+
+    dll.Disconnect(worker)
+    dll.DestroyWorker(worker)
+    if simulator:
+        dll.DestroySimulator(simulator)
+    if server:
+        server.terminate()
+
+    if args.output:
+        with open(args.output, 'w') as file:
+            json.dump({'dll': args.dll, 'responder': args.responder, 'platform': platform.platform(),
+                       'python': platform.python_version(), 'time': time.time(), 'results': results}, file, indent=1)
+    failed = [result for result in results if result['name'] == 'sdo_transfers' and result['errors']]
+    if args.baseline:
+        with open(args.baseline) as file:
+            regressions = compare(results, json.load(file)['results'], args.tolerance)
+        for regression in regressions:
+            print(json.dumps(dict(regression, name='regression', bench=regression['name'])), file=sys.stderr)
+        if regressions:
+            sys.exit(1)
+    if failed:
+        sys.exit(1)
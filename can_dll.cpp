@@ -1,30 +1,924 @@
 
 #include "can_dll.h"
+#ifdef _WIN32
 #include <winsock2.h>
+#include <ws2tcpip.h>
 #include <windows.h>
+#else
+#include <sys/socket.h>
+#include <sys/select.h>
+#include <sys/ioctl.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <signal.h>
+#endif
+#ifdef __linux__
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <net/if.h>
+#include <linux/can.h>
+#include <linux/can/raw.h>
+#include <time.h>
+#include <pthread.h>
+#endif
 #include <iostream>
 #include <cstring>
+#include <cstdio>
 #include <cstdint>
 #include <thread>
 #include <functional>
+#include <mutex>
+#include <condition_variable>
+#include <chrono>
+#include <vector>
+#include <algorithm>
+#include <atomic>
+#include <unordered_map>
+#include <string>
+#include <cerrno>
 
+#ifdef _WIN32
 #pragma comment(lib, "ws2_32.lib")
+#define CAN_DLL_EXPORT __declspec(dllexport)
+#else
+// POSIX сокеты не требуют инициализации, приводим их к именам winsock чтобы не ветвить код Worker
+typedef int SOCKET;
+struct WSADATA {};
+const SOCKET INVALID_SOCKET = -1;
+const int SOCKET_ERROR = -1;
+inline int MAKEWORD(int low, int high) { return low | (high << len_uint8); }
+inline int WSAStartup(int, WSADATA*) { return socket_init_success; }
+inline int WSACleanup() { return 0; }
+inline int closesocket(SOCKET s) { return close(s); }
+inline int ioctlsocket(SOCKET s, long cmd, unsigned long* arg) { int value = 0; int result = ioctl(s, cmd, &value); *arg = value; return result; }
+#define CAN_DLL_EXPORT __attribute__((visibility("default")))
+#endif
 
 
-#define IS_ANSWER true
-#define IS_REQUEST false
-
 // Определение типа callback-функции
 typedef void (*CallbackFunc)(unsigned char*);
 
+/**
+    * @brief Функция получения времени steady_clock в наносекундах.
+*/
+inline uint64_t steadyNs() {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+/**
+    * @brief Функция сна до абсолютного срока steady_clock в наносекундах.
+    * На Linux steady_clock - это CLOCK_MONOTONIC, поэтому срок передается в clock_nanosleep как есть.
+    * На Windows точность sleep_until ограничена квантом планировщика.
+*/
+inline void sleepUntilNs(uint64_t deadline_ns) {
+#ifdef __linux__
+    timespec deadline = {static_cast<time_t>(deadline_ns / (static_cast<uint64_t>(ms_in_sec) * us_in_ms * ns_in_us)),
+                         static_cast<long>(deadline_ns % (static_cast<uint64_t>(ms_in_sec) * us_in_ms * ns_in_us))};
+    while (clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &deadline, nullptr) == EINTR) {} // сигнал не сдвигает срок
+#else
+    std::this_thread::sleep_until(std::chrono::steady_clock::time_point(std::chrono::nanoseconds(deadline_ns)));
+#endif
+}
+
+/**
+    * @brief Функция расчета crc16-ccitt блочной передачи SDO (Worker и симулятор узлов).
+    * @param data Данные.
+    * @param size Размер данных.
+    * @return crc.
+*/
+inline uint16_t crc16(const unsigned char* data, uint32_t size) {
+    uint16_t crc = 0;
+    for (uint32_t i = 0; i < size; i++) {
+        crc ^= static_cast<uint16_t>(data[i]) << len_uint8;
+        for (int bit = 0; bit < len_uint8; bit++) {
+            crc = (crc & crc16_top_bit) ? static_cast<uint16_t>((crc << 1) ^ crc16_poly) : static_cast<uint16_t>(crc << 1);
+        }
+    }
+    return crc;
+}
+
+/**
+    * @brief Функция замера одного измерения бенчмарка.
+    * @param results Массив результатов.
+    * @param count Количество заполненных результатов, увеличивается на один.
+    * @param max Размер массива, лишние измерения пропускаются.
+    * @param name Имя измерения.
+    * @param iterations Количество вызовов op.
+    * @param op Операция, принимает номер итерации.
+*/
+template <typename Op>
+void benchLoop(BenchResult* results, int& count, int max, const char* name, int iterations, Op op) {
+    if (count >= max) return;
+    uint64_t start = steadyNs();
+    for (int i = 0; i < iterations; i++) op(i);
+    BenchResult& result = results[count++];
+    result = BenchResult{};
+    std::strncpy(result.name, name, bench_name_len - 1);
+    result.iterations = static_cast<uint64_t>(iterations);
+    result.total_ns = steadyNs() - start;
+}
+
+/**
+    * @brief Функция записи под seqlock: seq нечетный на время записи. Писатель один (поток чтения Worker или вызов под мьютексом).
+    * @param seq Счетчик версий.
+    * @param write Запись полей relaxed store'ами.
+*/
+template <typename Write>
+void seqlockWrite(std::atomic<uint32_t>& seq, Write write) {
+    uint32_t value = seq.load(std::memory_order_relaxed);
+    seq.store(value + 1, std::memory_order_relaxed); // начало записи
+    std::atomic_thread_fence(std::memory_order_release);
+    write();
+    seq.store(value + 2, std::memory_order_release); // конец записи
+}
+
+/**
+    * @brief Функция согласованного чтения под seqlock: read повторяется, пока запись не перестанет вмешиваться.
+    * @param seq Счетчик версий.
+    * @param read Чтение полей relaxed load'ами, результат используется только после возврата true.
+    * @param attempts Количество попыток, 0 - без ограничения.
+    * @return true - прочитано false - все попытки пришлись на запись.
+*/
+template <typename Read>
+bool seqlockRead(std::atomic<uint32_t>& seq, Read read, int attempts = 0) {
+    for (int attempt = 0; attempts == 0 || attempt < attempts; attempt++) {
+        uint32_t before = seq.load(std::memory_order_acquire);
+        if (before & 1) { // писатель пишет прямо сейчас
+            std::this_thread::yield();
+            continue;
+        }
+        read();
+        std::atomic_thread_fence(std::memory_order_acquire);
+        if (seq.load(std::memory_order_relaxed) == before) return true; // запись не вмешалась
+    }
+    return false;
+}
+
+/**
+    * @brief Функция атомарного доступа к полю структуры в общей памяти (разметка общей памяти - обычные структуры из can_dll.h).
+*/
+template <typename T>
+std::atomic<T>& sharedField(T& field) {
+    static_assert(sizeof(std::atomic<T>) == sizeof(T) && std::atomic<T>::is_always_lock_free, "поле общей памяти должно быть lock-free");
+    return *reinterpret_cast<std::atomic<T>*>(&field);
+}
+
+/**
+    * @brief Функция атомарного доступа к payload слота/записи общей памяти как к одному uint64.
+*/
+inline std::atomic<uint64_t>& sharedPayload(uint8_t* data) {
+    return *reinterpret_cast<std::atomic<uint64_t>*>(data);
+}
 
 extern "C" {
+    /**
+        * Общий поток ввода-вывода для нескольких Worker: один epoll (select вне Linux) на все сокеты
+        * и одно колесо таймеров для heartbeat вместо своего потока чтения у каждого подключения.
+    */
+    class Reactor {
+    public:
+        /**
+            * @brief Конструктор, запускает поток.
+        */
+        Reactor() {
+#ifdef __linux__
+            epollFd = epoll_create1(0);
+            wakeFd = eventfd(0, EFD_NONBLOCK);
+            epoll_event event = {};
+            event.events = EPOLLIN;
+            event.data.fd = wakeFd;
+            epoll_ctl(epollFd, EPOLL_CTL_ADD, wakeFd, &event);
+#endif
+            lastTick = std::chrono::steady_clock::now();
+            running = true;
+            loopThread = std::thread(&Reactor::Loop, this);
+        }
+
+        /**
+            * @brief Деструктор, останавливает поток. Worker'ы должны быть отключены до удаления.
+        */
+        ~Reactor() {
+            running = false;
+            wake();
+            if (loopThread.joinable()) loopThread.join();
+#ifdef __linux__
+            close(wakeFd);
+            close(epollFd);
+#endif
+        }
+
+        /**
+            * @brief Метод добавления сокета в общий поток.
+            * @param sock Сокет.
+            * @param onReadable Обработчик, вызывается в общем потоке когда в сокете есть данные.
+            * @return 1 - успешно -1 - ошибка регистрации.
+        */
+        int Add(SOCKET sock, std::function<void()> onReadable) {
+            std::lock_guard<std::mutex> guard(lock);
+#ifdef __linux__
+            epoll_event event = {};
+            event.events = EPOLLIN; // level-triggered: недочитанная пачка придет в следующем пробуждении, сокеты обслуживаются по очереди
+            event.data.fd = sock;
+            if (epoll_ctl(epollFd, EPOLL_CTL_ADD, sock, &event) == SOCKET_ERROR) return -1;
+#endif
+            sources.push_back({sock, nextKey++, std::move(onReadable)});
+            wake();
+            return 1;
+        }
+
+        /**
+            * @brief Метод удаления сокета из общего потока. После возврата обработчик сокета больше не вызывается.
+            * Можно вызывать и из обработчиков общего потока.
+            * @param sock Сокет.
+            * @return 1 - успешно -1 - сокет не зарегистрирован.
+        */
+        int Remove(SOCKET sock) {
+            std::unique_lock<std::mutex> guard(lock);
+            auto it = std::find_if(sources.begin(), sources.end(), [sock](const Source& source) { return source.sock == sock; });
+            if (it == sources.end()) return -1;
+#ifdef __linux__
+            epoll_ctl(epollFd, EPOLL_CTL_DEL, sock, nullptr);
+#endif
+            uint64_t key = it->key;
+            sources.erase(it);
+            forget(guard, key);
+            return 1;
+        }
+
+        /**
+            * @brief Метод добавления периодического таймера.
+            * @param period_ms Период в миллисекундах (округляется вверх до шага колеса).
+            * @param onTimer Обработчик, вызывается в общем потоке.
+            * @return id таймера.
+        */
+        int AddTimer(int period_ms, std::function<void()> onTimer) {
+            std::lock_guard<std::mutex> guard(lock);
+            if (timerCount == 0) lastTick = std::chrono::steady_clock::now(); // колесо стояло, не догоняем пропущенные шаги
+            Timer timer;
+            timer.id = nextTimerId++;
+            timer.key = nextKey++;
+            timer.periodTicks = std::max(1, (period_ms + reactor_tick_ms - 1) / reactor_tick_ms);
+            timer.onTimer = std::move(onTimer);
+            schedule(std::move(timer));
+            timerCount++;
+            wake(); // общий поток мог уснуть без таймаута
+            return nextTimerId - 1;
+        }
+
+        /**
+            * @brief Метод удаления таймера. После возврата обработчик таймера больше не вызывается.
+            * @param id id таймера.
+            * @return 1 - успешно -1 - таймер не найден.
+        */
+        int RemoveTimer(int id) {
+            std::unique_lock<std::mutex> guard(lock);
+            for (std::vector<Timer>& slot : wheel) {
+                auto it = std::find_if(slot.begin(), slot.end(), [id](const Timer& timer) { return timer.id == id; });
+                if (it == slot.end()) continue;
+                uint64_t key = it->key;
+                slot.erase(it);
+                timerCount--;
+                forget(guard, key);
+                return 1;
+            }
+            return -1;
+        }
+
+        /**
+            * @brief Метод получения счетчиков общего потока.
+            * @param stats Структура для счетчиков.
+            * @return 1 - успешно.
+        */
+        int GetStats(ReactorStats* stats) {
+            std::lock_guard<std::mutex> guard(lock);
+            stats->wakeups = wakeups;
+            stats->readyEvents = readyEvents;
+            stats->timerFires = timerFires;
+            stats->sources = static_cast<uint32_t>(sources.size());
+            stats->timers = static_cast<uint32_t>(timerCount);
+            return 1;
+        }
+
+    private:
+        /**
+            * Сокет и его обработчик.
+        */
+        struct Source {
+            SOCKET sock;
+            uint64_t key;                       // уникален среди сокетов и таймеров, номер сокета могут выдать повторно
+            std::function<void()> onReadable;
+        };
+
+        /**
+            * Периодический таймер в ячейке колеса.
+        */
+        struct Timer {
+            int id;
+            uint64_t key;
+            int periodTicks;                    // период в шагах колеса
+            int rounds;                         // полных оборотов колеса до срабатывания
+            std::function<void()> onTimer;
+        };
+
+        /**
+            * Обработчик, готовый к вызову в текущем пробуждении, key == 0 - сокет или таймер удален.
+        */
+        struct Ready {
+            uint64_t key;
+            std::function<void()> handler;
+        };
+
+        std::thread loopThread;
+        std::atomic<bool> running{false};
+        std::mutex lock;                        // защищает sources, wheel, ready и счетчики, обработчики вызываются без него
+        std::condition_variable idle;           // обработчик invoking завершился
+        std::vector<Source> sources;
+        std::vector<Ready> ready;               // обработчики текущего пробуждения
+        uint64_t invoking = 0;                  // key вызываемого сейчас обработчика
+        uint64_t nextKey = 1;
+        std::vector<Timer> wheel[reactor_wheel_slots];
+        int wheelPos = 0;                       // ячейка текущего шага
+        int timerCount = 0;
+        int nextTimerId = 0;
+        std::chrono::steady_clock::time_point lastTick; // время обработки ячейки wheelPos
+        uint64_t wakeups = 0;
+        uint64_t readyEvents = 0;
+        uint64_t timerFires = 0;
+#ifdef __linux__
+        int epollFd;
+        int wakeFd;                             // eventfd для пробуждения потока при изменении таймеров и остановке
+#endif
+
+        /**
+            * @brief Метод постановки таймера в ячейку через его период от текущего шага, вызывается под lock.
+        */
+        void schedule(Timer timer) {
+            int slot = (wheelPos + timer.periodTicks) % reactor_wheel_slots;
+            timer.rounds = (timer.periodTicks - 1) / reactor_wheel_slots;
+            wheel[slot].push_back(std::move(timer));
+        }
+
+        /**
+            * @brief Метод пробуждения потока.
+        */
+        void wake() {
+#ifdef __linux__
+            uint64_t one = 1;
+            if (write(wakeFd, &one, sizeof(one)) < 0) return; // счетчик eventfd переполнен, поток и так проснется
+#endif
+        }
+
+        /**
+            * @brief Метод расчета времени сна до ближайшей непустой ячейки колеса, вызывается под lock.
+            * @return миллисекунды, -1 - таймеров нет.
+        */
+        int sleepMs() {
+            if (timerCount == 0) return -1;
+            for (int step = 1; step <= reactor_wheel_slots; step++) {
+                if (wheel[(wheelPos + step) % reactor_wheel_slots].empty()) continue;
+                auto due = lastTick + std::chrono::milliseconds(step * reactor_tick_ms);
+                auto left = std::chrono::ceil<std::chrono::milliseconds>(due - std::chrono::steady_clock::now()).count(); // вниз округлять нельзя, проснемся раньше шага
+                return static_cast<int>(std::max<long long>(0, left));
+            }
+            return reactor_wheel_slots * reactor_tick_ms;
+        }
+
+        /**
+            * @brief Метод снятия обработчика с вызова: вычеркивает его из ready и ждет завершения, если он выполняется
+            * в общем потоке сейчас. Из самого общего потока не ждет - там обработчик уже не выполняется параллельно.
+            * @param guard Захваченный lock.
+            * @param key key сокета или таймера.
+        */
+        void forget(std::unique_lock<std::mutex>& guard, uint64_t key) {
+            for (Ready& entry : ready) {
+                if (entry.key == key) entry.key = 0;
+            }
+            if (std::this_thread::get_id() == loopThread.get_id()) return;
+            idle.wait(guard, [&] { return invoking != key; });
+        }
+
+        /**
+            * @brief Метод вызова обработчиков ready без lock: медленный обработчик не держит Add/Remove других Worker,
+            * а Remove из обработчика не блокируется на самом себе.
+        */
+        void invokeReady() {
+            for (size_t i = 0;; i++) {
+                std::function<void()> handler;
+                {
+                    std::lock_guard<std::mutex> guard(lock);
+                    if (i >= ready.size()) {
+                        ready.clear();
+                        return;
+                    }
+                    if (ready[i].key == 0) continue; // удален после постановки в ready
+                    invoking = ready[i].key;
+                    handler = std::move(ready[i].handler);
+                }
+                handler();
+                {
+                    std::lock_guard<std::mutex> guard(lock);
+                    invoking = 0;
+                }
+                idle.notify_all();
+            }
+        }
+
+        /**
+            * @brief Метод прохода колеса до текущего времени и постановки наступивших таймеров в ready, вызывается под lock.
+        */
+        void advanceTimers() {
+            auto now = std::chrono::steady_clock::now();
+            while (now - lastTick >= std::chrono::milliseconds(reactor_tick_ms)) {
+                lastTick += std::chrono::milliseconds(reactor_tick_ms);
+                wheelPos = (wheelPos + 1) % reactor_wheel_slots;
+                if (wheel[wheelPos].empty()) continue;
+                std::vector<Timer> due;
+                due.swap(wheel[wheelPos]);
+                for (Timer& timer : due) {
+                    if (timer.rounds > 0) { // таймер с периодом больше оборота колеса
+                        timer.rounds--;
+                        wheel[wheelPos].push_back(std::move(timer));
+                        continue;
+                    }
+                    ready.push_back({timer.key, timer.onTimer});
+                    timerFires++;
+                    schedule(std::move(timer));
+                }
+            }
+        }
+
+        /**
+            * @brief Метод общего потока: ожидание данных на всех сокетах и таймеров.
+        */
+        void Loop() {
+            while (running) {
+                int timeout_ms;
+                {
+                    std::lock_guard<std::mutex> guard(lock);
+                    timeout_ms = sleepMs();
+                }
+#ifdef __linux__
+                epoll_event events[reactor_max_events];
+                int count = epoll_wait(epollFd, events, reactor_max_events, timeout_ms);
+                std::unique_lock<std::mutex> guard(lock);
+                wakeups++;
+                for (int i = 0; i < count; i++) {
+                    if (events[i].data.fd == wakeFd) {
+                        uint64_t value;
+                        if (read(wakeFd, &value, sizeof(value)) < 0) continue; // сбрасываем счетчик eventfd
+                        continue;
+                    }
+                    for (Source& source : sources) { // сокет могли удалить пока мы спали
+                        if (source.sock != events[i].data.fd) continue;
+                        readyEvents++;
+                        ready.push_back({source.key, source.onReadable});
+                        break;
+                    }
+                }
+#else
+                // без epoll новые сокеты и таймеры подхватываются не позже чем через listener_poll_us
+                if (timeout_ms < 0 || timeout_ms * us_in_ms > listener_poll_us) timeout_ms = listener_poll_us / us_in_ms;
+                fd_set readSet;
+                FD_ZERO(&readSet);
+                SOCKET maxSock = 0;
+                bool empty;
+                {
+                    std::lock_guard<std::mutex> guard(lock);
+                    for (Source& source : sources) {
+                        FD_SET(source.sock, &readSet);
+                        maxSock = std::max(maxSock, source.sock);
+                    }
+                    empty = sources.empty();
+                }
+                timeval timeout = {timeout_ms / ms_in_sec, (timeout_ms % ms_in_sec) * us_in_ms};
+                int count = data_not_exist;
+                if (empty) {
+                    std::this_thread::sleep_for(std::chrono::milliseconds(timeout_ms)); // select на Windows не принимает пустой набор
+                } else {
+                    count = select(static_cast<int>(maxSock) + 1, &readSet, nullptr, nullptr, &timeout);
+                }
+                std::unique_lock<std::mutex> guard(lock);
+                wakeups++;
+                for (Source& source : sources) {
+                    if (count <= data_not_exist || !FD_ISSET(source.sock, &readSet)) continue;
+                    readyEvents++;
+                    ready.push_back({source.key, source.onReadable});
+                }
+#endif
+                advanceTimers();
+                guard.unlock();
+                invokeReady();
+            }
+        }
+    };
+
+    /**
+        * Сегмент общей памяти с образом процесса PDO/EMCY и журналом принятых пакетов (разметка ShmHeader в can_dll.h).
+        * Worker создает сегмент и пишет в него из потока чтения, другие процессы открывают его только для чтения
+        * и получают данные шины без своего подключения к socat.
+    */
+    class SharedImage {
+    public:
+        /**
+            * @brief Конструктор писателя: создает сегмент. Существующий сегмент с тем же именем удаляется, только если
+            * его писатель закрыл сегмент или завершился, иначе сегмент не создается и Busy() возвращает true.
+            * @param segmentName Имя сегмента ("/can_image" для POSIX).
+            * @param journalRecords Записей журнала (округляется вверх до степени двойки).
+        */
+        SharedImage(const char* segmentName, int journalRecords) : writer(true), name(segmentName) {
+            uint32_t capacity = 1;
+            while (capacity < static_cast<uint32_t>(journalRecords)) capacity <<= 1; // маска вместо деления по модулю
+            uint64_t slotsOffset = (sizeof(ShmHeader) + cache_line_size - 1) / cache_line_size * cache_line_size;
+            uint64_t journalOffset = slotsOffset + static_cast<uint64_t>(image_slots) * sizeof(ShmSlot);
+            size = journalOffset + static_cast<uint64_t>(capacity) * sizeof(ShmRecord);
+            if (!map()) return;
+
+            // новый сегмент заполнен нулями, заголовок заполняем до сигнатуры, чтобы читатель не увидел его наполовину
+            header->version = shm_version;
+            header->headerSize = sizeof(ShmHeader);
+            header->slotCount = image_slots;
+            header->slotSize = sizeof(ShmSlot);
+            header->journalCapacity = capacity;
+            header->recordSize = sizeof(ShmRecord);
+            header->slotsOffset = slotsOffset;
+            header->journalOffset = journalOffset;
+            header->created_ns = steadyNs();
+#ifdef _WIN32
+            header->writerPid = GetCurrentProcessId();
+#else
+            header->writerPid = static_cast<uint32_t>(getpid());
+#endif
+            attach();
+            for (int i = 0; i < image_slots; i++) slots[i].cobid = static_cast<uint16_t>(slotCobid(i));
+            std::atomic_thread_fence(std::memory_order_release);
+            std::memcpy(header->magic, shm_magic, sizeof(header->magic));
+        }
+
+        /**
+            * @brief Конструктор читателя: открывает существующий сегмент только для чтения.
+            * Журнал читается с момента открытия.
+            * @param segmentName Имя сегмента.
+        */
+        explicit SharedImage(const char* segmentName) : writer(false), name(segmentName) {
+            if (!map()) return;
+            std::atomic_thread_fence(std::memory_order_acquire);
+            if (std::memcmp(header->magic, shm_magic, sizeof(header->magic)) != 0 || header->version != shm_version ||
+                header->headerSize != sizeof(ShmHeader) || header->slotCount != static_cast<uint32_t>(image_slots) ||
+                header->slotSize != sizeof(ShmSlot) || header->recordSize != sizeof(ShmRecord) ||
+                header->slotsOffset < sizeof(ShmHeader) || header->slotsOffset % alignof(ShmSlot) != 0 ||
+                header->slotsOffset > size || static_cast<uint64_t>(image_slots) * sizeof(ShmSlot) > size - header->slotsOffset ||
+                header->journalCapacity == 0 || (header->journalCapacity & (header->journalCapacity - 1)) != 0 || // используется как маска
+                header->journalOffset < sizeof(ShmHeader) || header->journalOffset % alignof(ShmRecord) != 0 ||
+                header->journalOffset > size || static_cast<uint64_t>(header->journalCapacity) * sizeof(ShmRecord) > size - header->journalOffset) {
+                unmap(); // чужой сегмент, другая версия dll или писатель еще не заполнил заголовок
+                return;
+            }
+            attach();
+            cursor = sharedField(header->journalHead).load(std::memory_order_acquire);
+        }
+
+        /**
+            * @brief Деструктор: писатель помечает сегмент закрытым и удаляет имя, если оно еще указывает на его сегмент.
+            * Уже открытые читатели дочитывают свое отображение.
+        */
+        ~SharedImage() {
+            if (header == nullptr) return;
+            if (writer) sharedField(header->closed).store(1, std::memory_order_release);
+            unmap();
+#ifndef _WIN32
+            if (writer && ownsName()) shm_unlink(name.c_str());
+#endif
+        }
+
+        /**
+            * @brief Метод проверки, что сегмент отображен.
+        */
+        bool IsOpen() {
+            return header != nullptr;
+        }
+
+        /**
+            * @brief Метод проверки, что писатель не создал сегмент, потому что имя занято работающим писателем.
+        */
+        bool Busy() {
+            return busy;
+        }
+
+        /**
+            * @brief Метод записи пакета в слот образа процесса (писатель seqlock, вызывается потоком чтения Worker).
+            * @param index Номер слота (как у образа процесса Worker).
+            * @param payload Payload пакета.
+            * @param len Количество значимых байт.
+            * @param timestamp_ns Время приема.
+        */
+        void WriteSlot(int index, uint64_t payload, uint8_t len, uint64_t timestamp_ns) {
+            ShmSlot& slot = slots[index];
+            seqlockWrite(sharedField(slot.seq), [&] {
+                sharedPayload(slot.data).store(payload, std::memory_order_relaxed);
+                sharedField(slot.len).store(len, std::memory_order_relaxed);
+                sharedField(slot.timestamp_ns).store(timestamp_ns, std::memory_order_relaxed);
+                sharedField(slot.updates).store(sharedField(slot.updates).load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+            });
+        }
+
+        /**
+            * @brief Метод добавления пакета в журнал (вызывается потоком чтения Worker). Старые записи перезаписываются.
+            * @param cobid cobid пакета.
+            * @param payload Payload пакета.
+            * @param len Количество значимых байт.
+            * @param timestamp_ns Время приема.
+        */
+        void Append(int cobid, uint64_t payload, uint8_t len, uint64_t timestamp_ns) {
+            ShmRecord& record = journal[journalCount & journalMask];
+            sharedField(record.seq).store(0, std::memory_order_relaxed); // запись идет
+            std::atomic_thread_fence(std::memory_order_release);
+            sharedField(record.timestamp_ns).store(timestamp_ns, std::memory_order_relaxed);
+            sharedField(record.cobid).store(static_cast<uint16_t>(cobid), std::memory_order_relaxed);
+            sharedField(record.len).store(len, std::memory_order_relaxed);
+            sharedPayload(record.data).store(payload, std::memory_order_relaxed);
+            journalCount++;
+            sharedField(record.seq).store(journalCount, std::memory_order_release);
+            sharedField(header->journalHead).store(journalCount, std::memory_order_release); // публикуем запись читателям
+        }
+
+        /**
+            * @brief Метод согласованного чтения одного cobid из образа процесса.
+            * @param cobid cobid PDO или EMCY.
+            * @param entry Структура для состояния cobid.
+            * @return 1 - успешно -2 - cobid вне образа процесса -3 - слот занят записью слишком долго (писатель завершился во время записи).
+        */
+        int ReadEntry(int cobid, ProcessImageEntry* entry) {
+            int index = slotIndex(cobid);
+            if (index < 0) return -2;
+            return readSlot(slots[index], entry) ? 1 : -3;
+        }
+
+        /**
+            * @brief Метод копирования образа процесса: только cobid, от которых был принят хотя бы один пакет, по возрастанию cobid.
+            * @param out Массив для записей.
+            * @param max Размер массива в записях.
+            * @return количество скопированных записей.
+        */
+        int Snapshot(ProcessImageEntry* out, int max) {
+            int count = 0;
+            for (int cobid = min_cobid_error; cobid <= max_cobid_pdo && count < max; cobid++) {
+                int index = slotIndex(cobid);
+                if (index < 0 || sharedField(slots[index].updates).load(std::memory_order_relaxed) == 0) continue;
+                if (readSlot(slots[index], &out[count])) count++;
+            }
+            return count;
+        }
+
+        /**
+            * @brief Метод чтения новых записей журнала с прошлого вызова.
+            * @param out Массив для записей.
+            * @param max Размер массива в записях.
+            * @param lost Записей, перезаписанных писателем до чтения (может быть nullptr).
+            * @return количество прочитанных записей.
+        */
+        int ReadJournal(PdoRecord* out, int max, uint64_t* lost) {
+            uint64_t head = sharedField(header->journalHead).load(std::memory_order_acquire);
+            uint64_t overwritten = 0;
+            if (head - cursor > journalMask + 1) { // читатель отстал больше чем на журнал
+                overwritten = head - cursor - (journalMask + 1);
+                cursor = head - (journalMask + 1);
+            }
+            int count = 0;
+            while (cursor < head && count < max) {
+                ShmRecord& record = journal[cursor & journalMask];
+                uint64_t before = sharedField(record.seq).load(std::memory_order_acquire);
+                PdoRecord& result = out[count];
+                result.timestamp_ns = sharedField(record.timestamp_ns).load(std::memory_order_relaxed);
+                result.cobid = sharedField(record.cobid).load(std::memory_order_relaxed);
+                result.len = sharedField(record.len).load(std::memory_order_relaxed);
+                uint64_t payload = sharedPayload(record.data).load(std::memory_order_relaxed);
+                std::atomic_thread_fence(std::memory_order_acquire);
+                cursor++;
+                if (before != cursor || sharedField(record.seq).load(std::memory_order_relaxed) != before) { // писатель обогнал читателя
+                    overwritten++;
+                    continue;
+                }
+                std::memset(result.reserved, 0, sizeof(result.reserved));
+                std::memcpy(result.data, &payload, sizeof(payload));
+                count++;
+            }
+            if (lost != nullptr) *lost = overwritten;
+            return count;
+        }
+
+        /**
+            * @brief Метод проверки, что писатель закрыл сегмент.
+            * @return 1 - закрыт 0 - писатель работает.
+        */
+        int Closed() {
+            return static_cast<int>(sharedField(header->closed).load(std::memory_order_acquire));
+        }
+
+        /**
+            * @brief Метод номера слота cobid (слоты PDO min_cobid_pdo..max_cobid_pdo, затем EMCY min_cobid_error..max_cobid_error).
+            * @return номер слота -1 - cobid вне образа процесса.
+        */
+        static int slotIndex(int cobid) {
+            if (cobid >= min_cobid_pdo && cobid <= max_cobid_pdo) return cobid - min_cobid_pdo;
+            if (cobid >= min_cobid_error && cobid <= max_cobid_error) return image_pdo_slots + cobid - min_cobid_error;
+            return -1;
+        }
+
+    private:
+        bool writer;
+        std::string name;
+        uint64_t size = 0;
+        ShmHeader* header = nullptr;
+        ShmSlot* slots = nullptr;
+        ShmRecord* journal = nullptr;
+        uint64_t journalMask = 0;
+        uint64_t journalCount = 0;  // записей журнала, пишет только писатель
+        uint64_t cursor = 0;        // следующая запись журнала читателя
+        bool busy = false;          // имя занято работающим писателем
+#ifdef _WIN32
+        HANDLE mapping = nullptr;
+#else
+        dev_t device = 0;           // устройство и inode созданного писателем сегмента
+        ino_t inode = 0;
+#endif
+
+        /**
+            * @brief Метод cobid слота по номеру.
+        */
+        static int slotCobid(int index) {
+            return index < image_pdo_slots ? min_cobid_pdo + index : min_cobid_error + index - image_pdo_slots;
+        }
+
+        /**
+            * @brief Метод вычисления указателей на слоты и журнал по заголовку.
+        */
+        void attach() {
+            unsigned char* base = reinterpret_cast<unsigned char*>(header);
+            slots = reinterpret_cast<ShmSlot*>(base + header->slotsOffset);
+            journal = reinterpret_cast<ShmRecord*>(base + header->journalOffset);
+            journalMask = header->journalCapacity - 1;
+        }
+
+        /**
+            * @brief Метод согласованного чтения слота (читатель seqlock) с ограничением ожидания.
+            * @return true - прочитано false - слот все время занят записью.
+        */
+        bool readSlot(ShmSlot& slot, ProcessImageEntry* entry) {
+            uint64_t payload = 0;
+            bool consistent = seqlockRead(sharedField(slot.seq), [&] {
+                payload = sharedPayload(slot.data).load(std::memory_order_relaxed);
+                entry->len = sharedField(slot.len).load(std::memory_order_relaxed);
+                entry->updates = sharedField(slot.updates).load(std::memory_order_relaxed);
+                entry->timestamp_ns = sharedField(slot.timestamp_ns).load(std::memory_order_relaxed);
+            }, shm_read_attempts);
+            if (!consistent) return false;
+            std::memcpy(entry->data, &payload, sizeof(payload));
+            entry->cobid = slot.cobid;
+            entry->reserved = 0;
+            return true;
+        }
+
+        /**
+            * @brief Метод отображения сегмента: писатель создает его размером size, читатель открывает только для чтения.
+            * @return true - отображен.
+        */
+        bool map() {
+#ifdef _WIN32
+            if (writer) {
+                mapping = CreateFileMappingA(INVALID_HANDLE_VALUE, nullptr, PAGE_READWRITE, static_cast<DWORD>(size >> 32), static_cast<DWORD>(size), name.c_str());
+                if (mapping != nullptr && GetLastError() == ERROR_ALREADY_EXISTS) { // сегмент жив, пока его держит писатель или читатель
+                    CloseHandle(mapping);
+                    mapping = nullptr;
+                    busy = true;
+                    return false;
+                }
+            } else {
+                mapping = OpenFileMappingA(FILE_MAP_READ, FALSE, name.c_str());
+            }
+            if (mapping == nullptr) return false;
+            void* view = MapViewOfFile(mapping, writer ? FILE_MAP_ALL_ACCESS : FILE_MAP_READ, 0, 0, writer ? size : 0);
+            if (view == nullptr) {
+                CloseHandle(mapping);
+                mapping = nullptr;
+                return false;
+            }
+            if (!writer) {
+                MEMORY_BASIC_INFORMATION info;
+                size = VirtualQuery(view, &info, sizeof(info)) ? info.RegionSize : 0;
+            }
+#else
+            int fd;
+            if (writer) {
+                fd = shm_open(name.c_str(), O_CREAT | O_EXCL | O_RDWR, S_IRUSR | S_IWUSR | S_IRGRP | S_IROTH);
+                if (fd < 0 && errno == EEXIST) {
+                    if (!staleSegment()) {
+                        busy = true;
+                        return false;
+                    }
+                    shm_unlink(name.c_str()); // сегмент закрытого или завершившегося без закрытия писателя
+                    fd = shm_open(name.c_str(), O_CREAT | O_EXCL | O_RDWR, S_IRUSR | S_IWUSR | S_IRGRP | S_IROTH);
+                    busy = fd < 0 && errno == EEXIST; // другой писатель успел создать сегмент
+                }
+                if (fd < 0) return false;
+                struct stat info;
+                if (fstat(fd, &info) != 0 || ftruncate(fd, static_cast<off_t>(size)) != 0) {
+                    close(fd);
+                    shm_unlink(name.c_str());
+                    return false;
+                }
+                device = info.st_dev;
+                inode = info.st_ino;
+            } else {
+                fd = shm_open(name.c_str(), O_RDONLY, 0);
+                if (fd < 0) return false;
+                struct stat info;
+                if (fstat(fd, &info) != 0 || static_cast<uint64_t>(info.st_size) < sizeof(ShmHeader)) {
+                    close(fd);
+                    return false;
+                }
+                size = static_cast<uint64_t>(info.st_size);
+            }
+            void* view = mmap(nullptr, size, writer ? PROT_READ | PROT_WRITE : PROT_READ, MAP_SHARED, fd, 0);
+            close(fd); // отображение держит сегмент само
+            if (view == MAP_FAILED) {
+                if (writer) shm_unlink(name.c_str());
+                return false;
+            }
+#endif
+            header = reinterpret_cast<ShmHeader*>(view);
+            return true;
+        }
+
+#ifndef _WIN32
+        /**
+            * @brief Метод проверки, что существующий сегмент с нашим именем брошен: писатель закрыл его или завершился.
+            * Сегмент без заголовка (чужой или писатель еще заполняет его) считается занятым.
+            * @return true - сегмент можно удалить.
+        */
+        bool staleSegment() {
+            int fd = shm_open(name.c_str(), O_RDONLY, 0);
+            if (fd < 0) return errno == ENOENT; // уже удален
+            struct stat info;
+            void* view = MAP_FAILED;
+            if (fstat(fd, &info) == 0 && static_cast<uint64_t>(info.st_size) >= sizeof(ShmHeader)) {
+                view = mmap(nullptr, sizeof(ShmHeader), PROT_READ, MAP_SHARED, fd, 0);
+            }
+            close(fd);
+            if (view == MAP_FAILED) return false;
+            ShmHeader* existing = reinterpret_cast<ShmHeader*>(view);
+            bool stale = sharedField(existing->closed).load(std::memory_order_acquire) != 0;
+            pid_t pid = static_cast<pid_t>(sharedField(existing->writerPid).load(std::memory_order_relaxed));
+            if (!stale && pid > 0) stale = kill(pid, 0) != 0 && errno == ESRCH;
+            munmap(view, sizeof(ShmHeader));
+            return stale;
+        }
+
+        /**
+            * @brief Метод проверки, что имя сегмента указывает на созданный писателем сегмент, а не на сегмент нового писателя.
+        */
+        bool ownsName() {
+            int fd = shm_open(name.c_str(), O_RDONLY, 0);
+            if (fd < 0) return false;
+            struct stat info;
+            bool own = fstat(fd, &info) == 0 && info.st_dev == device && info.st_ino == inode;
+            close(fd);
+            return own;
+        }
+#endif
+
+        /**
+            * @brief Метод снятия отображения сегмента.
+        */
+        void unmap() {
+#ifdef _WIN32
+            UnmapViewOfFile(header);
+            CloseHandle(mapping);
+            mapping = nullptr;
+#else
+            munmap(header, size);
+#endif
+            header = nullptr;
+        }
+    };
+
     class Worker {
     public:
         /**
             * @brief Конструктор класса.
         */
         Worker():callback_pdo(nullptr),callback_error(nullptr), udpSocket(INVALID_SOCKET), isConnected(false) { 
+            std::fill(pdoPlanIndex, pdoPlanIndex + max_cobid + 1, no_pdo_mapping);
+            for (int c = 0; c < tx_class_count; c++) txOrder[c] = c; // порядок арбитража CAN: nmt/sync, emcy, pdo, sdo, heartbeat
+            for (int cobid = 0; cobid <= max_cobid; cobid++) {
+                routeMode[cobid].store(defaultRoute(cobid), std::memory_order_relaxed);
+                routeCallback[cobid].store(nullptr, std::memory_order_relaxed);
+                frameClassTable[cobid] = static_cast<uint8_t>(frameClass(cobid));
+                txClassTable[cobid] = static_cast<uint8_t>(txClass(cobid));
+            }
         } // конструктор
 
 
@@ -32,11 +926,17 @@ extern "C" {
             * @brief Деконструктор класса.
         */
         ~Worker() { // деконструктор 
+            if (capturing) StopCapture(); // фоновый поток записи должен завершиться до удаления буферов
+            if (cyclicRunning) StopCyclic(); // поток отправки обращается к сокету
+            stopTxSender(); // поток отправки обращается к сокету
+            stopCallbackExecutor(); // потоки callback'ов обращаются к образу процесса
             if (isConnected) {
                 closesocket(udpSocket);
                 WSACleanup();
                 isConnected = false;
             }
+            if (readThread.joinable()) readThread.join(); // поток чтения пишет в общую память
+            delete sharedImage;
         }
 
         /**
@@ -98,12 +998,16 @@ extern "C" {
             }
 
             // таймаут ожидания первого пакета от socat 
-            DWORD timeout = 2000; 
+#ifdef _WIN32
+            DWORD timeout = connect_timeout_ms; 
+#else
+            timeval timeout = {connect_timeout_ms / ms_in_sec, (connect_timeout_ms % ms_in_sec) * us_in_ms};
+#endif
             setsockopt(udpSocket, SOL_SOCKET, SO_RCVTIMEO, (const char*)&timeout, sizeof(timeout));
 
             
             char recvBuffer[16]; // буфер для получения ответа от сервера
-            int serverAddrSize = sizeof(serverAddr);
+            socklen_t serverAddrSize = sizeof(serverAddr);
 
             // проверяем что связь действительно установлена и к нам пошли пакеты 
             int recvResult = recvfrom(udpSocket, recvBuffer, sizeof(recvBuffer), 0, (sockaddr*)&serverAddr, &serverAddrSize);
@@ -114,11 +1018,50 @@ extern "C" {
             }
 
             // создаем поток прослушивания сокета если не возникло ошибок с установлением связи 
-            isConnected = true;
-            readThread = std::thread(&Worker::PacketListener, this);
-            //heartbeatThread = std::thread(&Worker::Sending_heartbeat, this);
-            
+            transport = transport_udp;
+            if (startListening() < 0) return -3;
+            return 1;
+        }
+
+        /**
+            * @brief Метод подключения напрямую к CAN интерфейсу через SocketCAN (CAN_RAW) вместо socat.
+            * Создает сокет сам, CreateSocket не нужен. Формат can_frame совпадает с пакетами socat, поэтому
+            * весь остальной API (SDO/PDO/heartbeat) работает без изменений.
+            * @param interfaceName Имя интерфейса (например "can0" или "vcan0").
+            * @return 1 - успешно -1 - уже подключены -2 - SocketCAN недоступен -3 - интерфейс не найден -4 - ошибка привязки к интерфейсу.
+        */
+        int ConnectToCANInterface(const char* interfaceName) {
+            if (isConnected) return -1;
+#ifdef __linux__
+            if (udpSocket != INVALID_SOCKET) closesocket(udpSocket); // сокет от CreateSocket не нужен
+            udpSocket = socket(PF_CAN, SOCK_RAW, CAN_RAW);
+            if (udpSocket == INVALID_SOCKET) return -2;
+
+            unsigned int interfaceIndex = if_nametoindex(interfaceName);
+            if (interfaceIndex == 0) {
+                closesocket(udpSocket);
+                udpSocket = INVALID_SOCKET;
+                return -3;
+            }
+
+            applyKernelFilter(); // ядро отдает только те cobid, у которых в таблице есть маршрут
+
+            sockaddr_can canAddr = {};
+            canAddr.can_family = AF_CAN;
+            canAddr.can_ifindex = static_cast<int>(interfaceIndex);
+            if (bind(udpSocket, (sockaddr*)&canAddr, sizeof(canAddr)) == SOCKET_ERROR) {
+                closesocket(udpSocket);
+                udpSocket = INVALID_SOCKET;
+                return -4;
+            }
+
+            transport = transport_socketcan;
+            if (startListening() < 0) return -4;
             return 1;
+#else
+            (void)interfaceName;
+            return -2;
+#endif
         }
 
         /**
@@ -129,31 +1072,12 @@ extern "C" {
             * @param data Массив данных для записи в SDO объект.
             * @param dataSize Размер данных для записи в SDO объект.
             * @param timeout_ms Таймаут ожидания ответа в миллисекундах.
-            * @return 1 - успешно -1 - не подключены -2 - ошибка записи -4 нет ответа.
+            * @return 1 - успешно -1 - не подключены -2 - ошибка записи -3 - к узлу уже есть незавершенный запрос -4 нет ответа -5 - узел прервал передачу.
         */
         int WriteSDO(int receiverId, int index, int subIndex, const unsigned char* data, int dataSize, int timeout_ms = 1000) {
-            if (!isConnected) return -1;// мы все еще подключены
-
-            // формируем SDO пакет для записи 
-            unsigned char sdoPacket[udp_len_package] = {empty_data}; // массив байт для формирования пакетов 
-
-            makeSDOhead(sdoPacket, true, receiverId, index, subIndex, dataSize); //формируем запрос
-
-            std::memcpy(&sdoPacket[first_byte_data_sdo_w], data, dataSize); // записываем данные в пакет SDO
-
-            int sendResult = sendto(udpSocket, (char*)sdoPacket, sizeof(sdoPacket), 0, (sockaddr*)&serverAddr, sizeof(serverAddr)); // отправляем наш пакет
-            if (sendResult == SOCKET_ERROR) return -2; // не смогли отправить
-
-            // таймер реализованный через тики, chrono ругается
-            DWORD start = GetTickCount(); //записываем количество тиков на старте
-            while (true) { // обращаемся в общему буферу чтения и проверяем что нам пришел ответ на наш запрос
-                if (verifySDO(readBuffer_sdo_w, receiverId, index, subIndex) == succes_verify) { // проверяем что пришел ответ на наш запрос
-
-                        memset(readBuffer_sdo_w, empty_data, sizeof(readBuffer_sdo_w)); // очищаем буфер ответов записи чтобы не путаться если отправим такой же запрос
-                        return 1;
-                    }
-                if (timeout_SDO_answer(start, timeout_ms)) return -4; //не нашли пакет в течении таймаута
-            }
+            int submitResult = SubmitSDO(true, receiverId, index, subIndex, data, dataSize); // отправляем запрос и занимаем слот узла
+            if (submitResult < 0) return submitResult;
+            return CompleteSDO(receiverId, nullptr, timeout_ms); // ждем ответ в слоте узла
         }
 
         /**
@@ -163,33 +1087,295 @@ extern "C" {
             * @param subIndex Сабиндекс SDO объекта.
             * @param outBuffer Массив для хранения данных, полученных из SDO объекта (передаем количество значимых байт и данные в пакете).
             * @param timeout_ms Таймаут ожидания ответа в миллисекундах.
-            * @return 1 - успешно -1 - не подключены -2 - ошибка записи -4 нет ответа.
+            * @return 1 - успешно -1 - не подключены -2 - ошибка записи -3 - к узлу уже есть незавершенный запрос -4 нет ответа -5 - узел прервал передачу -6 - узел ответил не expedited пакетом.
         */
         int ReadSDO(int receiverId, int index, int subIndex, unsigned char* outBuffer, int timeout_ms = 1000) {
-            if (!isConnected) return -1; //мы всё еще подключены
+            if (sdoCacheEnabled.load(std::memory_order_relaxed) && isConnected && cacheLookup(receiverId, index, subIndex, outBuffer)) return 1; // ответ из кэша
+            int submitResult = SubmitSDO(false, receiverId, index, subIndex, nullptr, zero_len); // отправляем запрос и занимаем слот узла
+            if (submitResult < 0) return submitResult;
+            return CompleteSDO(receiverId, outBuffer, timeout_ms); // ждем ответ в слоте узла, кэш обновляется при освобождении слота
+        }
+
+        /**
+            * @brief Метод асинхронной отправки SDO запроса без ожидания ответа.
+            * К каждому узлу может быть отправлен только один запрос, запросы к разным узлам выполняются одновременно.
+            * @param write Флаг чтения или записи.
+            * @param receiverId ID узла назначения.
+            * @param index Индекс SDO объекта.
+            * @param subIndex Сабиндекс SDO объекта.
+            * @param data Массив данных для записи в SDO объект (используется только для записи).
+            * @param dataSize Размер данных для записи в SDO объект (используется только для записи).
+            * @return 1 - успешно -1 - не подключены -2 - ошибка записи -3 - к узлу уже есть незавершенный запрос или неверный id узла.
+        */
+        int SubmitSDO(bool write, int receiverId, int index, int subIndex, const unsigned char* data, int dataSize) {
+            if (!isConnected) return -1; // мы все еще подключены
+            if (receiverId < min_node_id || receiverId > max_node_id) return -3; // id вне диапазона canopen
+            if (write && (dataSize <= zero_len || dataSize > max_count_byte_payload)) return -2; // не поместится в expedited пакет
 
-            unsigned char sdoPacket[udp_len_package] = {empty_data}; //пакет для отправки запроса
+            unsigned char sdoPacket[udp_len_package] = {empty_data}; // массив байт для формирования пакетов
 
-            makeSDOhead(sdoPacket, false, receiverId, index, subIndex, zero_len); //формируем запрос
+            makeSDOhead(sdoPacket, write, receiverId, index, subIndex, dataSize); //формируем запрос
+            if (write) {
+                std::memcpy(&sdoPacket[first_byte_data_sdo_w], data, dataSize); // записываем данные в пакет SDO
+            }
 
-            // отправляем
-            int sendResult = sendto(udpSocket, (char*)sdoPacket, sizeof(sdoPacket), 0, (sockaddr*)&serverAddr, sizeof(serverAddr)); // отправляем наш пакет
-            if (sendResult == SOCKET_ERROR) return -2;// не смогли отправить
+            return startTransfer(receiverId, sdoPacket, [&](SdoTransfer& transfer) {
+                transfer.mode = sdo_mode_expedited;
+                transfer.write = write;
+                transfer.index = index;
+                transfer.subIndex = subIndex;
+                transfer.writtenSize = write ? dataSize : zero_len;
+                if (write) std::memcpy(transfer.written, data, dataSize); // для кэша SDO при завершении
+            });
+        }
 
-            //запускаем таймер ожидания ответа
-            DWORD start = GetTickCount();
-            while (true) { //проверяем что пришел ответ на наш запрос
-                if (verifySDO(readBuffer_sdo_r, receiverId, index, subIndex) == succes_verify) { // проверяем что пришел ответ на наш запрос 
+        /**
+            * @brief Метод ожидания ответа на запрос, отправленный через SubmitSDO.
+            * @param receiverId ID узла назначения.
+            * @param outBuffer Массив для данных ответа на чтение (количество значимых байт и данные), для записи может быть nullptr.
+            * @param timeout_ms Таймаут ожидания ответа в миллисекундах, 0 - только проверить наличие ответа.
+            * @return 1 - успешно 0 - ответа еще нет (только для timeout_ms = 0) -1 - не подключены -3 - нет отправленного запроса -4 нет ответа -5 - узел прервал передачу -6 - узел ответил не expedited пакетом.
+        */
+        int CompleteSDO(int receiverId, unsigned char* outBuffer, int timeout_ms) {
+            if (!isConnected) return -1; // мы все еще подключены
+            if (receiverId < min_node_id || receiverId > max_node_id) return -3; // id вне диапазона canopen
 
-                    outBuffer[num_byte_len_payload_sdo_r] = readBuffer_sdo_r[num_byte_len_payload_sdo]; // записываем количество значимых байт для преобразования
-                    std::copy(readBuffer_sdo_r + first_byte_sdo_read_r, readBuffer_sdo_r + last_byte_sdo_read_r, outBuffer + distination_byte_sdo_read_r); //записываем дату в выходной массив
-                    memset(readBuffer_sdo_r, empty_data, sizeof(readBuffer_sdo_r)); // очищаем буфер ответов чтения чтобы не путаться если отправим такой же запрос
-                    return 1;
-                    }
-                if (timeout_SDO_answer(start, timeout_ms)) return -4; // не нашли пакет в течении таймаута
+            auto deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(timeout_ms);
+
+            std::unique_lock<std::mutex> lock(sdoMutex);
+            SdoTransfer& transfer = sdoTable[receiverId];
+            if (!transfer.active) return -3; // ничего не ждем от этого узла
+            if (!transfer.done) {
+                if (timeout_ms <= zero_len) return sdo_pending; // режим опроса, слот не трогаем
+                // спим, пока поток чтения не положит ответ в слот или запрос не отменят
+                if (!transfer.answered.wait_until(lock, deadline, [&transfer] { return transfer.done || !transfer.active; })) {
+                    releaseSDO(transfer); // опоздавший ответ будет отброшен
+                    sdoTimeouts.fetch_add(1, std::memory_order_relaxed);
+                    return -4; //не нашли пакет в течении таймаута
+                }
+                if (!transfer.active) return -3; // запрос отменили пока ждали
+            }
+            if (transfer.answered_ns != 0) traceSdoWake(transfer);
+
+            if (transfer.result < 0) { // узел прервал передачу
+                int result = transfer.result;
+                releaseSDO(transfer);
+                return result;
             }
+            if (!transfer.write && outBuffer != nullptr) {
+                outBuffer[num_byte_len_payload_sdo_r] = transfer.answer[num_byte_len_payload_sdo]; // записываем количество значимых байт для преобразования
+                std::copy(transfer.answer + first_byte_sdo_read_r, transfer.answer + last_byte_sdo_read_r, outBuffer + distination_byte_sdo_read_r); //записываем дату в выходной массив
+            }
+            releaseSDO(transfer); // освобождаем слот для следующего запроса
+            return 1;
         }
-        
+
+        /**
+            * @brief Метод чтения SDO объекта любого размера сегментированной или блочной передачей.
+            * Данные пишутся потоком чтения прямо в буфер вызывающего.
+            * @param receiverId ID узла назначения.
+            * @param index Индекс SDO объекта.
+            * @param subIndex Сабиндекс SDO объекта.
+            * @param buffer Буфер для данных объекта.
+            * @param capacity Размер буфера.
+            * @param block true - блочная передача, false - сегментированная.
+            * @param timeout_ms Таймаут ожидания очередного пакета от узла в миллисекундах.
+            * @return количество прочитанных байт -1 - не подключены -2 - ошибка записи -3 - к узлу уже есть незавершенный запрос -4 нет ответа
+            * -5 - узел прервал передачу -6 - ошибка протокола -7 - объект не помещается в буфер -8 - ошибка crc.
+        */
+        int UploadSDO(int receiverId, int index, int subIndex, unsigned char* buffer, int capacity, bool block, int timeout_ms) {
+            if (!isConnected) return -1;
+            if (receiverId < min_node_id || receiverId > max_node_id) return -3;
+            if (buffer == nullptr || capacity < zero_len) return -7;
+
+            unsigned char sdoPacket[udp_len_package] = {empty_data};
+            makeSDOhead(sdoPacket, false, receiverId, index, subIndex, zero_len); // запрос чтения 0x40
+            if (block) {
+                sdoPacket[num_sdo_command] = sdo_block_upload_initiate;
+                sdoPacket[num_byte_block_size_initiate] = static_cast<unsigned char>(sdoBlockSize);
+            }
+
+            int startResult = startTransfer(receiverId, sdoPacket, [&](SdoTransfer& transfer) {
+                transfer.mode = block ? sdo_mode_block : sdo_mode_segmented;
+                transfer.write = false;
+                transfer.index = index;
+                transfer.subIndex = subIndex;
+                transfer.buffer = buffer;
+                transfer.size = static_cast<uint32_t>(capacity);
+                transfer.blockSize = static_cast<uint8_t>(sdoBlockSize);
+            });
+            if (startResult < 0) return startResult;
+            return waitTransfer(receiverId, timeout_ms);
+        }
+
+        /**
+            * @brief Метод записи SDO объекта любого размера сегментированной или блочной передачей.
+            * Данные до 4 байт без блочной передачи уходят одним expedited пакетом.
+            * @param receiverId ID узла назначения.
+            * @param index Индекс SDO объекта.
+            * @param subIndex Сабиндекс SDO объекта.
+            * @param data Данные объекта, должны жить до конца передачи.
+            * @param size Размер данных.
+            * @param block true - блочная передача, false - сегментированная.
+            * @param timeout_ms Таймаут ожидания очередного пакета от узла в миллисекундах.
+            * @return 1 - успешно -1 - не подключены -2 - ошибка записи -3 - к узлу уже есть незавершенный запрос -4 нет ответа
+            * -5 - узел прервал передачу -6 - ошибка протокола.
+        */
+        int DownloadSDO(int receiverId, int index, int subIndex, const unsigned char* data, int size, bool block, int timeout_ms) {
+            if (!isConnected) return -1;
+            if (receiverId < min_node_id || receiverId > max_node_id) return -3;
+            if (data == nullptr || size <= zero_len) return -2;
+            if (!block && size <= max_count_byte_payload) return WriteSDO(receiverId, index, subIndex, data, size, timeout_ms);
+
+            unsigned char sdoPacket[udp_len_package] = {empty_data};
+            makeSDOhead(sdoPacket, false, receiverId, index, subIndex, zero_len);
+            sdoPacket[num_sdo_command] = block ? sdo_block_download_initiate : sdo_ccs_download_segmented;
+            storeLE32(sdoPacket + first_byte_data_sdo_w, static_cast<uint32_t>(size)); // размер объекта
+
+            int startResult = startTransfer(receiverId, sdoPacket, [&](SdoTransfer& transfer) {
+                transfer.mode = block ? sdo_mode_block : sdo_mode_segmented;
+                transfer.write = true;
+                transfer.index = index;
+                transfer.subIndex = subIndex;
+                transfer.source = data;
+                transfer.size = static_cast<uint32_t>(size);
+                transfer.total = static_cast<uint32_t>(size);
+            });
+            if (startResult < 0) return startResult;
+            return waitTransfer(receiverId, timeout_ms);
+        }
+
+        /**
+            * @brief Метод настройки количества сегментов в блоке блочного чтения.
+            * @param blockSize Количество сегментов 1..127.
+            * @return 1 - успешно -2 - неверный размер.
+        */
+        int SetSDOBlockSize(int blockSize) {
+            if (blockSize < 1 || blockSize > max_sdo_block_size) return -2;
+            sdoBlockSize = blockSize;
+            return 1;
+        }
+
+        /**
+            * @brief Метод получения хода текущей или последней многокадровой передачи узла.
+            * @param receiverId ID узла.
+            * @param progress Структура для хода передачи.
+            * @return 1 - успешно -3 - неверный id узла.
+        */
+        int GetSDOProgress(int receiverId, SdoProgress* progress) {
+            if (receiverId < min_node_id || receiverId > max_node_id) return -3;
+            std::lock_guard<std::mutex> lock(sdoMutex);
+            SdoTransfer& transfer = sdoTable[receiverId];
+            bool running = transfer.active && !transfer.done;
+            progress->transferred = std::min(transfer.offset, transfer.size); // хвост последнего сегмента блока не считаем
+            progress->total = transfer.total;
+            progress->elapsed_ns = running ? std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - transfer.started).count() : transfer.elapsed_ns;
+            progress->abortCode = transfer.abortCode;
+            progress->active = running ? 1 : 0;
+            return 1;
+        }
+
+        /**
+            * @brief Метод отмены незавершенного SDO запроса к узлу.
+            * @param receiverId ID узла назначения.
+            * @return 1 - успешно -3 - неверный id узла.
+        */
+        int CancelSDO(int receiverId) {
+            if (receiverId < min_node_id || receiverId > max_node_id) return -3; // id вне диапазона canopen
+            std::lock_guard<std::mutex> lock(sdoMutex);
+            if (sdoTable[receiverId].active) releaseSDO(sdoTable[receiverId]);
+            return 1;
+        }
+        
+        /**
+            * @brief Метод пакетного чтения/записи SDO.
+            * Первые запросы ко всем узлам отправляются сразу, следующий запрос к узлу уходит как только узел ответил на предыдущий.
+            * @param write Флаг чтения или записи.
+            * @param reqs Массив запросов.
+            * @param n Количество запросов.
+            * @param out Массивы результатов по n элементов.
+            * @param timeout_ms Таймаут ожидания ответа на каждый запрос в миллисекундах.
+            * @return количество успешных запросов -1 - не подключены -2 - неверные аргументы.
+        */
+        int TransferSDOBatch(bool write, const SdoRequest* reqs, int n, SdoResult* out, int timeout_ms) {
+            return transferBatch(write, reqs, n, out, timeout_ms, std::chrono::steady_clock::time_point::max(), false);
+        }
+
+        /**
+            * @brief Метод сканирования сети: ищет узлы 1..127 и читает с каждого найденного список объектов словаря.
+            * Первый объект списка запрашивается у всех узлов одновременно, следующий объект узла - сразу после его ответа,
+            * у молчащего узла остальные объекты не запрашиваются. Сканирование занимает не больше timeout_ms.
+            * Узел найден, если ответил на первый запрос (в том числе прерыванием) или прислал heartbeat/boot-up не раньше чем
+            * за timeout_ms до начала сканирования.
+            * @param entries Список объектов, nullptr или nEntries = 0 - 0x1000 и 0x1018:1..4.
+            * @param nEntries Количество объектов.
+            * @param nodes Таблица найденных узлов в порядке возрастания ID.
+            * @param out Массивы результатов по maxNodes * nEntries элементов, строка узла nodes[k] начинается с k * nEntries (может быть nullptr).
+            * @param maxNodes Размер таблицы узлов.
+            * @param timeout_ms Время сканирования в миллисекундах: запросы без ответа к этому сроку получают -4.
+            * @return количество найденных узлов (в таблицу попадает не больше maxNodes) -1 - не подключены -2 - неверные аргументы.
+        */
+        int ScanNetwork(const ScanEntry* entries, int nEntries, ScanNode* nodes, SdoResult* out, int maxNodes, int timeout_ms) {
+            if (!isConnected) return -1;
+            if (nodes == nullptr || maxNodes < zero_len || nEntries < zero_len || (nEntries > zero_len && entries == nullptr) ||
+                (out != nullptr && out->status == nullptr)) return -2;
+            static const ScanEntry identity[scan_default_entries] = {{od_device_type, 0}, {od_identity, 1}, {od_identity, 2}, {od_identity, 3}, {od_identity, 4}};
+            if (nEntries == zero_len) {
+                entries = identity;
+                nEntries = scan_default_entries;
+            }
+
+            uint64_t start = steadyNs();
+            uint64_t window = static_cast<uint64_t>(timeout_ms) * us_in_ms * ns_in_us;
+            uint64_t heartbeatFrom = start > window ? start - window : 1; // heartbeat старше этого момента узел не подтверждает
+
+            // все строки таблицы результатов: (узел - 1) * nEntries + номер объекта, очереди узлов начинаются с первого объекта
+            int cells = max_node_id * nEntries;
+            std::vector<int32_t> status(cells, -4);
+            std::vector<int32_t> dataSize(cells, zero_len);
+            std::vector<uint32_t> value(cells, 0);
+            std::vector<SdoRequest> reqs(cells);
+            for (int node = min_node_id; node <= max_node_id; node++) {
+                for (int e = 0; e < nEntries; e++) {
+                    reqs[(node - 1) * nEntries + e] = SdoRequest{node, entries[e].index, entries[e].subIndex, zero_len, {}};
+                }
+            }
+            SdoResult cellsOut{status.data(), dataSize.data(), value.data()};
+            auto until = std::chrono::steady_clock::now() + std::chrono::milliseconds(timeout_ms);
+            int result = transferBatch(false, reqs.data(), cells, &cellsOut, timeout_ms, until, true);
+            if (result < 0) return result;
+
+            bool answered[max_node_id + 1] = {};
+            for (int node = min_node_id; node <= max_node_id; node++) {
+                int cell = (node - 1) * nEntries;
+                answered[node] = status[cell] == 1 || status[cell] == -5 || status[cell] == -6; // узел ответил, даже если объекта нет
+            }
+
+            uint64_t end = steadyNs();
+            int found = 0;
+            for (int node = min_node_id; node <= max_node_id; node++) {
+                uint64_t seen = heartbeatTime[node].load(std::memory_order_acquire);
+                bool alive = seen >= heartbeatFrom;
+                if (!alive && !answered[node]) continue;
+                if (found < maxNodes) {
+                    ScanNode& entry = nodes[found];
+                    entry.nodeId = node;
+                    entry.state = seen != 0 ? heartbeatState[node].load(std::memory_order_relaxed) : node_state_unknown;
+                    entry.flags = (alive ? scan_flag_heartbeat : 0) | (answered[node] ? scan_flag_sdo : 0);
+                    entry.heartbeatAge_ms = seen != 0 && end > seen ? static_cast<uint32_t>((end - seen) / (us_in_ms * ns_in_us)) : 0;
+                    for (int e = 0; out != nullptr && e < nEntries; e++) {
+                        int cell = (node - 1) * nEntries + e;
+                        int row = found * nEntries + e;
+                        out->status[row] = status[cell];
+                        if (out->dataSize != nullptr) out->dataSize[row] = dataSize[cell];
+                        if (out->value != nullptr) out->value[row] = value[cell];
+                    }
+                }
+                found++;
+            }
+            return found;
+        }
+
         /**
          * @brief Метод создания, отправки PDO пакетов.
          * @param receiverId ID узла назначения.
@@ -206,338 +1392,4589 @@ extern "C" {
             pdoPacket[first_cobid_byte] = static_cast<uint8_t>((cobid) >> len_uint8);
             pdoPacket[num_byte_len_pdo_package] = dataSize; // количество значимых байт
             std::memcpy(&pdoPacket[num_byte_payload_pdo], data, dataSize); // записываем данные в пакет PDO
-            int sendResult = sendto(udpSocket, (char*)pdoPacket, sizeof(pdoPacket), 0, (sockaddr*)&serverAddr, sizeof(serverAddr));
+            int sendResult = sendFrame(pdoPacket);
+            if (!txQueueEnabled) txSyscalls.fetch_add(1, std::memory_order_relaxed); // с очередью вызовы считает поток отправки
             if (sendResult == SOCKET_ERROR) return -2; // не смогли отправить
+            txFrames.fetch_add(1, std::memory_order_relaxed);
             return 1;
 
         }
 
         /**
-            * @brief Метод для старта выдачи heartbeat.
-            * @param period_ms Период выдачи heartbeat в миллисекундах.
+         * @brief Метод отправки пачки PDO пакетов.
+         * На Linux пачка уходит через sendmmsg по send_batch_size пакетов за вызов, на Windows каждый пакет через sendto.
+         * При включенной очереди отправки пакеты встают в очередь своего класса.
+         * @param frames Массив пакетов (cobid, количество действительных байт и данные, timestamp_ns не используется).
+         * @param n Количество пакетов.
+         * @return количество отправленных пакетов -1 - не подключены -2 - ошибка отправки первого пакета.
         */
-        int Start_heartbeat(int period_ms) {
-            period_heartbeat_ms = period_ms;
-            send_heartbeat = true;
-            return 1;
-        };
+        int WritePDOBatch(const PdoRecord* frames, int n) {
+            if (!isConnected) return -1;
+
+            int sent = 0;
+            while (sent < n) {
+                int chunk = std::min(n - sent, send_batch_size);
+                unsigned char packets[send_batch_size][udp_len_package] = {};
+                for (int i = 0; i < chunk; i++) {
+                    const PdoRecord& frame = frames[sent + i];
+                    packets[i][second_cobid_byte] = static_cast<uint8_t>(frame.cobid & mask_cobid); // id получателя
+                    packets[i][first_cobid_byte] = static_cast<uint8_t>(frame.cobid >> len_uint8);
+                    packets[i][num_byte_len_pdo_package] = std::min<uint8_t>(frame.len, max_len_pdo_payload); // количество значимых байт
+                    std::memcpy(&packets[i][num_byte_payload_pdo], frame.data, max_len_pdo_payload);
+                }
+                int result = txQueueEnabled ? enqueueFrames(packets, chunk) : transmitFrames(packets, chunk);
+                if (result == SOCKET_ERROR) return sent > 0 ? sent : -2; // не смогли отправить
+                txFrames.fetch_add(result, std::memory_order_relaxed);
+                sent += result;
+                if (result < chunk) break; // буфер сокета или очередь переполнены, остаток не отправляем
+            }
+            return sent;
+        }
 
         /**
-            * @brief Метод для остановки выдачи heartbeat.
+         * @brief Метод получения счетчиков системных вызовов приема/передачи.
+         * @param stats Структура для счетчиков.
+         * @return 1 - успешно.
         */
-        int Stop_heartbeat() {
-            send_heartbeat = false;
+        int GetIOStats(IoStats* stats) {
+            stats->rxSyscalls = rxSyscalls.load(std::memory_order_relaxed);
+            stats->rxFrames = rxFrames_total.load(std::memory_order_relaxed);
+            stats->txSyscalls = txSyscalls.load(std::memory_order_relaxed);
+            stats->txFrames = txFrames.load(std::memory_order_relaxed);
             return 1;
-        };
+        }
 
         /**
-            * @brief Метод завершения сеанса связи, остановка потока чтения и закрытия сокета.
-            * @return 1 - успешно -1 - не подключены.
+            * @brief Метод регистрации TPDO для циклической отправки потоком StartCyclic.
+            * @param cobid cobid TPDO.
+            * @param data Начальные данные.
+            * @param dataSize Количество действительных байт.
+            * @param divider Отправка раз в divider периодов (1..240, как synchronous transmission type).
+            * @return номер TPDO -2 - неверные аргументы -3 - таблица заполнена.
         */
-        int Disconnect() {
-            if (isConnected) {
-                isConnected = false;
-                if (readThread.joinable()) { // проверяем что можем завершить поток
-                    readThread.join(); // Дожидаемся завершения потока
-                }
-                if (heartbeatThread.joinable()) { // проверяем что можем завершить поток
-                    heartbeatThread.join(); // Дожидаемся завершения потока
-                }
-                closesocket(udpSocket); // закрываем сокет
-                WSACleanup(); // завершаем операции сокетов
-            } else {
-                return -1; 
+        int AddCyclicPDO(int cobid, const unsigned char* data, int dataSize, int divider) {
+            if (cobid <= zero_len || cobid > max_cobid || dataSize < zero_len || dataSize > max_len_pdo_payload) return -2;
+            if (divider < 1 || divider > max_cyclic_divider || (dataSize > zero_len && data == nullptr)) return -2;
+            std::lock_guard<std::mutex> lock(cyclicMutex);
+            for (int slot = 0; slot < max_cyclic_pdos; slot++) {
+                CyclicSlot& entry = cyclicSlots[slot];
+                if (entry.active.load(std::memory_order_relaxed)) continue;
+                writeCyclicSlot(entry, true, cobid, data, dataSize, divider);
+                cyclicCount++;
+                return slot;
             }
-            return 1;
+            return -3;
         }
 
-    private:
         /**
-            * Экземпляр сокета для приема/отправки данных.
+            * @brief Метод атомарной замены данных циклического TPDO, поток отправки видит либо старые, либо новые данные целиком.
+            * @param slot Номер TPDO из AddCyclicPDO.
+            * @param data Новые данные.
+            * @param dataSize Количество действительных байт.
+            * @return 1 - успешно -2 - неверные аргументы или TPDO не зарегистрирован.
         */
-        SOCKET udpSocket;
+        int UpdateCyclicPDO(int slot, const unsigned char* data, int dataSize) {
+            if (slot < 0 || slot >= max_cyclic_pdos || dataSize < zero_len || dataSize > max_len_pdo_payload) return -2;
+            if (dataSize > zero_len && data == nullptr) return -2;
+            std::lock_guard<std::mutex> lock(cyclicMutex); // писателей может быть несколько, seqlock допускает одного
+            CyclicSlot& entry = cyclicSlots[slot];
+            if (!entry.active.load(std::memory_order_relaxed)) return -2;
+            writeCyclicSlot(entry, true, entry.cobid.load(std::memory_order_relaxed), data, dataSize, entry.divider.load(std::memory_order_relaxed));
+            return 1;
+        }
+
         /**
-            * Структура адреса сервера для UDP-соединения. 
-            * Содержит адрес и порт для подключения к серверу.
+            * @brief Метод удаления TPDO из циклической отправки.
+            * @param slot Номер TPDO из AddCyclicPDO.
+            * @return 1 - успешно -2 - TPDO не зарегистрирован.
         */
-        sockaddr_in serverAddr;
+        int RemoveCyclicPDO(int slot) {
+            if (slot < 0 || slot >= max_cyclic_pdos) return -2;
+            std::lock_guard<std::mutex> lock(cyclicMutex);
+            CyclicSlot& entry = cyclicSlots[slot];
+            if (!entry.active.load(std::memory_order_relaxed)) return -2;
+            writeCyclicSlot(entry, false, zero_len, nullptr, zero_len, 1);
+            cyclicCount--;
+            return 1;
+        }
 
         /**
-            * Флаг активности подключения. 
-            * Если значение true, соединение установлено и активно.
+            * @brief Метод запуска потока циклической отправки: каждый период SYNC (если включен) и пачка TPDO одним sendmmsg.
+            * Поток спит до абсолютного срока (clock_nanosleep на Linux), поэтому ошибка не накапливается от периода к периоду.
+            * @param period_us Период в микросекундах.
+            * @param sync true - отправлять SYNC (cobid 0x80) в начале каждого периода.
+            * @return 1 - успешно -1 - не подключены -2 - неверный период -3 - поток уже запущен.
         */
-        bool isConnected;
+        int StartCyclic(int period_us, bool sync) {
+            if (!isConnected) return -1;
+            if (period_us < min_cyclic_period_us || period_us > max_cyclic_period_us) return -2;
+            if (cyclicRunning) return -3;
+            cyclicPeriod_us = period_us;
+            cyclicSync = sync;
+            cyclicCycles = cyclicOverruns = cyclicFrames = cyclicErrors = 0;
+            cyclicMaxLateness.store(0, std::memory_order_relaxed);
+            cyclicLateness.reset();
+            cyclicRunning = true;
+            cyclicThread = std::thread(&Worker::CyclicSender, this);
+            return 1;
+        }
 
         /**
-            * Поток для чтения данных. 
-            * Поток используется для асинхронного получения данных через сокет.
+            * @brief Метод остановки потока циклической отправки, ждет не дольше одного периода.
+            * @return 1 - успешно -1 - поток не запущен.
         */
-        std::thread readThread;
+        int StopCyclic() {
+            if (!cyclicRunning) return -1;
+            cyclicRunning = false;
+            if (cyclicThread.joinable()) cyclicThread.join();
+            return 1;
+        }
 
         /**
-            * Поток для отправки heartbeat
+            * @brief Метод получения счетчиков и гистограммы опозданий потока циклической отправки.
+            * @param stats Структура для счетчиков.
+            * @return 1 - успешно.
         */
-        std::thread heartbeatThread;
+        int GetCyclicStats(CyclicStats* stats) {
+            stats->cycles = cyclicCycles.load(std::memory_order_relaxed);
+            stats->overruns = cyclicOverruns.load(std::memory_order_relaxed);
+            stats->framesSent = cyclicFrames.load(std::memory_order_relaxed);
+            stats->sendErrors = cyclicErrors.load(std::memory_order_relaxed);
+            stats->maxLateness_ns = cyclicMaxLateness.load(std::memory_order_relaxed);
+            stats->period_us = cyclicRunning ? static_cast<uint32_t>(cyclicPeriod_us) : 0;
+            {
+                std::lock_guard<std::mutex> lock(cyclicMutex);
+                stats->pdos = static_cast<uint32_t>(cyclicCount);
+            }
+            cyclicLateness.read(&stats->lateness);
+            return 1;
+        }
 
         /**
-            * Общий буфер чтения. Буфер, в который записываются получаемые данные. 
-            * Используется для дальнейшего распределения пакетов SDO чтения и записи.
+            * @brief Метод включения очереди отправки: все пакеты (SDO, PDO, heartbeat, SYNC) отправляет один поток
+            * в порядке приоритета классов, а не поток, который их сформировал.
+            * Вызывается до подключения.
+            * @param depth Размер очереди каждого класса, 0 - default_tx_queue_depth, -1 - выключить очередь.
+            * @return 1 - успешно -1 - уже подключены -2 - неверный размер.
         */
-        unsigned char readBuffer[udp_len_package];
+        int EnableTxQueue(int depth) {
+            if (isConnected) return -1; // очереди нельзя перевыделять под работающим потоком отправки
+            if (depth < -1 || depth > max_tx_queue_depth) return -2;
+            if (depth == zero_len) depth = default_tx_queue_depth;
+            std::lock_guard<std::mutex> lock(txMutex);
+            for (TxQueue& queue : txQueues) {
+                queue.entries.assign(depth > zero_len ? depth : 0, TxEntry{});
+                queue.head = queue.size = queue.highWater = 0;
+                queue.enqueued = queue.sent = queue.dropped = 0;
+            }
+            txQueueEnabled = depth > zero_len;
+            return 1;
+        }
 
         /**
-            * Буфер для хранения принятых PDO пакетов.
+            * @brief Метод настройки порядка классов очереди отправки.
+            * @param order Классы tx_class_* от высшего приоритета к низшему, каждый класс ровно один раз.
+            * @param count Количество классов (tx_class_count).
+            * @return 1 - успешно -2 - неверный порядок.
         */
-        //unsigned char* pdobuffer;
-
-        unsigned char pdobuffer[udp_len_package];
+        int SetTxPriority(const int* order, int count) {
+            if (order == nullptr || count != tx_class_count) return -2;
+            bool seen[tx_class_count] = {};
+            for (int rank = 0; rank < count; rank++) {
+                if (order[rank] < 0 || order[rank] >= tx_class_count || seen[order[rank]]) return -2;
+                seen[order[rank]] = true;
+            }
+            std::lock_guard<std::mutex> lock(txMutex);
+            std::copy(order, order + count, txOrder);
+            return 1;
+        }
 
         /**
-            * Буфер для передачи ошибок с шины.
+            * @brief Метод ограничения скорости отправки класса (token bucket).
+            * @param txClass Класс tx_class_*.
+            * @param framesPerSec Пакетов в секунду, 0 - без ограничения.
+            * @param burst Пакетов, которые можно отправить подряд после простоя (не меньше 1).
+            * @return 1 - успешно -2 - неверные аргументы.
         */
-        unsigned char errorbuffer[udp_len_package];
+        int SetTxRateLimit(int txClass, int framesPerSec, int burst) {
+            if (txClass < 0 || txClass >= tx_class_count || framesPerSec < zero_len || (framesPerSec > zero_len && burst < 1)) return -2;
+            std::lock_guard<std::mutex> lock(txMutex);
+            TxQueue& queue = txQueues[txClass];
+            queue.rate = framesPerSec;
+            queue.burst = burst;
+            queue.tokens = burst;
+            queue.refilled_ns = steadyNs();
+            txReady.notify_one(); // поток мог ждать разрешения по старому ограничению
+            return 1;
+        }
 
         /**
-        * Буфер для записи SDO пакетов ответа на запись. 
-        * Этот буфер используется для хранения ответа запроса на запись.
+            * @brief Метод получения счетчиков и гистограмм очереди отправки.
+            * @param stats Структура для счетчиков.
+            * @return 1 - успешно.
         */
-        unsigned char readBuffer_sdo_w[udp_len_package];
+        int GetTxQueueStats(TxQueueStats* stats) {
+            std::lock_guard<std::mutex> lock(txMutex);
+            for (int c = 0; c < tx_class_count; c++) {
+                const TxQueue& queue = txQueues[c];
+                stats->enqueued[c] = queue.enqueued;
+                stats->sent[c] = queue.sent;
+                stats->dropped[c] = queue.dropped;
+                stats->depth[c] = static_cast<uint32_t>(queue.size);
+                stats->highWater[c] = static_cast<uint32_t>(queue.highWater);
+                txLatency[c].read(&stats->latency[c]);
+            }
+            stats->batches = txBatches;
+            return 1;
+        }
 
         /**
-            * Буфер для записи SDO пакетов ответа на чтение. 
-            * Этот буфер используется для хранения ответа запроса на чтение.
+            * @brief Метод включения потоков callback'ов: callback_pdo, callback_error и callback'и подписок вызывают они,
+            * а не поток чтения, поэтому медленный callback не задерживает прием, ответы SDO и heartbeat.
+            * Пакет попадает в очередь потока по cobid, поэтому callback'и одного cobid вызываются по порядку.
+            * Вызывается до подключения.
+            * @param threads Количество потоков, 0 - callback'и вызывает поток чтения.
+            * @param depth Размер очереди каждого потока (округляется вверх до степени двойки), 0 - default_callback_queue_depth.
+            * @param policy callback_policy_drop или callback_policy_coalesce.
+            * @param late_us Порог опоздания callback'а относительно приема пакета, 0 - default_callback_late_us.
+            * @return 1 - успешно -1 - уже подключены -2 - неверные аргументы.
         */
-        unsigned char readBuffer_sdo_r[udp_len_package];
+        int EnableCallbackExecutor(int threads, int depth, int policy, int late_us) {
+            if (isConnected) return -1; // очереди нельзя перевыделять под работающим потоком чтения
+            if (threads < zero_len || threads > max_callback_threads || depth < zero_len || depth > max_callback_queue_depth ||
+                (policy != callback_policy_drop && policy != callback_policy_coalesce) || late_us < zero_len) return -2;
+            if (depth == zero_len) depth = default_callback_queue_depth;
+            if (late_us == zero_len) late_us = default_callback_late_us;
+
+            uint32_t size = 1;
+            while (size < static_cast<uint32_t>(depth)) size <<= 1; // маска вместо деления по модулю
+            for (int t = 0; t < max_callback_threads; t++) {
+                callbackLanes[t].items.assign(t < threads ? size : 0, CallbackItem{});
+                callbackLanes[t].head.store(0, std::memory_order_relaxed);
+                callbackLanes[t].tail.store(0, std::memory_order_relaxed);
+                callbackLanes[t].coalescePending.store(0, std::memory_order_relaxed);
+            }
+            for (std::atomic<uint8_t>& dirty : callbackDirty) dirty.store(0, std::memory_order_relaxed);
+            callbackMask = size - 1;
+            callbackThreads = threads;
+            callbackPolicy = policy;
+            callbackLate_ns = static_cast<uint64_t>(late_us) * ns_in_us;
+            return 1;
+        }
 
         /**
-            * Период выдачи heartbeat.
+            * @brief Метод получения счетчиков потоков callback'ов.
+            * @param stats Структура для счетчиков.
+            * @return 1 - успешно.
         */
-        int period_heartbeat_ms = 1000;
+        int GetCallbackStats(CallbackStats* stats) {
+            stats->enqueued = callbackEnqueued.load(std::memory_order_relaxed);
+            stats->delivered = callbackDelivered.load(std::memory_order_relaxed);
+            stats->dropped = callbackDropped.load(std::memory_order_relaxed);
+            stats->coalesced = callbackCoalesced.load(std::memory_order_relaxed);
+            stats->late = callbackLateCount.load(std::memory_order_relaxed);
+            stats->threads = static_cast<uint32_t>(callbackThreads);
+            stats->highWater = callbackHighWater.load(std::memory_order_relaxed);
+            callbackDelay.read(&stats->delay);
+            return 1;
+        }
 
         /**
-            * Флаг отправки heartbeat.
+            * @brief Метод получения всех счетчиков и гистограмм Worker.
+            * @param stats Структура для счетчиков.
+            * @return 1 - успешно.
         */
-        bool send_heartbeat = false;
+        int GetStats(WorkerStats* stats) {
+            for (int c = 0; c < frame_class_count; c++) {
+                stats->rxFrames[c] = rxByClass[c].load(std::memory_order_relaxed);
+                stats->txFrames[c] = txByClass[c].load(std::memory_order_relaxed);
+            }
+            stats->rxSyscalls = rxSyscalls.load(std::memory_order_relaxed);
+            stats->txSyscalls = txSyscalls.load(std::memory_order_relaxed);
+            stats->listenerWakeups = listenerWakeups.load(std::memory_order_relaxed);
+            stats->idleWakeups = idleWakeups.load(std::memory_order_relaxed);
+            stats->shortDatagrams = shortDatagrams.load(std::memory_order_relaxed);
+            stats->sdoUnmatched = sdoUnmatched.load(std::memory_order_relaxed);
+            stats->sdoTimeouts = sdoTimeouts.load(std::memory_order_relaxed);
+            stats->sdoAborts = sdoAborts.load(std::memory_order_relaxed);
+            stats->pdoLengthErrors = pdoLengthErrors.load(std::memory_order_relaxed);
+            stats->pdoRingOverflows = pdoRingOverflows.load(std::memory_order_relaxed);
+            {
+                std::lock_guard<std::mutex> lock(captureMutex);
+                stats->captureDropped = captureDropped;
+            }
+            sdoLatency[0].read(&stats->sdoRoundTrip);
+            callbackLatency.read(&stats->callback);
+            return 1;
+        }
 
         /**
-         * Callback для получения pdo пакета.
+            * @brief Метод получения гистограммы задержки expedited SDO одного узла.
+            * @param receiverId ID узла, 0 - все узлы.
+            * @param histogram Структура для гистограммы.
+            * @return 1 - успешно -3 - неверный id узла.
         */
-        CallbackFunc callback_pdo;
+        int GetSDOLatency(int receiverId, LatencyHistogram* histogram) {
+            if (receiverId < 0 || receiverId > max_node_id) return -3;
+            sdoLatency[receiverId].read(histogram);
+            return 1;
+        }
 
         /**
-         * Callback для получения ошибки с шины.
+            * @brief Метод обнуления счетчиков и гистограмм (включая счетчики GetIOStats и GetPDORingStats).
+            * @return 1 - успешно.
         */
-        CallbackFunc callback_error;
+        int ResetStats() {
+            for (int c = 0; c < frame_class_count; c++) {
+                rxByClass[c].store(0, std::memory_order_relaxed);
+                txByClass[c].store(0, std::memory_order_relaxed);
+            }
+            for (std::atomic<uint64_t>* counter : {&rxSyscalls, &rxFrames_total, &txSyscalls, &txFrames, &listenerWakeups, &idleWakeups,
+                                                   &shortDatagrams, &sdoUnmatched, &sdoTimeouts, &sdoAborts, &pdoLengthErrors,
+                                                   &pdoRingPushed, &pdoRingOverflows, &callbackEnqueued, &callbackDelivered,
+                                                   &callbackDropped, &callbackCoalesced, &callbackLateCount}) {
+                counter->store(0, std::memory_order_relaxed);
+            }
+            pdoRingHighWater.store(0, std::memory_order_relaxed);
+            callbackHighWater.store(0, std::memory_order_relaxed);
+            {
+                std::lock_guard<std::mutex> lock(captureMutex);
+                captureDropped = 0;
+            }
+            {
+                std::lock_guard<std::mutex> lock(sdoCacheMutex);
+                sdoCacheHits = sdoCacheMisses = sdoCacheStale = sdoCacheWriteThrough = sdoCacheInvalidations = 0;
+            }
+            {
+                std::lock_guard<std::mutex> lock(traceMutex);
+                traceSampled = traceDropped = 0;
+            }
+            traceStamped.store(0, std::memory_order_relaxed);
+            traceUnstamped.store(0, std::memory_order_relaxed);
+            for (Histogram& histogram : traceStages) histogram.reset();
+            for (Histogram& histogram : sdoLatency) histogram.reset();
+            callbackLatency.reset();
+            callbackDelay.reset();
+            return 1;
+        }
 
         /**
-            * @brief Метод прослушивания сокета и распределения пакетов SDO/PDO.
+            * @brief Метод старта записи всех принятых и отправленных пакетов в бинарный файл.
+            * Пакеты копируются в заранее выделенный буфер, в файл буфер сбрасывает фоновый поток.
+            * @param path Путь к файлу (перезаписывается).
+            * @param bufferRecords Размер каждого из двух буферов в записях, 0 - default_capture_records.
+            * @return 1 - успешно -1 - запись уже идет -2 - не удалось открыть файл -3 - неверный размер буфера.
         */
-        void PacketListener() {
-            uint16_t can_id;
-            fd_set readSet;
-            
+        int StartCapture(const char* path, int bufferRecords) {
+            if (capturing) return -1;
+            if (bufferRecords < 0) return -3;
+            if (bufferRecords == 0) bufferRecords = default_capture_records;
 
-            timeval timeout;
-            timeout.tv_sec = 0;
-            timeout.tv_usec = 50000;  // 50 ms
+            FILE* file = std::fopen(path, "wb");
+            if (file == nullptr) return -2;
+            CaptureHeader header = {};
+            std::memcpy(header.magic, capture_magic, sizeof(header.magic));
+            header.version = capture_version;
+            header.recordSize = sizeof(CaptureRecord);
+            header.startTimestamp_ns = steadyNs();
+            if (std::fwrite(&header, sizeof(header), 1, file) != 1) {
+                std::fclose(file);
+                return -2;
+            }
 
+            captureFile = file;
+            captureActive.assign(bufferRecords, CaptureRecord{}); // память выделяется здесь, а не в потоке чтения
+            captureSpare.assign(bufferRecords, CaptureRecord{});
+            captureFill = 0;
+            captureSpareCount = 0;
+            captureFlushPending = false;
+            captureStop = false;
+            captureRecords = captureDropped = captureFlushes = 0;
+            captureThread = std::thread(&Worker::CaptureWriter, this);
+            capturing = true;
+            return 1;
+        }
 
-            DWORD start = GetTickCount();
+        /**
+            * @brief Метод остановки записи трафика, сбрасывает остаток буфера и закрывает файл.
+            * @return количество записанных пакетов -1 - запись не идет.
+        */
+        int StopCapture() {
+            if (!capturing) return -1;
+            capturing = false;
+            {
+                std::lock_guard<std::mutex> lock(captureMutex);
+                captureStop = true;
+            }
+            captureReady.notify_one();
+            if (captureThread.joinable()) captureThread.join();
+            std::fclose(captureFile);
+            captureFile = nullptr;
+            return static_cast<int>(captureRecords);
+        }
 
-            while (isConnected) {
-                // проверяем доступность данных
-                FD_ZERO(&readSet); // настраеваем фд для работы select
-                FD_SET(udpSocket, &readSet);
-                int result = select(0, &readSet, nullptr, nullptr, &timeout);
+        /**
+            * @brief Метод получения счетчиков записи трафика.
+            * @param stats Структура для счетчиков.
+            * @return 1 - успешно.
+        */
+        int GetCaptureStats(CaptureStats* stats) {
+            std::lock_guard<std::mutex> lock(captureMutex);
+            stats->records = captureRecords;
+            stats->dropped = captureDropped;
+            stats->flushes = captureFlushes;
+            stats->active = capturing ? 1 : 0;
+            return 1;
+        }
 
-                //данные доступны
-                if (result > data_not_exist && FD_ISSET(udpSocket, &readSet)) {
-                    int serverAddrSize = sizeof(serverAddr);
-                    int recvResult=recvfrom(udpSocket, (char*)readBuffer, sizeof(readBuffer), 0, (sockaddr*)&serverAddr, &serverAddrSize);
-                    if (recvResult == SOCKET_ERROR) {
-                        Disconnect(); 
-                    }
-                    if (recvResult >= udp_len_package){ // получили данные
-                        can_id = (static_cast<uint16_t>(readBuffer[first_cobid_byte]) << len_uint8) | readBuffer[second_cobid_byte]; //считаем cobid из двух байт принятого пакета
-                        if ((can_id >= min_cobid_pdo && can_id <= max_cobid_pdo)) {// Проверяем что это PDO
-                            GetPDO(); // Записываем во внешний массив pdobuffer
-                        } else if (readBuffer[num_sdo_command] == sdo_command_read) {
-                            GetSDO(IS_ANSWER); // Записываем ответ в очередь ответов для SDO записи
-                        } else if (readBuffer[num_len_sdo] == len_sdo && readBuffer[num_sdo_command] <= max_command_sdo_w &&  readBuffer[num_sdo_command] >= min_command_sdo_w) {
-                            GetSDO(IS_REQUEST); // Записываем ответ в очередь ответов для SDO чтения
-                        } else if (can_id >= min_cobid_error && can_id < max_cobid_error) {
-                            GetError(); // Записываем ошибку во внешний массив errorbuffer
-                        }
-                    }
-                    
-                }
+        /**
+            * @brief Метод воспроизведения записи трафика через тот же разбор пакетов, что и у потока чтения (GetPDO/GetSDO/GetError).
+            * Вызывается без подключения, отправленные пакеты из записи пропускаются.
+            * @param path Путь к файлу записи.
+            * @param realtime true - с исходными интервалами между пакетами, false - с максимальной скоростью.
+            * @return количество разобранных пакетов -1 - подключены -2 - не удалось открыть файл -3 - неверный формат файла.
+        */
+        int ReplayCapture(const char* path, bool realtime) {
+            if (isConnected) return -1; // иначе разбор шел бы одновременно с потоком чтения
 
-                if (send_heartbeat){
-                    if (timeout_SDO_answer(start, period_heartbeat_ms)) {
-                        sendto(udpSocket, (char*)heartbeat, sizeof(heartbeat), 0, (sockaddr*)&serverAddr, sizeof(serverAddr));
-                        start = GetTickCount();
+            FILE* file = std::fopen(path, "rb");
+            if (file == nullptr) return -2;
+            CaptureHeader header;
+            if (std::fread(&header, sizeof(header), 1, file) != 1 || std::memcmp(header.magic, capture_magic, sizeof(header.magic)) != 0 ||
+                header.version != capture_version || header.recordSize != sizeof(CaptureRecord)) {
+                std::fclose(file);
+                return -3;
+            }
+
+            std::vector<CaptureRecord> chunk(recv_batch_size);
+            auto replayStart = std::chrono::steady_clock::now();
+            uint64_t firstTimestamp = 0;
+            bool first = true;
+            int dispatched = 0;
+            replaying = true;
+            size_t count;
+            while ((count = std::fread(chunk.data(), sizeof(CaptureRecord), chunk.size(), file)) > 0) {
+                for (size_t i = 0; i < count; i++) {
+                    const CaptureRecord& record = chunk[i];
+                    if (record.direction != capture_dir_rx) continue;
+                    if (first) {
+                        firstTimestamp = record.timestamp_ns;
+                        first = false;
                     }
+                    if (realtime) std::this_thread::sleep_until(replayStart + std::chrono::nanoseconds(record.timestamp_ns - firstTimestamp));
+                    std::memcpy(rxFrames[0], record.frame, udp_len_package);
+                    readBuffer = rxFrames[0];
+                    dispatchFrame(record.timestamp_ns); // время приема из записи, чтобы образ процесса совпадал с оригиналом
+                    dispatched++;
                 }
             }
+            replaying = false;
+            std::fclose(file);
+            return dispatched;
         }
 
         /**
-            * @brief Метод записи данных пакета во внешний буфер pdobuffer (передается cobid, длина значимых байт и сам payload)
-            * @return 1 - успешно -1 - не подключены.
+            * @brief Метод микробенчмарка разбора пакетов на синтетических кадрах: формирование и проверка заголовка SDO,
+            * классификация cobid (цепочка диапазонов и таблица) и разбор PDO/EMCY через dispatchFrame без callback и с пустым callback.
+            * Разбор идет на временном Worker с маршрутами по умолчанию: образ процесса, счетчики, callback'и и подключение
+            * этого Worker не меняются, поэтому вызывать можно в любой момент.
+            * @param iterations Количество операций в каждом измерении.
+            * @param results Массив результатов.
+            * @param max Размер массива (все измерения - bench_results).
+            * @return количество результатов -2 - неверные параметры.
         */
-        int GetPDO() {
-            if (!isConnected) return -1;
-            pdobuffer[first_cobid_outer_buf] = readBuffer[second_cobid_byte]; // первая часть cobid в перевернутом виде
-            pdobuffer[second_cobid_outer_buf] = readBuffer[first_cobid_byte]; // вторая часть cobid в перевернутом виде
-            pdobuffer[num_pdo_buffer_len_payload] = readBuffer[num_byte_len_pdo_package]; // длина значимых байт
-            std::copy(readBuffer + num_byte_payload_pdo,readBuffer + udp_len_package, pdobuffer+num_pdo_buffer_payload); // записываем содержимое PDO
+        int RunBenchmark(int iterations, BenchResult* results, int max) {
+            if (iterations <= zero_len || results == nullptr || max <= zero_len) return -2;
+            Worker* scratch = new Worker(); // без сокета и потоков, dispatchFrame пишет только в его состояние
+            int count = scratch->benchmark(iterations, results, max);
+            delete scratch;
+            return count;
+        }
+
+        /**
+            * @brief Метод публикации образа процесса PDO/EMCY и журнала принятых пакетов в именованную общую память.
+            * Другие процессы читают их через OpenSharedImage без своего подключения. Вызывается до подключения.
+            * @param name Имя сегмента ("/can_image"), nullptr - перестать публиковать и удалить сегмент.
+            * @param journalRecords Записей журнала (округляется вверх до степени двойки), 0 - default_shm_journal_records.
+            * @return 1 - успешно -1 - уже подключены -2 - неверный размер журнала -3 - не удалось создать сегмент
+            * -4 - сегмент с таким именем публикует работающий процесс.
+        */
+        int PublishSharedImage(const char* name, int journalRecords) {
+            if (isConnected) return -1; // поток чтения пишет в сегмент без блокировок
+            if (journalRecords < zero_len || journalRecords > max_shm_journal_records) return -2;
+            delete sharedImage;
+            sharedImage = nullptr;
+            if (name == nullptr) return 1;
 
-            if (callback_pdo) {
-                callback_pdo(pdobuffer);
+            SharedImage* image = new SharedImage(name, journalRecords == zero_len ? default_shm_journal_records : journalRecords);
+            if (!image->IsOpen()) {
+                int result = image->Busy() ? -4 : -3;
+                delete image;
+                return result;
             }
-            
+            sharedImage = image;
             return 1;
         }
 
         /**
-            * @brief Метод распределения ответов SDO на массивы ответов SDO записи/чтения.
-            * @param rw_rd - Флаг чтения или записи чтобы понять в какой массив закидывать ответ
-            * @return 1 - успешно -1 - не подключены.
+            * @brief Метод включения кольцевого буфера PDO вместо callback'а на каждый пакет.
+            * Вызывается до подключения, пока поток чтения не запущен.
+            * @param capacity Размер буфера в записях (округляется вверх до степени двойки), 0 - выключить буфер.
+            * @return 1 - успешно -1 - поток чтения уже запущен -2 - неверный размер.
         */
-        int GetSDO(bool rw_rd) {
-            if (!isConnected) return -1;
+        int EnablePDORing(int capacity) {
+            if (isConnected) return -1; // буфер нельзя перевыделять под работающим потоком чтения
+            if (capacity < zero_len || capacity > max_pdo_ring_capacity) return -2;
 
-            if (rw_rd) {
-                std::copy(readBuffer, readBuffer + udp_len_package, readBuffer_sdo_w);
-            } else {
-                std::copy(readBuffer, readBuffer + udp_len_package, readBuffer_sdo_r);
-            }
-            
+            uint32_t size = 1;
+            while (size < static_cast<uint32_t>(capacity)) size <<= 1; // маска вместо деления по модулю
+            pdoRing.assign(capacity == zero_len ? 0 : size, PdoRecord{});
+            pdoRingMask = size - 1;
+            pdoRingHead.store(0, std::memory_order_relaxed);
+            pdoRingTail.store(0, std::memory_order_relaxed);
+            pdoRingPushed.store(0, std::memory_order_relaxed);
+            pdoRingOverflows.store(0, std::memory_order_relaxed);
+            pdoRingHighWater.store(0, std::memory_order_relaxed);
             return 1;
         }
 
         /**
-         * @brief Метод получения кода ошибки
-         * @return 1 - успешно.
+            * @brief Метод выборки накопленных PDO из кольцевого буфера. Вызывается из одного потока-потребителя.
+            * @param out Массив для записей.
+            * @param max Размер массива в записях.
+            * @return количество выбранных записей -2 - буфер выключен.
         */
-        int GetError() {
-
-            errorbuffer[first_cobid_outer_buf] = readBuffer[second_cobid_byte]; // первая часть cobid в перевернутом виде
-            errorbuffer[second_cobid_outer_buf] = readBuffer[first_cobid_byte]; // вторая часть cobid в перевернутом виде
-            std::copy(readBuffer + num_byte_payload_pdo,readBuffer + udp_len_package, errorbuffer+num_byte_error_payload); // записываем содержимое пакета ошибки
-            if (callback_error) {
-                callback_error(errorbuffer);
+        int DrainPDO(PdoRecord* out, int max) {
+            if (pdoRing.empty()) return -2;
+            uint32_t tail = pdoRingTail.load(std::memory_order_relaxed);
+            uint32_t head = pdoRingHead.load(std::memory_order_acquire); // видим все записи до head
+            uint32_t count = std::min<uint32_t>(head - tail, max > zero_len ? max : 0);
+            for (uint32_t i = 0; i < count; i++) {
+                out[i] = pdoRing[(tail + i) & pdoRingMask];
             }
+            pdoRingTail.store(tail + count, std::memory_order_release); // отдаем место потоку чтения
+            return static_cast<int>(count);
+        }
+
+        /**
+            * @brief Метод получения счетчиков кольцевого буфера PDO.
+            * @param stats Структура для счетчиков.
+            * @return 1 - успешно.
+        */
+        int GetPDORingStats(PdoRingStats* stats) {
+            stats->capacity = static_cast<uint32_t>(pdoRing.size());
+            stats->size = pdoRingHead.load(std::memory_order_acquire) - pdoRingTail.load(std::memory_order_acquire);
+            stats->highWater = pdoRingHighWater.load(std::memory_order_relaxed);
+            stats->reserved = 0;
+            stats->pushed = pdoRingPushed.load(std::memory_order_relaxed);
+            stats->overflows = pdoRingOverflows.load(std::memory_order_relaxed);
             return 1;
         }
+
         /**
-            * @brief Метод создания заголовка SDO пакета.
-            * @param package Массив в котором формируется пакет.
-            * @param write Флаг чтения или записи.
-            * @param receiverId Id получателя.
-            * @param index Индекс SDO объекта.
-            * @param subIndex Под индекс SDO объекта.
-            * @param dataSize Количество байт данных (используется только для вариантта записи).
-            * @return 1 - успешно -1 - не подключены.
+            * @brief Метод регистрации маппинга PDO. Принятые пакеты этого cobid раскладываются по сигналам в таблицу
+            * последних значений и не передаются в callback_pdo и кольцевой буфер.
+            * Вызывается до подключения, пока поток чтения не запущен.
+            * @param cobid cobid PDO.
+            * @param bitLengths Длины сигналов в битах в порядке следования в пакете.
+            * @param dataTypes Типы сигналов (pdo_type_unsigned, pdo_type_signed, pdo_type_float32).
+            * @param count Количество сигналов.
+            * @return номер первого сигнала в таблице значений -1 - поток чтения уже запущен -2 - неверный маппинг -3 - cobid уже зарегистрирован или таблица заполнена.
         */
-        int makeSDOhead(unsigned char* package, bool write, int receiverId, int index, int subIndex, int dataSize) {
-            if (!isConnected) return -1;
+        int RegisterPDOMapping(int cobid, const int* bitLengths, const int* dataTypes, int count) {
+            if (isConnected) return -1; // план нельзя менять под работающим потоком чтения
+            if (cobid < min_cobid_pdo || cobid > max_cobid_pdo || count <= zero_len || count > max_pdo_bits) return -2;
+            if (pdoPlanIndex[cobid] != no_pdo_mapping || pdoPlanCount >= max_pdo_mappings || pdoSignalCount + count > max_pdo_signals) return -3;
 
-            package[second_cobid_byte] = receiverId; // id получателя
-            package[first_cobid_byte] = static_cast<uint8_t>((send_cobid) >> len_uint8);
-            package[num_byte_len_pdo_package] = len_sdo; // длинна пакета
-            if (write) {
-                package[num_sdo_command] = command_write_payload_sdo | ((max_count_byte_payload - dataSize) << shift_command_len_payload); // количество действительных байт исходя из длины 
-            } else {
-                package[num_sdo_command] = command_sdo_read; // команда чтения
+            // проверяем маппинг и компилируем его в сдвиги и маски
+            int shift = 0;
+            for (int i = 0; i < count; i++) {
+                int bits = bitLengths[i];
+                int type = dataTypes[i];
+                if (bits <= zero_len || shift + bits > max_pdo_bits) return -2;
+                if (type != pdo_type_unsigned && type != pdo_type_signed && type != pdo_type_float32) return -2;
+                if (type == pdo_type_float32 && bits != sizeof(float) * len_uint8) return -2;
+                shift += bits;
             }
-            package[num_byte_second_index] = index & mask_convert_16t08; // вторая часть индекса
-            package[num_byte_dirst_index] = (index >> len_uint8) & mask_convert_16t08; // первая часть индекса
-            package[num_byte_subindex] = subIndex; // под индекс 
-            
-            return 1;
+
+            PdoPlan& plan = pdoPlans[pdoPlanCount];
+            plan.firstSignal = pdoSignalCount;
+            plan.signalCount = count;
+            plan.expectedLen = (shift + len_uint8 - 1) / len_uint8; // длина пакета в байтах, как в маппинге узла
+            shift = 0;
+            for (int i = 0; i < count; i++) {
+                PdoField& field = pdoFields[plan.firstSignal + i];
+                field.shift = static_cast<uint8_t>(shift);
+                field.bits = static_cast<uint8_t>(bitLengths[i]);
+                field.type = static_cast<uint8_t>(dataTypes[i]);
+                field.mask = bitLengths[i] == max_pdo_bits ? ~0ULL : ((1ULL << bitLengths[i]) - 1);
+                signalValues[plan.firstSignal + i].store(0.0, std::memory_order_relaxed);
+                shift += bitLengths[i];
+            }
+            pdoPlanIndex[cobid] = pdoPlanCount++;
+            pdoSignalCount += count;
+            return plan.firstSignal;
         }
 
         /**
-            * @brief Метод верификации ответа на наш запрос SDO.
-            * @param package Массив в котором находится пакет.
-            * @param receiverId Id получателя которому отправляли запрос.
-            * @param index Индекс SDO объекта.
-            * @param subIndex Под индекс SDO объекта.
-            * @return 1 - наш пакет -1 - НЕ наш пакет.
+            * @brief Метод чтения согласованных последних значений сигналов одного PDO.
+            * @param cobid cobid PDO.
+            * @param values Массив для значений сигналов.
+            * @param max Размер массива.
+            * @param updateCount Количество принятых пакетов этого cobid (может быть nullptr).
+            * @param timestamp_ns Время приема последнего пакета, steady_clock (может быть nullptr).
+            * @return количество сигналов -2 - у cobid нет маппинга.
         */
-        int verifySDO(unsigned char* package, int receiverId, int index, int subIndex) {
+        int ReadPDOSignals(int cobid, double* values, int max, uint32_t* updateCount, uint64_t* timestamp_ns) {
+            if (cobid < zero_len || cobid > max_cobid || pdoPlanIndex[cobid] == no_pdo_mapping) return -2;
+            PdoPlan& plan = pdoPlans[pdoPlanIndex[cobid]];
+            int count = std::min(plan.signalCount, std::max(max, zero_len));
+            uint32_t updates;
+            uint64_t timestamp;
+            readPlan(plan, values, count, updates, timestamp);
+            if (updateCount != nullptr) *updateCount = updates;
+            if (timestamp_ns != nullptr) *timestamp_ns = timestamp;
+            return plan.signalCount;
+        }
+
+        /**
+            * @brief Метод чтения всей таблицы последних значений сигналов (номер сигнала - индекс массива).
+            * Значения каждого PDO согласованы между собой.
+            * @param values Массив для значений сигналов.
+            * @param max Размер массива.
+            * @return количество скопированных сигналов.
+        */
+        int ReadSignalTable(double* values, int max) {
+            int copied = 0;
+            for (int p = 0; p < pdoPlanCount; p++) {
+                PdoPlan& plan = pdoPlans[p];
+                if (plan.firstSignal + plan.signalCount > max) break;
+                uint32_t updates;
+                uint64_t timestamp;
+                readPlan(plan, values + plan.firstSignal, plan.signalCount, updates, timestamp);
+                copied = plan.firstSignal + plan.signalCount;
+            }
+            return copied;
+        }
+
+        /**
+            * @brief Метод включения трассировки задержек принятых пакетов по этапам: прием ядром (SO_TIMESTAMPNS),
+            * поток чтения, передача потребителю, очередь и выполнение callback'а, пробуждение ожидающего SDO.
+            * Вызывается до подключения.
+            * @param sampleEvery trace_disabled - выключить, 0 - только гистограммы этапов, N - еще и каждый N пакет в выборочную трассу.
+            * @param traceRecords Размер кольца выборочной трассы, 0 - default_trace_records.
+            * @return 1 - успешно -1 - поток чтения уже запущен -2 - неверный sampleEvery -3 - неверный размер трассы.
+        */
+        int EnableLatencyTrace(int sampleEvery, int traceRecords) {
+            if (isConnected) return -1; // контекст трассировки пишет поток чтения без блокировок
+            if (sampleEvery < trace_disabled) return -2;
+            if (traceRecords < zero_len || traceRecords > max_trace_records) return -3;
+            std::lock_guard<std::mutex> lock(traceMutex);
+            traceEnabled = sampleEvery != trace_disabled;
+            traceEvery = sampleEvery > zero_len ? static_cast<uint32_t>(sampleEvery) : 0;
+            traceCountdown = traceEvery;
+            traceRing.assign(traceEvery != 0 ? (traceRecords != zero_len ? traceRecords : default_trace_records) : 0, TraceRecord{});
+            traceHead = traceTail = 0;
+            return 1;
+        }
+
+        /**
+            * @brief Метод получения разбивки задержек по этапам trace_stage_*.
+            * @param stats Структура статистики.
+            * @return 1 - успешно -2 - stats nullptr.
+        */
+        int GetTraceStats(TraceStats* stats) {
+            if (stats == nullptr) return -2;
+            stats->stamped = traceStamped.load(std::memory_order_relaxed);
+            stats->unstamped = traceUnstamped.load(std::memory_order_relaxed);
+            for (int stage = 0; stage < trace_stage_count; stage++) traceStages[stage].read(&stats->stages[stage]);
+            std::lock_guard<std::mutex> lock(traceMutex);
+            stats->sampled = traceSampled;
+            stats->dropped = traceDropped;
+            return 1;
+        }
+
+        /**
+            * @brief Метод чтения накопленных записей выборочной трассы (прочитанные удаляются), от старых к новым.
+            * @param out Массив записей.
+            * @param max Размер массива.
+            * @return количество записей -2 - out nullptr.
+        */
+        int ReadTrace(TraceRecord* out, int max) {
+            if (out == nullptr && max > zero_len) return -2;
+            std::lock_guard<std::mutex> lock(traceMutex);
+            int count = 0;
+            for (; count < max && traceTail != traceHead; count++, traceTail++) out[count] = traceRing[traceTail % traceRing.size()];
+            return count;
+        }
+
+        /**
+            * @brief Метод настройки доставки EMCY в errorbuffer и callback_error при шторме ошибок: повторы одной ошибки
+            * и сверх лимита отбрасываются сразу в потоке чтения. Состояние ошибок узлов (ReadEmcyTable) и образ процесса
+            * обновляются каждым пакетом. Можно вызывать в любой момент, новые настройки действуют со следующего emcy.
+            * @param mode emcy_deliver_all или emcy_deliver_on_change.
+            * @param maxPerSecond Лимит доставки emcy одного узла в секунду, 0 - без лимита.
+            * @return 1 - успешно -2 - неверный режим -3 - неверный лимит.
+        */
+        int SetEmcyFilter(int mode, int maxPerSecond) {
+            if (mode != emcy_deliver_all && mode != emcy_deliver_on_change) return -2;
+            if (maxPerSecond < zero_len || maxPerSecond > max_emcy_rate) return -3;
+            emcyMode.store(mode, std::memory_order_relaxed); // поток чтения читает настройки без блокировок
+            emcyRate.store(static_cast<uint32_t>(maxPerSecond), std::memory_order_relaxed);
+            return 1;
+        }
+
+        /**
+            * @brief Метод чтения таблицы ошибок: состояние каждого узла, приславшего хотя бы один EMCY, в порядке возрастания ID.
+            * @param out Таблица состояний.
+            * @param max Размер таблицы.
+            * @return количество узлов с emcy (в таблицу попадает не больше max) -2 - out nullptr.
+        */
+        int ReadEmcyTable(EmcyState* out, int max) {
+            if (out == nullptr && max > zero_len) return -2;
+            int found = 0;
+            for (int node = min_node_id; node <= max_node_id; node++) {
+                if (emcyNodes[node].total.load(std::memory_order_acquire) == 0) continue;
+                if (found < max) readEmcyNode(node, out + found);
+                found++;
+            }
+            return found;
+        }
+
+        /**
+            * @brief Метод включения кэша SDO: ReadSDO отвечает из кэша, пока объект не устарел по ttl и узел не прислал boot-up
+            * или не сменил состояние NMT. Любая завершенная expedited передача (ReadSDO, WriteSDO, Submit*SDO + CompleteSDO, пакеты) обновляет кэш, прочие записи удаляют объект из кэша.
+            * Можно вызывать в любой момент.
+            * @param ttl_ms Время жизни объекта в миллисекундах, sdo_cache_ttl_forever - бесконечно, 0 - выключить кэш и очистить его.
+            * @return 1 - успешно -3 - неверный ttl.
+        */
+        int EnableSDOCache(int ttl_ms) {
+            if (ttl_ms < sdo_cache_ttl_forever) return -3;
+            std::lock_guard<std::mutex> lock(sdoCacheMutex);
+            sdoCacheTtl_ns = ttl_ms < 0 ? -1 : static_cast<int64_t>(ttl_ms) * us_in_ms * ns_in_us;
+            if (ttl_ms == 0) sdoCache.clear();
+            sdoCacheEnabled.store(ttl_ms != 0, std::memory_order_relaxed);
+            return 1;
+        }
+
+        /**
+            * @brief Метод задания ttl объектов одного индекса (например, постоянные identity и маппинги дольше измеряемых значений).
+            * Действует на объекты, попавшие в кэш после вызова.
+            * @param index Индекс объектов.
+            * @param ttl_ms Время жизни в миллисекундах, sdo_cache_ttl_forever - бесконечно, 0 - индекс не кэшируется, sdo_cache_ttl_default - снять переопределение.
+            * @return 1 - успешно -2 - неверный индекс -3 - неверный ttl.
+        */
+        int SetSDOCacheTTL(int index, int ttl_ms) {
+            if (index < zero_len || index > max_od_index) return -2;
+            if (ttl_ms < sdo_cache_ttl_default) return -3;
+            std::lock_guard<std::mutex> lock(sdoCacheMutex);
+            if (ttl_ms == sdo_cache_ttl_default) sdoCacheIndexTtl_ns.erase(index);
+            else sdoCacheIndexTtl_ns[index] = ttl_ms < 0 ? -1 : static_cast<int64_t>(ttl_ms) * us_in_ms * ns_in_us;
+            return 1;
+        }
+
+        /**
+            * @brief Метод удаления из кэша SDO объектов узла.
+            * @param node ID узла или sdo_cache_all_nodes.
+            * @return количество удаленных объектов -3 - неверный id узла.
+        */
+        int InvalidateSDOCache(int node) {
+            if (node != sdo_cache_all_nodes && (node < min_node_id || node > max_node_id)) return -3;
+            std::lock_guard<std::mutex> lock(sdoCacheMutex);
+            size_t before = sdoCache.size();
+            if (node == sdo_cache_all_nodes) sdoCache.clear();
+            for (auto it = sdoCache.begin(); it != sdoCache.end();) {
+                if (static_cast<int>(it->first >> 32) == node) it = sdoCache.erase(it); else ++it;
+            }
+            int removed = static_cast<int>(before - sdoCache.size());
+            sdoCacheInvalidations += removed;
+            return removed;
+        }
+
+        /**
+            * @brief Метод получения статистики кэша SDO.
+            * @param stats Структура статистики.
+            * @return 1 - успешно -2 - stats nullptr.
+        */
+        int GetSDOCacheStats(SdoCacheStats* stats) {
+            if (stats == nullptr) return -2;
+            std::lock_guard<std::mutex> lock(sdoCacheMutex);
+            *stats = SdoCacheStats{};
+            stats->hits = sdoCacheHits;
+            stats->misses = sdoCacheMisses;
+            stats->stale = sdoCacheStale;
+            stats->writeThrough = sdoCacheWriteThrough;
+            stats->invalidations = sdoCacheInvalidations;
+            stats->entries = static_cast<uint32_t>(sdoCache.size());
+            return 1;
+        }
+
+        /**
+            * @brief Метод включения агрегации сигналов PDO по окнам: поток чтения считает min/max/среднее/последнее значение
+            * каждого сигнала за окно, вызывающему достаточно читать готовые агрегаты раз в окно через ReadAggregates.
+            * Вызывается до подключения, после RegisterPDOMapping.
+            * @param cobid cobid PDO с маппингом.
+            * @param window_ms Длина окна в миллисекундах, 0 - выключить агрегацию.
+            * @return 1 - успешно -1 - поток чтения уже запущен -2 - у cobid нет маппинга -3 - неверная длина окна.
+        */
+        int EnableAggregation(int cobid, int window_ms) {
+            if (isConnected) return -1; // накопители пишет поток чтения без блокировок
+            if (cobid < zero_len || cobid > max_cobid || pdoPlanIndex[cobid] == no_pdo_mapping) return -2;
+            if (window_ms < zero_len || window_ms > max_aggregate_window_ms) return -3;
+
+            PdoPlan& plan = pdoPlans[pdoPlanIndex[cobid]];
+            plan.window_ns = static_cast<uint64_t>(window_ms) * us_in_ms * ns_in_us;
+            plan.windowEnd_ns = 0; // первое окно начнется с первого пакета
+            plan.aggregateEnd_ns.store(0, std::memory_order_relaxed);
+            for (int i = plan.firstSignal; i < plan.firstSignal + plan.signalCount; i++) {
+                signalWindows[i] = SignalWindow{};
+                aggregateCount[i].store(0, std::memory_order_relaxed);
+            }
+            return 1;
+        }
+
+        /**
+            * @brief Метод чтения агрегатов всех сигналов за последнее завершенное окно их PDO.
+            * Агрегаты каждого PDO согласованы между собой.
+            * @param out Массивы по max элементов (индекс - номер сигнала).
+            * @param max Размер массивов.
+            * @return количество скопированных сигналов -2 - неверные аргументы.
+        */
+        int ReadAggregates(AggregateArrays* out, int max) {
+            if (out == nullptr) return -2;
+            int copied = 0;
+            for (int p = 0; p < pdoPlanCount; p++) {
+                PdoPlan& plan = pdoPlans[p];
+                if (plan.firstSignal + plan.signalCount > max) break;
+                readAggregates(plan, out);
+                copied = plan.firstSignal + plan.signalCount;
+            }
+            return copied;
+        }
+
+        /**
+            * @brief Метод копирования образа процесса без блокировки потока чтения.
+            * Копируются только cobid, от которых был принят хотя бы один пакет, в порядке возрастания cobid.
+            * Каждая запись согласована, но записи могут относиться к немного разным моментам времени.
+            * @param out Массив для записей.
+            * @param max Размер массива в записях.
+            * @return количество скопированных записей.
+        */
+        int SnapshotProcessImage(ProcessImageEntry* out, int max) {
+            int count = 0;
+            for (int cobid = min_cobid_error; cobid <= max_cobid_pdo && count < max; cobid++) {
+                ImageSlot* slot = imageSlot(cobid);
+                if (slot == nullptr || slot->updates.load(std::memory_order_relaxed) == 0) continue; // ничего не принимали
+                readImageSlot(*slot, cobid, &out[count++]);
+            }
+            return count;
+        }
+
+        /**
+            * @brief Метод чтения одного cobid из образа процесса.
+            * @param cobid cobid PDO или EMCY.
+            * @param entry Структура для состояния cobid.
+            * @return 1 - успешно -2 - cobid вне образа процесса.
+        */
+        int ReadProcessImageEntry(int cobid, ProcessImageEntry* entry) {
+            ImageSlot* slot = imageSlot(cobid);
+            if (slot == nullptr) return -2;
+            readImageSlot(*slot, cobid, entry);
+            return 1;
+        }
+
+        /**
+            * @brief Метод настройки маршрута принятых пакетов в таблице cobid.
+            * Маршрут применяется ко всем cobid, у которых (cobid & mask) == (id & mask). На SocketCAN таблица
+            * передается в фильтры ядра, отброшенные cobid до потока чтения не доходят.
+            * Переопределение ответов SDO (0x581..0x5FF) ломает SDO запросы к этим узлам.
+            * @param cobid cobid подписки.
+            * @param mask Маска сравнения (0x7FF - один cobid, 0 - все).
+            * @param mode subscribe_default, subscribe_drop, subscribe_latest, subscribe_ring или subscribe_callback.
+            * @param cb Callback для subscribe_callback (формат буфера как у callback_pdo).
+            * @return количество cobid с новым маршрутом -1 - неверный режим -2 - неверный cobid или нет callback'а
+            * -3 - кольцевой буфер PDO не включен.
+        */
+        int Subscribe(int cobid, int mask, int mode, CallbackFunc cb) {
+            if (mode < subscribe_default || mode > subscribe_callback) return -1;
+            if (cobid < 0 || cobid > max_cobid || (mode == subscribe_callback && cb == nullptr)) return -2;
+            if (mode == subscribe_ring && pdoRing.empty()) return -3;
+
+            mask &= max_cobid;
+            int count = 0;
+            for (int id = 0; id <= max_cobid; id++) {
+                if ((id & mask) != (cobid & mask)) continue;
+                uint8_t route;
+                switch (mode) {
+                    case subscribe_drop: route = route_drop; break;
+                    case subscribe_latest: route = route_latest; break;
+                    case subscribe_ring: route = route_ring; break;
+                    case subscribe_callback: route = route_callback; break;
+                    default: route = defaultRoute(id); break;
+                }
+                if ((route == route_latest || route == route_ring) && imageSlot(id) == nullptr) continue; // образ процесса есть только у pdo и emcy
+                routeCallback[id].store(mode == subscribe_callback ? cb : nullptr, std::memory_order_relaxed);
+                routeMode[id].store(route, std::memory_order_release); // callback виден потоку чтения раньше маршрута
+                count++;
+            }
+            if (isConnected && transport == transport_socketcan) applyKernelFilter();
+            return count;
+        }
+
+        /**
+            * @brief Метод передачи сокета в общий поток ввода-вывода вместо собственного потока чтения.
+            * Вызывается до ConnectToUDPServer, nullptr возвращает собственный поток.
+            * @param shared Общий поток.
+            * @return 1 - успешно -1 - уже подключены.
+        */
+        int AttachReactor(Reactor* shared) {
+            if (isConnected) return -1;
+            reactor = shared;
+            return 1;
+        }
+
+        /**
+            * @brief Метод для старта выдачи heartbeat.
+            * @param period_ms Период выдачи heartbeat в миллисекундах.
+        */
+        int Start_heartbeat(int period_ms) {
+            period_heartbeat_ms = period_ms;
+            send_heartbeat = true;
+            scheduleHeartbeat();
+            return 1;
+        };
+
+        /**
+            * @brief Метод для остановки выдачи heartbeat.
+        */
+        int Stop_heartbeat() {
+            send_heartbeat = false;
+            scheduleHeartbeat();
+            return 1;
+        };
+
+        /**
+            * @brief Метод завершения сеанса связи, остановка потока чтения и закрытия сокета.
+            * @return 1 - успешно -1 - не подключены.
+        */
+        int Disconnect() {
+            if (isConnected) {
+                if (cyclicRunning) StopCyclic(); // поток отправки не должен писать в закрываемый сокет
+                isConnected = false;
+                {
+                    std::lock_guard<std::mutex> lock(sdoMutex);
+                    for (SdoTransfer& transfer : sdoTable) {
+                        if (transfer.active) releaseSDO(transfer); // ожидающие ответа получат -3 сразу, а не по таймауту
+                    }
+                }
+                if (reactor) {
+                    if (heartbeatTimer != no_timer) reactor->RemoveTimer(heartbeatTimer);
+                    heartbeatTimer = no_timer;
+                    reactor->Remove(udpSocket); // после возврата общий поток к сокету не обращается
+                }
+                if (readThread.joinable()) { // проверяем что можем завершить поток
+                    readThread.join(); // Дожидаемся завершения потока
+                }
+                if (heartbeatThread.joinable()) { // проверяем что можем завершить поток
+                    heartbeatThread.join(); // Дожидаемся завершения потока
+                }
+                stopTxSender(); // после потока чтения, он тоже ставит пакеты в очередь
+                stopCallbackExecutor(); // после потока чтения, он ставит callback'и в очереди
+                closesocket(udpSocket); // закрываем сокет
+                WSACleanup(); // завершаем операции сокетов
+            } else {
+                return -1; 
+            }
+            return 1;
+        }
+
+    private:
+        /**
+            * Экземпляр сокета для приема/отправки данных.
+        */
+        SOCKET udpSocket;
+        /**
+            * Структура адреса сервера для UDP-соединения. 
+            * Содержит адрес и порт для подключения к серверу.
+        */
+        sockaddr_in serverAddr;
+
+        /**
+            * Транспорт сокета: transport_udp (socat) или transport_socketcan.
+        */
+        int transport = transport_udp;
+
+        /**
+            * Флаг активности подключения. 
+            * Если значение true, соединение установлено и активно.
+        */
+        std::atomic<bool> isConnected;
+
+        /**
+            * Поток для чтения данных. 
+            * Поток используется для асинхронного получения данных через сокет.
+        */
+        std::thread readThread;
+
+        /**
+            * Поток для отправки heartbeat
+        */
+        std::thread heartbeatThread;
+
+        /**
+            * Пачка принятых датаграмм и их длины.
+        */
+        unsigned char rxFrames[recv_batch_size][udp_len_package];
+        int rxLengths[recv_batch_size];
+        uint64_t rxKernelNs[recv_batch_size] = {}; // время приема ядром (steady_clock), 0 - нет отметки
+
+        /**
+            * Общий буфер чтения. Указывает на разбираемый пакет из пачки rxFrames. 
+            * Используется для дальнейшего распределения пакетов SDO чтения и записи.
+        */
+        unsigned char* readBuffer = rxFrames[0];
+
+        /**
+            * Счетчики системных вызовов и датаграмм приема/передачи.
+        */
+        alignas(cache_line_size) std::atomic<uint64_t> rxSyscalls{0};
+        std::atomic<uint64_t> rxFrames_total{0};
+        alignas(cache_line_size) std::atomic<uint64_t> txSyscalls{0};
+        std::atomic<uint64_t> txFrames{0};
+
+        /**
+            * Счетчики пакетов по классам и событий потока чтения (GetStats).
+        */
+        alignas(cache_line_size) std::atomic<uint64_t> rxByClass[frame_class_count] = {};
+        std::atomic<uint64_t> listenerWakeups{0};
+        std::atomic<uint64_t> idleWakeups{0};
+        std::atomic<uint64_t> shortDatagrams{0};
+        std::atomic<uint64_t> sdoUnmatched{0};
+        alignas(cache_line_size) std::atomic<uint64_t> txByClass[frame_class_count] = {};
+        std::atomic<uint64_t> sdoTimeouts{0};
+        std::atomic<uint64_t> sdoAborts{0};
+
+        /**
+            * Последний heartbeat/boot-up каждого узла (индекс - ID узла), пишет поток чтения.
+        */
+        alignas(cache_line_size) std::atomic<uint64_t> heartbeatTime[max_node_id + 1] = {}; // 0 - heartbeat не было
+        std::atomic<uint8_t> heartbeatState[max_node_id + 1] = {};
+        std::atomic<uint32_t> nodeGeneration[max_node_id + 1] = {}; // растет при boot-up и смене состояния NMT узла
+
+        /**
+            * Объект словаря в кэше SDO: ответ в формате выходного массива ReadSDO.
+        */
+        struct SdoCacheEntry {
+            unsigned char answer[max_count_byte_payload + distination_byte_sdo_read_r];
+            uint64_t expires_ns;                    // 0 - не устаревает по времени
+            uint32_t generation;                    // nodeGeneration узла при записи в кэш
+        };
+
+        /**
+            * Кэш SDO (ключ - sdoCacheKey) с ttl по индексам и счетчики, все под sdoCacheMutex.
+        */
+        std::atomic<bool> sdoCacheEnabled{false};
+        std::mutex sdoCacheMutex;
+        std::unordered_map<uint64_t, SdoCacheEntry> sdoCache;
+        std::unordered_map<int, int64_t> sdoCacheIndexTtl_ns; // индекс -> ttl, 0 - индекс не кэшируется
+        int64_t sdoCacheTtl_ns = 0;                 // ttl по умолчанию, < 0 - бесконечный
+        uint64_t sdoCacheHits = 0;
+        uint64_t sdoCacheMisses = 0;
+        uint64_t sdoCacheStale = 0;
+        uint64_t sdoCacheWriteThrough = 0;
+        uint64_t sdoCacheInvalidations = 0;
+
+        /**
+            * Гистограмма задержек, пишет один поток, читать можно из любого.
+        */
+        struct Histogram {
+            std::atomic<uint64_t> count{0};
+            std::atomic<uint64_t> sum_ns{0};
+            std::atomic<uint64_t> buckets[latency_buckets] = {};
+
+            void record(uint64_t ns) {
+                count.fetch_add(1, std::memory_order_relaxed);
+                sum_ns.fetch_add(ns, std::memory_order_relaxed);
+                buckets[latencyBucket(ns)].fetch_add(1, std::memory_order_relaxed);
+            }
+
+            void read(LatencyHistogram* out) const {
+                out->count = count.load(std::memory_order_relaxed);
+                out->sum_ns = sum_ns.load(std::memory_order_relaxed);
+                for (int i = 0; i < latency_buckets; i++) out->buckets[i] = buckets[i].load(std::memory_order_relaxed);
+            }
+
+            void reset() {
+                count.store(0, std::memory_order_relaxed);
+                sum_ns.store(0, std::memory_order_relaxed);
+                for (std::atomic<uint64_t>& bucket : buckets) bucket.store(0, std::memory_order_relaxed);
+            }
+        };
+
+        /**
+            * Гистограммы задержки expedited SDO по узлам, [0] - все узлы.
+        */
+        Histogram sdoLatency[max_node_id + 1];
+
+        /**
+            * Гистограмма времени выполнения callback'ов.
+        */
+        Histogram callbackLatency;
+
+        /**
+            * Пакет в очереди потока callback'ов: буфер в формате callback'а и время приема.
+        */
+        struct CallbackItem {
+            uint64_t timestamp_ns;
+            uint64_t kernel_ns;                     // время приема ядром, если пакет трассируется
+            uint64_t dispatched_ns;                 // время постановки в очередь, 0 - пакет не трассируется
+            bool sampled;                           // пакет попадает в выборочную трассу
+            CallbackFunc cb;
+            unsigned char buffer[udp_len_package];
+        };
+
+        /**
+            * Очередь одного потока callback'ов: пишет поток чтения, читает поток callback'ов (без блокировок).
+            * Мьютекс нужен только чтобы разбудить уснувший поток.
+        */
+        struct CallbackLane {
+            std::vector<CallbackItem> items;
+            alignas(cache_line_size) std::atomic<uint32_t> head{0};     // пишет поток чтения
+            alignas(cache_line_size) std::atomic<uint32_t> tail{0};     // пишет поток callback'ов
+            std::atomic<uint32_t> coalescePending{0};                  // cobid потока, ждущих последнего значения из образа процесса
+            std::atomic<bool> sleeping{false};
+            std::atomic<bool> stop{false};
+            std::mutex mutex;
+            std::condition_variable ready;
+            std::thread thread;
+        };
+
+        /**
+            * Потоки callback'ов (EnableCallbackExecutor), поток cobid - cobid % callbackThreads.
+        */
+        CallbackLane callbackLanes[max_callback_threads];
+        int callbackThreads = 0;
+        uint32_t callbackMask = 0;
+        int callbackPolicy = callback_policy_drop;
+        uint64_t callbackLate_ns = static_cast<uint64_t>(default_callback_late_us) * ns_in_us;
+        bool callbackRunning = false; // потоки запущены, без них (воспроизведение записи) callback'и вызываются сразу
+        std::atomic<uint8_t> callbackDirty[max_cobid + 1] = {}; // callback_format_* cobid, ждущего последнего значения
+        std::atomic<CallbackFunc> callbackDirtyCb[max_cobid + 1] = {};
+        alignas(cache_line_size) std::atomic<uint64_t> callbackEnqueued{0};
+        std::atomic<uint64_t> callbackDropped{0};
+        std::atomic<uint64_t> callbackCoalesced{0};
+        std::atomic<uint32_t> callbackHighWater{0};
+        alignas(cache_line_size) std::atomic<uint64_t> callbackDelivered{0};
+        std::atomic<uint64_t> callbackLateCount{0};
+        Histogram callbackDelay; // от приема пакета до вызова callback
+
+        /**
+            * Трассировка задержек по этапам (EnableLatencyTrace). Контекст текущего пакета frame* пишет только поток чтения,
+            * гистограммы - поток чтения и потоки callback'ов, выборочную трассу - они же под traceMutex.
+        */
+        bool traceEnabled = false;
+        uint32_t traceEvery = 0;                    // в трассу попадает каждый traceEvery пакет, 0 - только гистограммы
+        uint32_t traceCountdown = 0;
+        bool frameTracing = false;                  // пакет принят сокетом (не воспроизведение записи и не бенчмарк)
+        bool frameSampled = false;                  // пакет попадает в выборочную трассу
+        bool frameTotalDeferred = false;            // конец пути пакета запишет поток callback'ов или ожидающий sdo
+        bool frameRecordDeferred = false;           // запись трассы пакета сделает поток callback'ов
+        uint64_t frameKernelNs = 0;
+        uint64_t frameDispatched = 0;
+        uint64_t frameCallbackEntered = 0;
+        uint64_t frameCallbackReturned = 0;
+        Histogram traceStages[trace_stage_count];
+        std::atomic<uint64_t> traceStamped{0};
+        std::atomic<uint64_t> traceUnstamped{0};
+        std::mutex traceMutex;
+        std::vector<TraceRecord> traceRing;         // кольцо выборочной трассы
+        uint64_t traceHead = 0;                     // записей добавлено
+        uint64_t traceTail = 0;                     // записей прочитано
+        uint64_t traceSampled = 0;
+        uint64_t traceDropped = 0;
+
+        /**
+            * Буфер для хранения принятых PDO пакетов.
+        */
+        //unsigned char* pdobuffer;
+
+        unsigned char pdobuffer[udp_len_package];
+
+        /**
+            * Буфер для передачи ошибок с шины.
+        */
+        unsigned char errorbuffer[udp_len_package];
+
+        /**
+            * Состояние ошибок узла (индекс - ID узла): поля под seq пишет поток чтения, окно лимита доставки - только он.
+        */
+        struct EmcyNode {
+            std::atomic<uint32_t> seq{0};           // seqlock
+            std::atomic<uint32_t> code{0};          // код ошибки и регистр: code | register << 16
+            std::atomic<uint64_t> occurrences{0};
+            std::atomic<uint64_t> total{0};
+            std::atomic<uint64_t> delivered{0};
+            std::atomic<uint64_t> suppressed{0};
+            std::atomic<uint64_t> firstSeen_ns{0};
+            std::atomic<uint64_t> lastSeen_ns{0};
+            uint64_t windowStart_ns = 0;            // начало секунды лимита доставки
+            uint32_t windowDelivered = 0;           // доставлено в этой секунде
+        };
+        EmcyNode emcyNodes[max_node_id + 1];
+        std::atomic<int> emcyMode{emcy_deliver_all};    // фильтр доставки
+        std::atomic<uint32_t> emcyRate{0};              // лимит доставки узла в секунду, 0 - без лимита
+
+        /**
+            * Слот незавершенного SDO запроса к одному узлу.
+            * Ключ запроса - узел (индекс в таблице), индекс, сабиндекс и направление.
+        */
+        struct SdoTransfer {
+            bool active;                            // запрос отправлен и ждет ответа
+            bool done;                              // поток чтения положил ответ в answer
+            bool write;                             // направление запроса (true - запись)
+            int index;                              // индекс SDO объекта
+            int subIndex;                           // сабиндекс SDO объекта
+            unsigned char answer[udp_len_package];  // принятый ответ
+            std::condition_variable answered;       // сигнал ожидающему потоку о приходе ответа или отмене
+            int mode;                               // expedited, сегментированная или блочная передача
+            int state;                              // шаг протокола многокадровой передачи
+            int result;                             // итог передачи для ожидающего потока
+            unsigned char* buffer;                  // буфер вызывающего для чтения
+            const unsigned char* source;            // данные вызывающего для записи
+            uint32_t size;                          // емкость buffer или размер source
+            uint32_t total;                         // размер объекта по данным узла (0 - неизвестен)
+            uint32_t offset;                        // передано байт
+            uint32_t blockStart;                    // смещение начала отправленного блока записи
+            uint8_t toggle;                         // ожидаемый бит переключения сегмента
+            uint8_t blockSize;                      // количество сегментов в блоке
+            uint8_t seqno;                          // ожидаемый номер сегмента блока чтения
+            bool crc;                               // узел поддерживает crc блочной передачи
+            bool last;                              // последний сегмент блока принят
+            uint32_t abortCode;                     // код прерывания
+            unsigned char written[max_count_byte_payload]; // данные expedited записи для кэша SDO
+            int writtenSize;                        // их размер
+            uint32_t generation;                    // nodeGeneration узла при отправке запроса
+            uint64_t progress;                      // счетчик принятых кадров, продлевает таймаут ожидающего потока
+            std::chrono::steady_clock::time_point started; // время начала передачи
+            uint64_t elapsed_ns;                    // длительность завершенной передачи
+            uint64_t answered_ns;                   // время приема завершившего пакета, если он трассировался, иначе 0
+            uint64_t kernel_ns;                     // время приема этого пакета ядром
+        };
+
+        /**
+            * Таблица незавершенных SDO запросов, по одному слоту на узел.
+            * Поток чтения раскладывает ответы по слотам, ожидающие потоки забирают их.
+        */
+        SdoTransfer sdoTable[max_node_id + 1] = {};
+
+        /**
+            * Мьютекс таблицы незавершенных SDO запросов.
+        */
+        std::mutex sdoMutex;
+
+        /**
+            * Счетчик событий таблицы SDO (ответ разложен или слот освобожден) для пакетных запросов.
+        */
+        uint64_t sdoEvents = 0;
+
+        /**
+            * Сигнал пакетным запросам об изменении счетчика событий таблицы SDO.
+        */
+        std::condition_variable sdoEvent;
+
+        /**
+            * Количество сегментов в блоке блочного чтения.
+        */
+        int sdoBlockSize = max_sdo_block_size;
+
+        /**
+            * Пакеты SDO, которые поток чтения отправляет в ответ на принятый пакет (после снятия sdoMutex, для завершенной передачи - под ним).
+        */
+        unsigned char sdoTx[max_sdo_block_size + 1][udp_len_package];
+        int sdoTxCount = 0;
+
+        /**
+            * Скомпилированный сигнал маппинга PDO.
+        */
+        struct PdoField {
+            uint64_t mask;                          // маска значения после сдвига
+            uint8_t shift;                          // номер первого бита сигнала в payload
+            uint8_t bits;                           // длина сигнала в битах
+            uint8_t type;                           // тип сигнала
+        };
+
+        /**
+            * План разбора PDO одного cobid: непрерывный участок pdoFields и signalValues.
+            * Поток чтения пишет значения под seqlock, читатели повторяют чтение если seq поменялся.
+        */
+        struct PdoPlan {
+            int firstSignal;                        // номер первого сигнала
+            int signalCount;                        // количество сигналов
+            int expectedLen;                        // ожидаемая длина пакета в байтах
+            std::atomic<uint32_t> seq{0};           // нечетное значение - идет запись
+            std::atomic<uint32_t> updates{0};       // количество принятых пакетов
+            std::atomic<uint64_t> timestamp_ns{0};  // время приема последнего пакета
+            uint64_t window_ns = 0;                 // длина окна агрегации, 0 - агрегации нет
+            uint64_t windowEnd_ns = 0;              // конец текущего окна, пишет только поток чтения
+            std::atomic<uint32_t> aggregateSeq{0};  // seqlock завершенного окна
+            std::atomic<uint64_t> aggregateEnd_ns{0}; // конец завершенного окна
+        };
+
+        /**
+            * Номер плана разбора для каждого cobid или no_pdo_mapping.
+        */
+        int16_t pdoPlanIndex[max_cobid + 1];
+
+        /**
+            * Планы разбора, сигналы и таблица последних значений сигналов.
+        */
+        PdoPlan pdoPlans[max_pdo_mappings];
+        PdoField pdoFields[max_pdo_signals];
+        std::atomic<double> signalValues[max_pdo_signals];
+
+        /**
+            * Накопители текущего окна агрегации (пишет только поток чтения) и агрегаты завершенного окна (под aggregateSeq плана).
+        */
+        struct SignalWindow {
+            double min;
+            double max;
+            double sum;
+            double last;
+            uint32_t count;
+        };
+        SignalWindow signalWindows[max_pdo_signals];
+        std::atomic<double> aggregateMin[max_pdo_signals];
+        std::atomic<double> aggregateMax[max_pdo_signals];
+        std::atomic<double> aggregateMean[max_pdo_signals];
+        std::atomic<double> aggregateLast[max_pdo_signals];
+        std::atomic<uint32_t> aggregateCount[max_pdo_signals];
+        int pdoPlanCount = 0;
+        int pdoSignalCount = 0;
+
+        /**
+            * Количество пакетов с маппингом, длина которых не совпала с маппингом.
+        */
+        std::atomic<uint64_t> pdoLengthErrors{0};
+
+        /**
+            * Время приема разбираемого пакета (steady_clock), нс.
+        */
+        uint64_t frameTimestamp = 0;
+
+        /**
+            * Таблица маршрутов принятых пакетов по cobid (route_*), callback'и подписок и классы пакетов для счетчиков.
+        */
+        std::atomic<uint8_t> routeMode[max_cobid + 1];
+        std::atomic<CallbackFunc> routeCallback[max_cobid + 1];
+        uint8_t frameClassTable[max_cobid + 1];
+
+        /**
+            * Флаг воспроизведения записи трафика, разбор пакетов разрешен без подключения.
+        */
+        bool replaying = false;
+
+        /**
+            * Запись трафика: пакеты копируются в captureActive, заполненный буфер меняется местами с captureSpare
+            * и сбрасывается в файл фоновым потоком. Если фоновый поток не успел, пакеты теряются, а не задерживают прием.
+        */
+        std::atomic<bool> capturing{false};
+        std::mutex captureMutex;
+        std::condition_variable captureReady;
+        std::vector<CaptureRecord> captureActive;
+        std::vector<CaptureRecord> captureSpare;
+        size_t captureFill = 0;                 // заполнено записей в captureActive
+        size_t captureSpareCount = 0;           // записей к сбросу в captureSpare
+        bool captureFlushPending = false;       // captureSpare принадлежит фоновому потоку
+        bool captureStop = false;
+        uint64_t captureRecords = 0;
+        uint64_t captureDropped = 0;
+        uint64_t captureFlushes = 0;
+        FILE* captureFile = nullptr;
+        std::thread captureThread;
+
+        /**
+            * Слот образа процесса: последний пакет cobid под seqlock, по одному слоту на кэш-линию.
+        */
+        struct alignas(cache_line_size) ImageSlot {
+            std::atomic<uint32_t> seq{0};           // нечетное значение - идет запись
+            std::atomic<uint32_t> updates{0};       // количество принятых пакетов
+            std::atomic<uint64_t> payload{0};       // payload последнего пакета
+            std::atomic<uint64_t> timestamp_ns{0};  // время приема последнего пакета
+            std::atomic<uint8_t> len{0};            // количество значимых байт
+        };
+
+        /**
+            * Образ процесса: слоты PDO (min_cobid_pdo..max_cobid_pdo), затем слоты EMCY (min_cobid_error..max_cobid_error).
+        */
+        ImageSlot processImage[image_slots];
+
+        /**
+            * Сегмент общей памяти, в который дублируется образ процесса и журнал принятых пакетов (PublishSharedImage).
+        */
+        SharedImage* sharedImage = nullptr;
+
+        /**
+            * Кольцевой буфер принятых PDO (один писатель - поток чтения, один читатель - DrainPDO).
+            * Пустой буфер означает, что PDO отдаются через callback_pdo.
+        */
+        std::vector<PdoRecord> pdoRing;
+
+        /**
+            * Маска индекса кольцевого буфера PDO (размер - степень двойки).
+        */
+        uint32_t pdoRingMask = 0;
+
+        /**
+            * Счетчик записанных в кольцевой буфер PDO записей, пишет только поток чтения.
+        */
+        alignas(cache_line_size) std::atomic<uint32_t> pdoRingHead{0};
+
+        /**
+            * Счетчик выбранных из кольцевого буфера PDO записей, пишет только потребитель.
+        */
+        alignas(cache_line_size) std::atomic<uint32_t> pdoRingTail{0};
+
+        /**
+            * Статистика кольцевого буфера PDO, пишет только поток чтения.
+        */
+        alignas(cache_line_size) std::atomic<uint64_t> pdoRingPushed{0};
+        std::atomic<uint64_t> pdoRingOverflows{0};
+        std::atomic<uint32_t> pdoRingHighWater{0};
+
+        /**
+            * Период выдачи heartbeat.
+        */
+        int period_heartbeat_ms = 1000;
+
+        /**
+            * Флаг отправки heartbeat.
+        */
+        bool send_heartbeat = false;
+
+        /**
+            * Общий поток ввода-вывода (nullptr - собственный поток чтения).
+        */
+        Reactor* reactor = nullptr;
+
+        /**
+            * Таймер heartbeat в колесе общего потока.
+        */
+        int heartbeatTimer = no_timer;
+
+        /**
+            * Пакет в очереди отправки.
+        */
+        struct TxEntry {
+            unsigned char frame[udp_len_package];
+            uint64_t enqueued_ns;                   // время постановки в очередь
+        };
+
+        /**
+            * Очередь отправки одного класса: кольцо с ограничением скорости.
+        */
+        struct TxQueue {
+            std::vector<TxEntry> entries;
+            size_t head = 0;                        // первый неотправленный пакет
+            size_t size = 0;                        // пакетов ждет отправки
+            size_t highWater = 0;
+            uint64_t enqueued = 0;
+            uint64_t sent = 0;
+            uint64_t dropped = 0;
+            int rate = 0;                           // пакетов в секунду, 0 - без ограничения
+            int burst = 0;                          // емкость token bucket
+            double tokens = 0;                      // доступные разрешения
+            uint64_t refilled_ns = 0;               // время последнего пополнения разрешений
+        };
+
+        /**
+            * Очереди отправки по классам tx_class_*, порядок классов и поток отправки.
+            * Очереди, счетчики и настройки защищены txMutex.
+        */
+        bool txQueueEnabled = false;
+        TxQueue txQueues[tx_class_count];
+        int txOrder[tx_class_count];
+        uint8_t txClassTable[max_cobid + 1];
+        uint64_t txBatches = 0;
+        Histogram txLatency[tx_class_count];
+        std::mutex txMutex;
+        std::condition_variable txReady;
+        bool txStop = false;
+        std::thread txThread;
+
+        /**
+            * TPDO циклической отправки под seqlock: пишут AddCyclicPDO/UpdateCyclicPDO/RemoveCyclicPDO под cyclicMutex,
+            * читает поток CyclicSender без блокировки.
+        */
+        struct alignas(cache_line_size) CyclicSlot {
+            std::atomic<uint32_t> seq{0};           // нечетное значение - идет запись
+            std::atomic<bool> active{false};        // TPDO зарегистрирован
+            std::atomic<uint16_t> cobid{0};         // cobid TPDO
+            std::atomic<uint8_t> len{0};            // количество действительных байт
+            std::atomic<uint8_t> divider{1};        // отправка раз в divider периодов
+            std::atomic<uint64_t> payload{0};       // данные TPDO
+        };
+        CyclicSlot cyclicSlots[max_cyclic_pdos];
+        std::mutex cyclicMutex;
+        int cyclicCount = 0;
+
+        /**
+            * Поток циклической отправки и его настройки.
+        */
+        std::thread cyclicThread;
+        std::atomic<bool> cyclicRunning{false};
+        int cyclicPeriod_us = 0;
+        bool cyclicSync = false;
+
+        /**
+            * Счетчики потока циклической отправки, пишет только CyclicSender.
+        */
+        alignas(cache_line_size) std::atomic<uint64_t> cyclicCycles{0};
+        std::atomic<uint64_t> cyclicOverruns{0};
+        std::atomic<uint64_t> cyclicFrames{0};
+        std::atomic<uint64_t> cyclicErrors{0};
+        std::atomic<uint64_t> cyclicMaxLateness{0};
+        Histogram cyclicLateness;
+
+        /**
+         * Callback для получения pdo пакета.
+        */
+        CallbackFunc callback_pdo;
+
+        /**
+         * Callback для получения ошибки с шины.
+        */
+        CallbackFunc callback_error;
+
+        /**
+            * @brief Метод прослушивания сокета и распределения пакетов SDO/PDO.
+        */
+        void PacketListener() {
+            fd_set readSet;
+
+            auto start = std::chrono::steady_clock::now();
+
+            while (isConnected) {
+                // проверяем доступность данных
+                FD_ZERO(&readSet); // настраеваем фд для работы select
+                FD_SET(udpSocket, &readSet);
+                timeval timeout; // select на POSIX уменьшает таймаут, поэтому задаем его на каждой итерации
+                timeout.tv_sec = 0;
+                timeout.tv_usec = listener_poll_us;
+                int result = select(static_cast<int>(udpSocket) + 1, &readSet, nullptr, nullptr, &timeout);
+
+                //данные доступны
+                if (result > data_not_exist && FD_ISSET(udpSocket, &readSet)) {
+                    serviceSocket();
+                } else {
+                    idleWakeups.fetch_add(1, std::memory_order_relaxed);
+                }
+
+                if (send_heartbeat){
+                    if (timeout_SDO_answer(start, period_heartbeat_ms)) {
+                        sendHeartbeat();
+                        start = std::chrono::steady_clock::now();
+                    }
+                }
+            }
+        }
+
+        /**
+            * @brief Метод запуска приема после подключения транспорта: свой поток чтения или регистрация в общем потоке.
+            * @return 1 - успешно -1 - общий поток не принял сокет (сокет закрывается).
+        */
+        int startListening() {
+            isConnected = true;
+#ifdef SO_TIMESTAMPNS
+            if (traceEnabled) {
+                int enable = 1;
+                setsockopt(udpSocket, SOL_SOCKET, SO_TIMESTAMPNS, (const char*)&enable, sizeof(enable)); // время приема ядром в каждой датаграмме
+            }
+#endif
+            if (txQueueEnabled) {
+                int buffer = tx_socket_buffer;
+                setsockopt(udpSocket, SOL_SOCKET, SO_SNDBUF, (const char*)&buffer, sizeof(buffer)); // короткая очередь ядра, иначе пачка PDO снова обгонит SDO
+                txStop = false;
+                txThread = std::thread(&Worker::TxSender, this);
+            }
+            for (int t = 0; t < callbackThreads; t++) {
+                callbackLanes[t].stop.store(false, std::memory_order_relaxed);
+                callbackLanes[t].thread = std::thread(&Worker::CallbackExecutor, this, t);
+            }
+            callbackRunning = callbackThreads > 0;
+            if (reactor) { // сокет обслуживает общий поток
+                if (reactor->Add(udpSocket, [this] { serviceSocket(); }) < 0) {
+                    isConnected = false;
+                    stopTxSender();
+                    stopCallbackExecutor();
+                    closesocket(udpSocket);
+                    WSACleanup();
+                    return -1;
+                }
+                scheduleHeartbeat();
+                return 1;
+            }
+            readThread = std::thread(&Worker::PacketListener, this);
+            //heartbeatThread = std::thread(&Worker::Sending_heartbeat, this);
+            return 1;
+        }
+
+        /**
+            * @brief Метод остановки потока отправки, неотправленные пакеты считаются потерянными.
+        */
+        void stopTxSender() {
+            if (!txThread.joinable()) return;
+            {
+                std::lock_guard<std::mutex> lock(txMutex);
+                txStop = true;
+            }
+            txReady.notify_one();
+            txThread.join();
+        }
+
+        /**
+            * @brief Метод остановки потоков callback'ов, пакеты, оставшиеся в очередях, считаются потерянными.
+            * Вызывается после остановки потока чтения.
+        */
+        void stopCallbackExecutor() {
+            for (int t = 0; t < callbackThreads; t++) {
+                CallbackLane& lane = callbackLanes[t];
+                if (!lane.thread.joinable()) continue;
+                {
+                    std::lock_guard<std::mutex> lock(lane.mutex);
+                    lane.stop.store(true, std::memory_order_relaxed);
+                }
+                lane.ready.notify_one();
+                lane.thread.join();
+            }
+            callbackRunning = false;
+        }
+
+        /**
+            * @brief Метод вызова callback'а пакета: сразу в потоке чтения или через очередь потока callback'ов.
+            * @param cb Callback.
+            * @param buffer Буфер callback'а (pdobuffer или errorbuffer).
+            * @param format callback_format_*.
+        */
+        void invokeCallback(CallbackFunc cb, unsigned char* buffer, uint8_t format) {
+            if (callbackRunning) {
+                if (frameTracing) frameDispatched = steadyNs(); // передача потоку callback'ов
+                if (enqueueCallback(cb, buffer, format) && frameTracing) frameTotalDeferred = frameRecordDeferred = true;
+                return;
+            }
+            uint64_t start = steadyNs();
+            cb(buffer);
+            uint64_t end = steadyNs();
+            callbackLatency.record(end - start);
+            if (frameTracing) {
+                frameDispatched = frameCallbackEntered = start;
+                frameCallbackReturned = end;
+                traceStages[trace_stage_callback_run].record(end - start);
+            }
+        }
+
+        /**
+            * @brief Метод постановки callback'а пакета readBuffer в очередь потока его cobid (производитель, поток чтения).
+            * Пока cobid ждет последнего значения из образа процесса, его новые пакеты в очередь не ставятся,
+            * иначе более старое значение из образа пришло бы после них.
+            * @return true - пакет поставлен в очередь, false - отброшен или отдан образу процесса.
+        */
+        bool enqueueCallback(CallbackFunc cb, const unsigned char* buffer, uint8_t format) {
+            int cobid = ((readBuffer[first_cobid_byte] << len_uint8) | readBuffer[second_cobid_byte]) & max_cobid;
+            if (callbackDirty[cobid].load(std::memory_order_acquire) != 0) { // образ процесса уже обновлен, поток вызовет callback с ним
+                callbackCoalesced.fetch_add(1, std::memory_order_relaxed);
+                return false;
+            }
+            CallbackLane& lane = callbackLanes[cobid % callbackThreads];
+            uint32_t head = lane.head.load(std::memory_order_relaxed);
+            uint32_t used = head - lane.tail.load(std::memory_order_acquire);
+            if (used > callbackMask) { // поток callback'ов не успевает
+                if (callbackPolicy == callback_policy_coalesce && imageSlot(cobid) != nullptr) {
+                    callbackDirtyCb[cobid].store(cb, std::memory_order_relaxed);
+                    callbackDirty[cobid].store(format, std::memory_order_release);
+                    lane.coalescePending.fetch_add(1, std::memory_order_release);
+                    callbackCoalesced.fetch_add(1, std::memory_order_relaxed);
+                } else {
+                    callbackDropped.fetch_add(1, std::memory_order_relaxed);
+                }
+                return false;
+            }
+
+            CallbackItem& item = lane.items[head & callbackMask];
+            item.timestamp_ns = frameTimestamp;
+            item.kernel_ns = frameKernelNs;
+            item.dispatched_ns = frameTracing ? frameDispatched : 0;
+            item.sampled = frameTracing && frameSampled;
+            item.cb = cb;
+            std::memcpy(item.buffer, buffer, udp_len_package);
+            lane.head.store(head + 1, std::memory_order_seq_cst); // публикуем запись, seq_cst - пара к проверке sleeping
+            callbackEnqueued.fetch_add(1, std::memory_order_relaxed);
+            if (used + 1 > callbackHighWater.load(std::memory_order_relaxed)) callbackHighWater.store(used + 1, std::memory_order_relaxed);
+            if (lane.sleeping.load(std::memory_order_seq_cst)) {
+                std::lock_guard<std::mutex> lock(lane.mutex);
+                lane.ready.notify_one();
+            }
+            return true;
+        }
+
+        /**
+            * @brief Метод потока callback'ов: вызывает callback'и своей очереди по порядку, затем callback'и cobid,
+            * которые ждут последнего значения из образа процесса.
+            * @param index Номер потока.
+        */
+        void CallbackExecutor(int index) {
+            CallbackLane& lane = callbackLanes[index];
+            while (true) {
+                uint32_t pending = lane.coalescePending.load(std::memory_order_acquire); // до head: все пакеты cobid, поставленные раньше, уже видны
+                uint32_t tail = lane.tail.load(std::memory_order_relaxed);
+                uint32_t head = lane.head.load(std::memory_order_acquire);
+                if (lane.stop.load(std::memory_order_relaxed)) {
+                    callbackDropped.fetch_add(head - tail, std::memory_order_relaxed);
+                    lane.tail.store(head, std::memory_order_release);
+                    break;
+                }
+                if (tail == head && pending == 0) {
+                    std::unique_lock<std::mutex> lock(lane.mutex);
+                    lane.sleeping.store(true, std::memory_order_seq_cst);
+                    if (!lane.stop.load(std::memory_order_relaxed) && lane.head.load(std::memory_order_seq_cst) == tail &&
+                        lane.coalescePending.load(std::memory_order_relaxed) == 0) {
+                        lane.ready.wait_for(lock, std::chrono::milliseconds(callback_idle_ms));
+                    }
+                    lane.sleeping.store(false, std::memory_order_relaxed);
+                    continue;
+                }
+                for (; tail != head && !lane.stop.load(std::memory_order_relaxed); tail++) {
+                    CallbackItem& item = lane.items[tail & callbackMask];
+                    runCallback(item.cb, item.buffer, item.timestamp_ns, &item);
+                    lane.tail.store(tail + 1, std::memory_order_release); // освобождаем место сразу, а не после всей пачки
+                }
+                if (pending > 0) deliverCoalesced(index);
+            }
+        }
+
+        /**
+            * @brief Метод вызова callback'ов cobid потока, которые ждут последнего значения из образа процесса.
+            * @param index Номер потока.
+        */
+        void deliverCoalesced(int index) {
+            CallbackLane& lane = callbackLanes[index];
+            for (int cobid = index; cobid <= max_cobid; cobid += callbackThreads) {
+                uint8_t format = callbackDirty[cobid].exchange(0, std::memory_order_acq_rel);
+                if (format == 0) continue;
+                lane.coalescePending.fetch_sub(1, std::memory_order_relaxed);
+                ProcessImageEntry entry;
+                readImageSlot(*imageSlot(cobid), cobid, &entry);
+                unsigned char buffer[udp_len_package] = {};
+                buffer[first_cobid_outer_buf] = cobid & mask_cobid;
+                buffer[second_cobid_outer_buf] = cobid >> len_uint8;
+                if (format == callback_format_pdo) {
+                    buffer[num_pdo_buffer_len_payload] = entry.len;
+                    std::memcpy(buffer + num_pdo_buffer_payload, entry.data, max_len_pdo_payload);
+                } else {
+                    std::memcpy(buffer + num_byte_error_payload, entry.data, max_len_pdo_payload);
+                }
+                runCallback(callbackDirtyCb[cobid].load(std::memory_order_relaxed), buffer, entry.timestamp_ns);
+            }
+        }
+
+        /**
+            * @brief Метод вызова callback'а в потоке callback'ов с учетом задержки от приема пакета.
+            * @param item Элемент очереди с контекстом трассировки, nullptr - значение из образа процесса.
+        */
+        void runCallback(CallbackFunc cb, unsigned char* buffer, uint64_t timestamp_ns, const CallbackItem* item = nullptr) {
+            uint64_t start = steadyNs();
+            uint64_t delay = start > timestamp_ns ? start - timestamp_ns : 0;
+            callbackDelay.record(delay);
+            if (delay > callbackLate_ns) callbackLateCount.fetch_add(1, std::memory_order_relaxed);
+            cb(buffer);
+            uint64_t end = steadyNs();
+            callbackLatency.record(end - start);
+            callbackDelivered.fetch_add(1, std::memory_order_relaxed);
+            if (item != nullptr && item->dispatched_ns != 0) traceCallback(*item, start, end);
+        }
+
+        /**
+            * @brief Метод записи этапов пакета, путь которого закончился в потоке callback'ов.
+            * @param item Элемент очереди пакета.
+            * @param entered Время вызова callback'а.
+            * @param returned Время возврата из callback'а.
+        */
+        void traceCallback(const CallbackItem& item, uint64_t entered, uint64_t returned) {
+            traceStages[trace_stage_callback_wait].record(entered > item.dispatched_ns ? entered - item.dispatched_ns : 0);
+            traceStages[trace_stage_callback_run].record(returned - entered);
+            traceStages[trace_stage_total].record(returned - traceOrigin(item.kernel_ns, item.timestamp_ns));
+            if (!item.sampled) return;
+            TraceRecord record = {};
+            record.cobid = item.buffer[first_cobid_outer_buf] | (item.buffer[second_cobid_outer_buf] << len_uint8);
+            record.kernel_ns = item.kernel_ns;
+            record.received_ns = item.timestamp_ns;
+            record.dispatched_ns = item.dispatched_ns;
+            record.callbackEntered_ns = entered;
+            record.callbackReturned_ns = returned;
+            pushTrace(record);
+        }
+
+        /**
+            * @brief Метод начала трассировки пакета readBuffer, принятого сокетом.
+            * @param kernel_ns Время приема ядром, 0 - нет отметки.
+        */
+        void beginTrace(uint64_t kernel_ns) {
+            frameTracing = true;
+            frameKernelNs = kernel_ns;
+            frameDispatched = frameCallbackEntered = frameCallbackReturned = 0;
+            frameTotalDeferred = frameRecordDeferred = false;
+            if (kernel_ns != 0) {
+                traceStamped.fetch_add(1, std::memory_order_relaxed);
+                traceStages[trace_stage_kernel].record(frameTimestamp > kernel_ns ? frameTimestamp - kernel_ns : 0);
+            } else {
+                traceUnstamped.fetch_add(1, std::memory_order_relaxed);
+            }
+            frameSampled = traceEvery != 0 && --traceCountdown == 0;
+            if (frameSampled) traceCountdown = traceEvery;
+        }
+
+        /**
+            * @brief Метод завершения трассировки пакета readBuffer после его обработчика.
+        */
+        void endTrace() {
+            if (frameDispatched == 0) frameDispatched = steadyNs(); // обработчик без callback'а: пакет передан, когда обработчик вернулся
+            traceStages[trace_stage_dispatch].record(frameDispatched - frameTimestamp);
+            if (!frameTotalDeferred) {
+                uint64_t end = frameCallbackReturned != 0 ? frameCallbackReturned : frameDispatched;
+                traceStages[trace_stage_total].record(end - traceOrigin(frameKernelNs, frameTimestamp));
+            }
+            if (frameSampled && !frameRecordDeferred) {
+                TraceRecord record = {};
+                record.cobid = (static_cast<uint32_t>(readBuffer[first_cobid_byte]) << len_uint8) | readBuffer[second_cobid_byte];
+                record.kernel_ns = frameKernelNs;
+                record.received_ns = frameTimestamp;
+                record.dispatched_ns = frameDispatched;
+                record.callbackEntered_ns = frameCallbackEntered;
+                record.callbackReturned_ns = frameCallbackReturned;
+                pushTrace(record);
+            }
+            frameTracing = false;
+            frameKernelNs = 0;
+        }
+
+        /**
+            * @brief Метод записи этапа ожидания ответа SDO, вызывается ожидающим потоком под sdoMutex.
+            * @param transfer Завершенная передача.
+        */
+        void traceSdoWake(SdoTransfer& transfer) {
+            uint64_t now = steadyNs();
+            traceStages[trace_stage_sdo_wake].record(now > transfer.answered_ns ? now - transfer.answered_ns : 0);
+            traceStages[trace_stage_total].record(now - traceOrigin(transfer.kernel_ns, transfer.answered_ns));
+            transfer.answered_ns = 0;
+        }
+
+        /**
+            * @brief Метод получения начала пути пакета: время приема ядром, если оно есть и не позже приема потоком чтения.
+        */
+        static uint64_t traceOrigin(uint64_t kernel_ns, uint64_t received_ns) {
+            return kernel_ns != 0 && kernel_ns <= received_ns ? kernel_ns : received_ns;
+        }
+
+        /**
+            * @brief Метод добавления записи в кольцо выборочной трассы, при переполнении затирается самая старая.
+        */
+        void pushTrace(const TraceRecord& record) {
+            std::lock_guard<std::mutex> lock(traceMutex);
+            if (traceRing.empty()) return;
+            if (traceHead - traceTail == traceRing.size()) {
+                traceTail++;
+                traceDropped++;
+            }
+            traceRing[traceHead % traceRing.size()] = record;
+            traceHead++;
+            traceSampled++;
+        }
+
+        /**
+            * @brief Адрес получателя пакетов: socat для udp, для SocketCAN адрес не нужен (сокет привязан к интерфейсу).
+        */
+        sockaddr* peerAddr() {
+            return transport == transport_udp ? (sockaddr*)&serverAddr : nullptr;
+        }
+        socklen_t peerAddrLen() {
+            return transport == transport_udp ? sizeof(serverAddr) : 0;
+        }
+
+        /**
+            * @brief Метод отправки пакета узлам с записью в файл трафика.
+            * При включенной очереди отправки пакет только ставится в очередь своего класса.
+            * @param frame Пакет udp_len_package байт.
+            * @return результат sendto (udp_len_package - поставлен в очередь, SOCKET_ERROR - очередь заполнена).
+        */
+        int sendFrame(const unsigned char* frame) {
+            if (txQueueEnabled) return enqueueFrames(reinterpret_cast<const unsigned char (*)[udp_len_package]>(frame), 1) == 1 ? udp_len_package : SOCKET_ERROR;
+            if (capturing.load(std::memory_order_relaxed)) captureFrame(frame, capture_dir_tx, steadyNs()); // без записи время не запрашиваем
+            txByClass[frameClassTable[((frame[first_cobid_byte] << len_uint8) | frame[second_cobid_byte]) & max_cobid]].fetch_add(1, std::memory_order_relaxed);
+            return sendto(udpSocket, (const char*)frame, udp_len_package, 0, peerAddr(), peerAddrLen());
+        }
+
+        /**
+            * @brief Метод отправки пачки пакетов узлам с записью в файл трафика.
+            * На Linux пачка уходит одним sendmmsg, на Windows каждый пакет через sendto.
+            * @param packets Пакеты udp_len_package байт.
+            * @param count Количество пакетов (не больше send_batch_size).
+            * @return количество отправленных пакетов, SOCKET_ERROR - не отправлен ни один.
+        */
+        int transmitFrames(const unsigned char (*packets)[udp_len_package], int count) {
+#ifdef __linux__
+            mmsghdr msgs[send_batch_size] = {};
+            iovec iov[send_batch_size];
+            for (int i = 0; i < count; i++) {
+                iov[i].iov_base = const_cast<unsigned char*>(packets[i]);
+                iov[i].iov_len = udp_len_package;
+                msgs[i].msg_hdr.msg_name = peerAddr();
+                msgs[i].msg_hdr.msg_namelen = peerAddrLen();
+                msgs[i].msg_hdr.msg_iov = &iov[i];
+                msgs[i].msg_hdr.msg_iovlen = 1;
+            }
+            int result = sendmmsg(udpSocket, msgs, count, 0);
+            txSyscalls.fetch_add(1, std::memory_order_relaxed);
+            for (int i = 0; i < result; i++) {
+                txByClass[frameClassTable[((packets[i][first_cobid_byte] << len_uint8) | packets[i][second_cobid_byte]) & max_cobid]].fetch_add(1, std::memory_order_relaxed);
+            }
+            if (capturing.load(std::memory_order_relaxed)) {
+                uint64_t timestamp = steadyNs();
+                for (int i = 0; i < result; i++) captureFrame(packets[i], capture_dir_tx, timestamp);
+            }
+#else
+            int result = 0;
+            for (int i = 0; i < count; i++) {
+                if (capturing.load(std::memory_order_relaxed)) captureFrame(packets[i], capture_dir_tx, steadyNs());
+                txByClass[frameClassTable[((packets[i][first_cobid_byte] << len_uint8) | packets[i][second_cobid_byte]) & max_cobid]].fetch_add(1, std::memory_order_relaxed);
+                int sendResult = sendto(udpSocket, (const char*)packets[i], udp_len_package, 0, peerAddr(), peerAddrLen());
+                txSyscalls.fetch_add(1, std::memory_order_relaxed);
+                if (sendResult == SOCKET_ERROR) {
+                    if (result == 0) result = SOCKET_ERROR;
+                    break;
+                }
+                result++;
+            }
+#endif
+            return result;
+        }
+
+        /**
+            * @brief Метод постановки пакетов в очереди отправки их классов.
+            * @param packets Пакеты udp_len_package байт.
+            * @param count Количество пакетов.
+            * @return количество поставленных пакетов, SOCKET_ERROR - не поставлен ни один.
+        */
+        int enqueueFrames(const unsigned char (*packets)[udp_len_package], int count) {
+            uint64_t timestamp = steadyNs();
+            int queued = 0;
+            {
+                std::lock_guard<std::mutex> lock(txMutex);
+                for (int i = 0; i < count; i++) {
+                    TxQueue& queue = txQueues[txClassTable[((packets[i][first_cobid_byte] << len_uint8) | packets[i][second_cobid_byte]) & max_cobid]];
+                    if (queue.size == queue.entries.size()) { // очередь класса заполнена, пакет теряется, а не ждет
+                        queue.dropped++;
+                        continue;
+                    }
+                    TxEntry& entry = queue.entries[(queue.head + queue.size) % queue.entries.size()];
+                    std::memcpy(entry.frame, packets[i], udp_len_package);
+                    entry.enqueued_ns = timestamp;
+                    queue.size++;
+                    queue.enqueued++;
+                    queue.highWater = std::max(queue.highWater, queue.size);
+                    queued++;
+                }
+            }
+            if (queued > 0) txReady.notify_one();
+            return queued > 0 ? queued : SOCKET_ERROR;
+        }
+
+        /**
+            * @brief Метод потока отправки: пачка набирается из очередей в порядке приоритета классов с учетом ограничения скорости.
+            * Пока сокет занят отправкой пачки, новые пакеты с высоким приоритетом встают в начало следующей пачки.
+        */
+        void TxSender() {
+            unsigned char packets[send_batch_size][udp_len_package];
+            uint64_t enqueued[send_batch_size];
+            int classes[send_batch_size];
+            std::unique_lock<std::mutex> lock(txMutex);
+            while (!txStop) {
+                uint64_t now = steadyNs();
+                uint64_t nextToken = 0; // ближайшее время появления разрешения у ограниченного класса с пакетами
+                int count = 0;
+                for (int rank = 0; rank < tx_class_count && count < send_batch_size; rank++) {
+                    TxQueue& queue = txQueues[txOrder[rank]];
+                    refillTokens(queue, now);
+                    while (queue.size > 0 && count < send_batch_size) {
+                        if (queue.rate > 0 && queue.tokens < 1.0) {
+                            uint64_t wait = static_cast<uint64_t>((1.0 - queue.tokens) * ms_in_sec * us_in_ms * ns_in_us / queue.rate) + 1;
+                            if (nextToken == 0 || now + wait < nextToken) nextToken = now + wait;
+                            break;
+                        }
+                        if (queue.rate > 0) queue.tokens -= 1.0;
+                        TxEntry& entry = queue.entries[queue.head];
+                        std::memcpy(packets[count], entry.frame, udp_len_package);
+                        enqueued[count] = entry.enqueued_ns;
+                        classes[count++] = txOrder[rank];
+                        queue.head = (queue.head + 1) % queue.entries.size();
+                        queue.size--;
+                    }
+                }
+                if (count == 0) {
+                    if (nextToken == 0) txReady.wait(lock); // ждем новых пакетов
+                    else txReady.wait_for(lock, std::chrono::nanoseconds(nextToken - now)); // ждем разрешения ограниченного класса
+                    continue;
+                }
+
+                lock.unlock();
+                int result = transmitFrames(packets, count);
+                uint64_t sentAt = steadyNs();
+                lock.lock();
+                txBatches++;
+                for (int i = 0; i < count; i++) {
+                    if (i < result) {
+                        txQueues[classes[i]].sent++;
+                        txLatency[classes[i]].record(sentAt - enqueued[i]);
+                    } else {
+                        txQueues[classes[i]].dropped++; // ошибка сокета, повторять не будем
+                    }
+                }
+            }
+            for (TxQueue& queue : txQueues) { // отключились, неотправленное теряется
+                queue.dropped += queue.size;
+                queue.size = 0;
+            }
+        }
+
+        /**
+            * @brief Метод пополнения разрешений ограниченного класса, вызывается под txMutex.
+        */
+        static void refillTokens(TxQueue& queue, uint64_t now) {
+            if (queue.rate <= 0) return;
+            queue.tokens = std::min<double>(queue.burst, queue.tokens + (now - queue.refilled_ns) * queue.rate / (static_cast<double>(ms_in_sec) * us_in_ms * ns_in_us));
+            queue.refilled_ns = now;
+        }
+
+        /**
+            * @brief Метод определения класса очереди отправки по cobid.
+            * @param cobid cobid пакета.
+            * @return tx_class_*.
+        */
+        static int txClass(int cobid) {
+            if (cobid == 0 || cobid == sync_cobid) return tx_class_nmt;
+            if (cobid >= min_cobid_error && cobid <= max_cobid_error) return tx_class_emcy;
+            if (cobid > receive_cobid && cobid <= send_cobid + max_node_id) return tx_class_sdo;
+            if (cobid > (id_heartbeat << len_uint8) && cobid <= (id_heartbeat << len_uint8) + max_node_id) return tx_class_heartbeat;
+            return tx_class_pdo;
+        }
+
+        /**
+            * @brief Метод копирования пакета в буфер записи трафика.
+            * @param frame Пакет udp_len_package байт.
+            * @param direction capture_dir_rx или capture_dir_tx.
+            * @param timestamp_ns Время приема/отправки.
+        */
+        void captureFrame(const unsigned char* frame, uint8_t direction, uint64_t timestamp_ns) {
+            if (!capturing.load(std::memory_order_relaxed)) return;
+            std::lock_guard<std::mutex> lock(captureMutex);
+            if (captureFill == captureActive.size()) {
+                if (captureFlushPending) { // фоновый поток еще пишет прошлый буфер
+                    captureDropped++;
+                    return;
+                }
+                swapCaptureBuffers();
+            }
+            CaptureRecord& record = captureActive[captureFill++];
+            record.timestamp_ns = timestamp_ns;
+            record.direction = direction;
+            std::memcpy(record.frame, frame, udp_len_package);
+        }
+
+        /**
+            * @brief Метод передачи заполненного буфера фоновому потоку, вызывается под captureMutex.
+        */
+        void swapCaptureBuffers() {
+            captureActive.swap(captureSpare);
+            captureSpareCount = captureFill;
+            captureFill = 0;
+            captureFlushPending = true;
+            captureReady.notify_one();
+        }
+
+        /**
+            * @brief Метод фонового потока записи трафика: сбрасывает заполненный буфер или раз в capture_flush_ms то, что накопилось.
+        */
+        void CaptureWriter() {
+            std::unique_lock<std::mutex> lock(captureMutex);
+            while (true) {
+                captureReady.wait_for(lock, std::chrono::milliseconds(capture_flush_ms), [this] { return captureStop || captureFlushPending; });
+                if (!captureFlushPending && captureFill > 0) swapCaptureBuffers(); // по таймеру сбрасываем неполный буфер
+                if (captureFlushPending) {
+                    size_t count = captureSpareCount;
+                    lock.unlock();
+                    size_t written = std::fwrite(captureSpare.data(), sizeof(CaptureRecord), count, captureFile); // одна запись на буфер, а не на пакет
+                    std::fflush(captureFile);
+                    lock.lock();
+                    captureRecords += written;
+                    captureDropped += count - written;
+                    captureFlushes++;
+                    captureFlushPending = false;
+                    continue; // сразу проверяем, не заполнился ли следующий буфер
+                }
+                if (captureStop) return;
+            }
+        }
+
+        /**
+            * @brief Метод записи TPDO в слот циклической отправки (писатель seqlock), вызывается под cyclicMutex.
+        */
+        void writeCyclicSlot(CyclicSlot& entry, bool active, int cobid, const unsigned char* data, int dataSize, int divider) {
+            uint64_t payload = 0;
+            if (dataSize > zero_len) std::memcpy(&payload, data, dataSize); // незначимые байты остаются нулями
+            seqlockWrite(entry.seq, [&] {
+                entry.cobid.store(static_cast<uint16_t>(cobid), std::memory_order_relaxed);
+                entry.len.store(static_cast<uint8_t>(dataSize), std::memory_order_relaxed);
+                entry.divider.store(static_cast<uint8_t>(divider), std::memory_order_relaxed);
+                entry.payload.store(payload, std::memory_order_relaxed);
+                entry.active.store(active, std::memory_order_relaxed);
+            });
+        }
+
+        /**
+            * @brief Метод согласованного чтения слота циклической отправки (читатель seqlock).
+            * @param entry Слот.
+            * @param record Запись для отправки.
+            * @param divider Делитель периода.
+            * @return true - TPDO зарегистрирован.
+        */
+        bool readCyclicSlot(CyclicSlot& entry, PdoRecord& record, int& divider) {
+            bool active = false;
+            uint64_t payload = 0;
+            seqlockRead(entry.seq, [&] { // пишет Python через UpdateCyclic
+                active = entry.active.load(std::memory_order_relaxed);
+                record.cobid = entry.cobid.load(std::memory_order_relaxed);
+                record.len = entry.len.load(std::memory_order_relaxed);
+                divider = entry.divider.load(std::memory_order_relaxed);
+                payload = entry.payload.load(std::memory_order_relaxed);
+            });
+            std::memcpy(record.data, &payload, sizeof(payload));
+            return active;
+        }
+
+        /**
+            * @brief Метод потока циклической отправки: в каждый срок SYNC и TPDO текущего периода уходят одной пачкой.
+            * Если поток проснулся позже следующего срока, пропущенные периоды не догоняются, а считаются в overruns.
+        */
+        void CyclicSender() {
+#ifdef __linux__
+            sched_param param = {};
+            param.sched_priority = cyclic_priority;
+            pthread_setschedparam(pthread_self(), SCHED_FIFO, &param); // без CAP_SYS_NICE остаемся в обычном планировщике
+#endif
+            const uint64_t period = static_cast<uint64_t>(cyclicPeriod_us) * ns_in_us;
+            std::vector<PdoRecord> frames(max_cyclic_pdos + 1); // память выделяется до первого срока
+            uint64_t cycle = 0;
+            uint64_t deadline = steadyNs() + period;
+            while (cyclicRunning) {
+                sleepUntilNs(deadline);
+                uint64_t lateness = steadyNs() - deadline;
+                cyclicLateness.record(lateness);
+                if (lateness > cyclicMaxLateness.load(std::memory_order_relaxed)) cyclicMaxLateness.store(lateness, std::memory_order_relaxed);
+
+                int count = 0;
+                if (cyclicSync) {
+                    frames[count] = PdoRecord{};
+                    frames[count++].cobid = sync_cobid; // SYNC без данных
+                }
+                for (CyclicSlot& entry : cyclicSlots) {
+                    int divider;
+                    if (!readCyclicSlot(entry, frames[count], divider) || cycle % divider != 0) continue;
+                    count++;
+                }
+                if (count > 0) {
+                    int sent = WritePDOBatch(frames.data(), count);
+                    if (sent < count) cyclicErrors.fetch_add(1, std::memory_order_relaxed);
+                    if (sent > 0) cyclicFrames.fetch_add(sent, std::memory_order_relaxed);
+                }
+                cyclicCycles.fetch_add(1, std::memory_order_relaxed);
+
+                cycle++;
+                deadline += period;
+                uint64_t now = steadyNs();
+                if (now > deadline) { // следующий срок уже прошел, переходим к ближайшему будущему сроку
+                    uint64_t missed = (now - deadline) / period + 1;
+                    cyclicOverruns.fetch_add(missed, std::memory_order_relaxed);
+                    deadline += missed * period;
+                    cycle += missed; // делители TPDO остаются привязаны ко времени
+                }
+            }
+        }
+
+        /**
+            * @brief Метод расчета ячейки гистограммы задержек (описание ячеек у LatencyHistogram).
+            * @param ns Задержка в наносекундах.
+            * @return номер ячейки.
+        */
+        static int latencyBucket(uint64_t ns) {
+            const uint64_t sub = 1 << latency_sub_bits;
+            if (ns < sub) return static_cast<int>(ns);
+            int exponent = 0;
+            for (uint64_t v = ns; v > 1; v >>= 1) exponent++; // номер старшего бита
+            int bucket = (exponent - latency_sub_bits + 1) * sub + ((ns >> (exponent - latency_sub_bits)) & (sub - 1));
+            return std::min(bucket, latency_buckets - 1);
+        }
+
+        /**
+            * @brief Метод определения класса пакета для счетчиков.
+            * @param can_id cobid пакета.
+            * @return frame_class_*.
+        */
+        static int frameClass(uint16_t can_id) {
+            if (can_id >= min_cobid_pdo && can_id <= max_cobid_pdo) return frame_class_pdo;
+            if (can_id > receive_cobid && can_id <= send_cobid + max_node_id) return frame_class_sdo;
+            if (can_id >= min_cobid_error && can_id < max_cobid_error) return frame_class_emcy;
+            return frame_class_other;
+        }
+
+        /**
+            * @brief Метод приема и распределения пачки пакетов, вызывается потоком чтения или общим потоком когда в сокете есть данные.
+        */
+        void serviceSocket() {
+            int count = receiveFrames(); // забираем все накопленные датаграммы за одно пробуждение
+            listenerWakeups.fetch_add(1, std::memory_order_relaxed);
+            for (int i = 0; i < count; i++) {
+                if (!isConnected) break; // callback отключил Worker посреди пачки
+                if (rxLengths[i] < udp_len_package) { // короткая датаграмма, это не can_frame
+                    shortDatagrams.fetch_add(1, std::memory_order_relaxed);
+                    continue;
+                }
+                readBuffer = rxFrames[i];
+                uint64_t timestamp = steadyNs();
+                captureFrame(readBuffer, capture_dir_rx, timestamp);
+                if (!traceEnabled) {
+                    dispatchFrame(timestamp);
+                    continue;
+                }
+                frameTimestamp = timestamp;
+                beginTrace(rxKernelNs[i]);
+                dispatchFrame(timestamp);
+                endTrace();
+            }
+        }
+
+        /**
+            * @brief Метод отправки heartbeat.
+        */
+        void sendHeartbeat() {
+            sendFrame(heartbeat);
+        }
+
+        /**
+            * @brief Метод перестановки таймера heartbeat в колесе общего потока после изменения периода или флага.
+        */
+        void scheduleHeartbeat() {
+            if (!reactor || !isConnected) return; // без общего потока heartbeat отправляет PacketListener
+            if (heartbeatTimer != no_timer) reactor->RemoveTimer(heartbeatTimer);
+            heartbeatTimer = send_heartbeat ? reactor->AddTimer(period_heartbeat_ms, [this] { sendHeartbeat(); }) : no_timer;
+        }
+
+        /**
+            * @brief Метод приема пачки датаграмм в rxFrames, вызывается когда select сообщил о данных.
+            * На Linux пачка забирается одним recvmmsg, на Windows recvfrom повторяется пока в сокете есть данные.
+            * @return количество принятых датаграмм (длины в rxLengths).
+        */
+        int receiveFrames() {
+            int count = 0;
+#ifdef __linux__
+            mmsghdr msgs[recv_batch_size] = {};
+            iovec iov[recv_batch_size];
+            alignas(cmsghdr) char control[recv_batch_size][CMSG_SPACE(sizeof(timespec))]; // SO_TIMESTAMPNS
+            for (int i = 0; i < recv_batch_size; i++) {
+                iov[i].iov_base = rxFrames[i];
+                iov[i].iov_len = udp_len_package;
+                msgs[i].msg_hdr.msg_iov = &iov[i];
+                msgs[i].msg_hdr.msg_iovlen = 1;
+                if (traceEnabled) {
+                    msgs[i].msg_hdr.msg_control = control[i];
+                    msgs[i].msg_hdr.msg_controllen = sizeof(control[i]);
+                }
+            }
+            count = recvmmsg(udpSocket, msgs, recv_batch_size, MSG_DONTWAIT, nullptr);
+            rxSyscalls.fetch_add(1, std::memory_order_relaxed);
+            if (count == SOCKET_ERROR) return 0; // ошибки udp (например ICMP port unreachable) не повод останавливать прием
+            for (int i = 0; i < count; i++) {
+                rxLengths[i] = static_cast<int>(msgs[i].msg_len);
+            }
+            if (traceEnabled) readKernelTimestamps(msgs, count);
+#else
+            unsigned long pending = 1; // select уже сообщил о первой датаграмме
+            while (count < recv_batch_size && pending > 0) {
+                int recvResult = recv(udpSocket, (char*)rxFrames[count], udp_len_package, 0);
+                rxSyscalls.fetch_add(1, std::memory_order_relaxed);
+                if (recvResult == SOCKET_ERROR) break; // ошибки udp (например ICMP port unreachable) не повод останавливать прием
+                rxLengths[count++] = recvResult;
+                if (ioctlsocket(udpSocket, FIONREAD, &pending) == SOCKET_ERROR) break; // есть ли еще датаграммы
+            }
+#endif
+            rxFrames_total.fetch_add(count, std::memory_order_relaxed);
+            return count;
+        }
+
+#ifdef __linux__
+        /**
+            * @brief Метод получения времени приема ядром из SO_TIMESTAMPNS пачки датаграмм в rxKernelNs.
+            * Ядро ставит время CLOCK_REALTIME, оно переводится в steady_clock по разнице часов на момент пачки.
+            * @param msgs Принятые датаграммы.
+            * @param count Количество датаграмм.
+        */
+        void readKernelTimestamps(mmsghdr* msgs, int count) {
+            timespec realtime;
+            clock_gettime(CLOCK_REALTIME, &realtime);
+            int64_t offset = static_cast<int64_t>(realtime.tv_sec) * ms_in_sec * us_in_ms * ns_in_us + realtime.tv_nsec - static_cast<int64_t>(steadyNs());
+            for (int i = 0; i < count; i++) {
+                rxKernelNs[i] = 0;
+                for (cmsghdr* c = CMSG_FIRSTHDR(&msgs[i].msg_hdr); c != nullptr; c = CMSG_NXTHDR(&msgs[i].msg_hdr, c)) {
+                    if (c->cmsg_level != SOL_SOCKET || c->cmsg_type != SCM_TIMESTAMPNS) continue;
+                    timespec stamp;
+                    std::memcpy(&stamp, CMSG_DATA(c), sizeof(stamp));
+                    rxKernelNs[i] = static_cast<uint64_t>(static_cast<int64_t>(stamp.tv_sec) * ms_in_sec * us_in_ms * ns_in_us + stamp.tv_nsec - offset);
+                }
+            }
+        }
+#endif
+
+        /**
+            * @brief Метод классификации принятого пакета readBuffer и передачи его обработчику PDO/SDO/ошибок.
+            * @param timestamp_ns Время приема пакета (steady_clock).
+        */
+        void dispatchFrame(uint64_t timestamp_ns) {
+            frameTimestamp = timestamp_ns; // одно время приема на все обработчики пакета
+            uint16_t can_id = (static_cast<uint16_t>(readBuffer[first_cobid_byte]) << len_uint8) | readBuffer[second_cobid_byte]; //считаем cobid из двух байт принятого пакета
+            if (can_id > max_cobid) { // не 11-битный cobid
+                rxByClass[frame_class_other].fetch_add(1, std::memory_order_relaxed);
+                return;
+            }
+            rxByClass[frameClassTable[can_id]].fetch_add(1, std::memory_order_relaxed);
+            if (sharedImage) journalFrame(can_id);
+            switch (routeMode[can_id].load(std::memory_order_acquire)) { // один переход по таблице вместо цепочки проверок диапазонов
+                case route_pdo:
+                    GetPDO(); // Записываем во внешний массив pdobuffer
+                    break;
+                case route_sdo:
+                    if (GetSDO() == -2) sdoUnmatched.fetch_add(1, std::memory_order_relaxed); // Раскладываем ответ в слот запроса узла
+                    break;
+                case route_emcy:
+                    GetError(); // Записываем ошибку во внешний массив errorbuffer
+                    break;
+                case route_latest:
+                    updateImage(can_id);
+                    if (pdoPlanIndex[can_id] != no_pdo_mapping) decodePDO(pdoPlans[pdoPlanIndex[can_id]]);
+                    break;
+                case route_ring:
+                    updateImage(can_id);
+                    pushPDO();
+                    break;
+                case route_callback:
+                    updateImage(can_id);
+                    deliverCallback(routeCallback[can_id].load(std::memory_order_relaxed));
+                    break;
+                case route_heartbeat: {
+                    int node = can_id & mask_cobid;
+                    uint8_t state = readBuffer[num_byte_payload_pdo] & heartbeat_mask_state;
+                    if (state == node_state_bootup || state != heartbeatState[node].load(std::memory_order_relaxed)) {
+                        nodeGeneration[node].fetch_add(1, std::memory_order_relaxed); // кэш sdo узла устарел
+                    }
+                    heartbeatState[node].store(state, std::memory_order_relaxed);
+                    heartbeatTime[node].store(timestamp_ns, std::memory_order_release); // время после состояния
+                    break;
+                }
+                default: // route_drop
+                    break;
+            }
+        }
+
+        /**
+            * @brief Метод добавления пакета readBuffer в журнал общей памяти.
+            * @param can_id cobid пакета.
+        */
+        void journalFrame(int can_id) {
+            uint64_t payload = 0;
+            std::memcpy(&payload, readBuffer + num_byte_payload_pdo, sizeof(payload));
+            sharedImage->Append(can_id, payload, std::min<uint8_t>(readBuffer[num_byte_len_pdo_package], max_len_pdo_payload), frameTimestamp);
+        }
+
+        /**
+            * @brief Метод маршрута cobid по умолчанию (разбор по диапазонам cobid).
+            * @param cobid cobid.
+            * @return route_pdo, route_sdo, route_emcy, route_heartbeat или route_drop.
+        */
+        static uint8_t defaultRoute(int cobid) {
+            if (cobid >= min_cobid_pdo && cobid <= max_cobid_pdo) return route_pdo;
+            if (cobid > receive_cobid && cobid <= receive_cobid + max_node_id) return route_sdo;
+            if (cobid >= min_cobid_error && cobid < max_cobid_error) return route_emcy;
+            if (cobid > (id_heartbeat << len_uint8) && cobid <= (id_heartbeat << len_uint8) + max_node_id) return route_heartbeat;
+            return route_drop;
+        }
+
+        /**
+            * @brief Метод измерений RunBenchmark, вызывается только на временном Worker.
+            * @return количество результатов.
+        */
+        int benchmark(int iterations, BenchResult* results, int max) {
+            unsigned char pdoFrames[bench_frames][udp_len_package];
+            unsigned char sdoFrames[bench_frames][udp_len_package];
+            unsigned char emcyFrames[bench_frames][udp_len_package];
+            unsigned char mixedFrames[bench_frames][udp_len_package]; // pdo, sdo, emcy и heartbeat вперемешку
+            for (int i = 0; i < bench_frames; i++) {
+                int node = min_node_id + i % max_node_id;
+                benchFrame(pdoFrames[i], tpdo_cobid_base + (i % max_sim_tpdos) * tpdo_cobid_step + node, max_len_pdo_payload, i);
+                benchFrame(sdoFrames[i], receive_cobid + node, len_sdo, i);
+                sdoFrames[i][num_sdo_command] = min_command_sdo_w;
+                sdoFrames[i][num_byte_second_index] = i & mask_convert_16t08;
+                sdoFrames[i][num_byte_dirst_index] = (od_device_type >> len_uint8) & mask_convert_16t08;
+                sdoFrames[i][num_byte_subindex] = i % max_sdo_block_size;
+                benchFrame(emcyFrames[i], emcy_cobid_base + node, max_len_pdo_payload, i);
+                const unsigned char* source[] = {pdoFrames[i], sdoFrames[i], emcyFrames[i], heartbeat};
+                std::memcpy(mixedFrames[i], source[i % 4], udp_len_package);
+            }
+
+            int count = 0;
+            volatile uint32_t sink = 0; // результаты операций, чтобы компилятор не выбросил циклы
+            unsigned char packet[udp_len_package] = {};
+            benchLoop(results, count, max, "make_sdo_head", iterations, [&](int i) {
+                fillSDOhead(packet, i & 1, min_node_id + i % max_node_id, od_device_type | i, i % max_sdo_block_size, max_count_byte_payload);
+                sink = sink + packet[num_sdo_command];
+            });
+            benchLoop(results, count, max, "verify_sdo", iterations, [&](int i) {
+                int slot = i & (bench_frames - 1);
+                sink = sink + verifySDO(sdoFrames[slot], min_node_id + slot % max_node_id, od_device_type | (slot & mask_convert_16t08), slot % max_sdo_block_size);
+            });
+            benchLoop(results, count, max, "classify_ranges", iterations, [&](int i) {
+                const unsigned char* frame = mixedFrames[i & (bench_frames - 1)];
+                sink = sink + frameClass((frame[first_cobid_byte] << len_uint8) | frame[second_cobid_byte]);
+            });
+            benchLoop(results, count, max, "classify_table", iterations, [&](int i) {
+                const unsigned char* frame = mixedFrames[i & (bench_frames - 1)];
+                int can_id = ((frame[first_cobid_byte] << len_uint8) | frame[second_cobid_byte]) & max_cobid;
+                sink = sink + frameClassTable[can_id] + routeMode[can_id].load(std::memory_order_acquire);
+            });
+
+            replaying = true; // GetPDO без подключения работает только при воспроизведении
+            for (int withCallback = 0; withCallback < 2; withCallback++) {
+                callback_pdo = withCallback ? benchCallback : nullptr;
+                callback_error = withCallback ? benchCallback : nullptr;
+                benchLoop(results, count, max, withCallback ? "dispatch_pdo_callback" : "dispatch_pdo", iterations, [&](int i) {
+                    readBuffer = pdoFrames[i & (bench_frames - 1)];
+                    dispatchFrame(i);
+                });
+                benchLoop(results, count, max, withCallback ? "dispatch_emcy_callback" : "dispatch_emcy", iterations, [&](int i) {
+                    readBuffer = emcyFrames[i & (bench_frames - 1)];
+                    dispatchFrame(i);
+                });
+            }
+            return count;
+        }
+
+        /**
+            * @brief Метод заполнения синтетического пакета для RunBenchmark.
+            * @param frame Пакет.
+            * @param cobid cobid пакета.
+            * @param len Длина payload.
+            * @param seed Значение для payload.
+        */
+        static void benchFrame(unsigned char* frame, int cobid, int len, int seed) {
+            std::memset(frame, empty_data, udp_len_package);
+            frame[second_cobid_byte] = cobid & mask_cobid;
+            frame[first_cobid_byte] = cobid >> len_uint8;
+            frame[num_byte_len_pdo_package] = len;
+            for (int b = 0; b < len; b++) frame[num_byte_payload_pdo + b] = static_cast<unsigned char>(seed + b);
+        }
+
+        /**
+            * @brief Пустой callback для измерения стоимости вызова callback в RunBenchmark.
+        */
+        static void benchCallback(unsigned char*) {}
+
+        /**
+            * @brief Метод передачи пакета readBuffer в callback подписки в формате pdobuffer.
+            * @param cb Callback подписки.
+        */
+        void deliverCallback(CallbackFunc cb) {
+            if (cb == nullptr) return;
+            fillPdoBuffer();
+            invokeCallback(cb, pdobuffer, callback_format_pdo);
+        }
+
+        /**
+            * @brief Метод передачи таблицы маршрутов в фильтры CAN_RAW: cobid с маршрутом объединяются в выровненные блоки (id, mask).
+            * Если блоков больше can_max_filters, фильтр снимается и ядро отдает все кадры.
+        */
+        void applyKernelFilter() {
+#ifdef __linux__
+            if (transport != transport_socketcan) return;
+            std::vector<can_filter> filters;
+            addFilterBlocks(0, max_cobid + 1, filters);
+            if (filters.size() > static_cast<size_t>(can_max_filters)) filters.assign(1, can_filter{0, 0}); // принимаем все
+            setsockopt(udpSocket, SOL_CAN_RAW, CAN_RAW_FILTER, filters.empty() ? nullptr : filters.data(), static_cast<socklen_t>(filters.size() * sizeof(can_filter)));
+#endif
+        }
+
+#ifdef __linux__
+        /**
+            * @brief Метод разбиения блока cobid [base, base + size) на фильтры: блок целиком с маршрутом - один фильтр, иначе делим пополам.
+        */
+        void addFilterBlocks(int base, int size, std::vector<can_filter>& filters) {
+            int routed = 0;
+            for (int id = base; id < base + size; id++) {
+                if (routeMode[id].load(std::memory_order_relaxed) != route_drop) routed++;
+            }
+            if (routed == 0) return;
+            if (routed == size) {
+                filters.push_back({static_cast<canid_t>(base), static_cast<canid_t>((max_cobid & ~(size - 1)) | CAN_EFF_FLAG | CAN_RTR_FLAG)}); // только стандартные кадры данных
+                return;
+            }
+            addFilterBlocks(base, size / 2, filters);
+            addFilterBlocks(base + size / 2, size / 2, filters);
+        }
+#endif
+
+        /**
+            * @brief Метод копирования пакета readBuffer в pdobuffer (cobid, длина значимых байт и payload).
+        */
+        void fillPdoBuffer() {
+            pdobuffer[first_cobid_outer_buf] = readBuffer[second_cobid_byte]; // первая часть cobid в перевернутом виде
+            pdobuffer[second_cobid_outer_buf] = readBuffer[first_cobid_byte]; // вторая часть cobid в перевернутом виде
+            pdobuffer[num_pdo_buffer_len_payload] = readBuffer[num_byte_len_pdo_package]; // длина значимых байт
+            std::copy(readBuffer + num_byte_payload_pdo,readBuffer + udp_len_package, pdobuffer+num_pdo_buffer_payload); // записываем содержимое PDO
+        }
+
+        /**
+            * @brief Метод записи данных пакета во внешний буфер pdobuffer (передается cobid, длина значимых байт и сам payload)
+            * @return 1 - успешно -1 - не подключены.
+        */
+        int GetPDO() {
+            if (!isConnected && !replaying) return -1;
+            fillPdoBuffer();
+
+            uint16_t can_id = (static_cast<uint16_t>(readBuffer[first_cobid_byte]) << len_uint8) | readBuffer[second_cobid_byte];
+            updateImage(can_id); // образ процесса хранит последние значения всех PDO
+            if (pdoPlanIndex[can_id & max_cobid] != no_pdo_mapping) { // у cobid есть маппинг, отдаем только разобранные значения
+                return decodePDO(pdoPlans[pdoPlanIndex[can_id & max_cobid]]);
+            }
+
+            if (!pdoRing.empty()) { // включен кольцевой буфер, callback не вызываем
+                return pushPDO();
+            }
+
+            if (callback_pdo) invokeCallback(callback_pdo, pdobuffer, callback_format_pdo);
+            
+            return 1;
+        }
+
+        /**
+            * @brief Метод разбора PDO из readBuffer по плану в таблицу последних значений.
+            * @param plan План разбора cobid пакета.
+            * @return 1 - успешно -2 - длина пакета не совпадает с маппингом.
+        */
+        int decodePDO(PdoPlan& plan) {
+            if (readBuffer[num_byte_len_pdo_package] != plan.expectedLen) {
+                pdoLengthErrors.fetch_add(1, std::memory_order_relaxed);
+                return -2;
+            }
+
+            uint64_t raw = 0; // payload как little-endian число, сигналы вырезаются сдвигом и маской
+            for (int b = 0; b < max_len_pdo_payload; b++) {
+                raw |= static_cast<uint64_t>(readBuffer[num_byte_payload_pdo + b]) << (len_uint8 * b);
+            }
+
+            if (plan.window_ns && frameTimestamp >= plan.windowEnd_ns) closeWindow(plan); // пакет относится уже к следующему окну
+
+            seqlockWrite(plan.seq, [&] {
+                for (int i = 0; i < plan.signalCount; i++) {
+                    const PdoField& field = pdoFields[plan.firstSignal + i];
+                    uint64_t bits = (raw >> field.shift) & field.mask;
+                    double value;
+                    if (field.type == pdo_type_signed) {
+                        if (bits >> (field.bits - 1)) bits |= ~field.mask; // расширяем знак
+                        value = static_cast<double>(static_cast<int64_t>(bits));
+                    } else if (field.type == pdo_type_float32) {
+                        uint32_t word = static_cast<uint32_t>(bits);
+                        float number;
+                        std::memcpy(&number, &word, sizeof(number));
+                        value = number;
+                    } else {
+                        value = static_cast<double>(bits);
+                    }
+                    signalValues[plan.firstSignal + i].store(value, std::memory_order_relaxed);
+                    if (plan.window_ns) accumulateSignal(signalWindows[plan.firstSignal + i], value);
+                }
+                plan.updates.store(plan.updates.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+                plan.timestamp_ns.store(frameTimestamp, std::memory_order_relaxed);
+            });
+            return 1;
+        }
+
+        /**
+            * @brief Метод добавления значения сигнала в накопитель окна.
+        */
+        static void accumulateSignal(SignalWindow& window, double value) {
+            if (window.count == 0 || value < window.min) window.min = value;
+            if (window.count == 0 || value > window.max) window.max = value;
+            window.sum += value;
+            window.last = value;
+            window.count++;
+        }
+
+        /**
+            * @brief Метод завершения окна агрегации плана: публикует накопители (писатель seqlock) и начинает окно пакета readBuffer.
+            * Окна выровнены по времени на длину окна, окна без пакетов пропускаются.
+            * @param plan План разбора.
+        */
+        void closeWindow(PdoPlan& plan) {
+            SignalWindow* windows = signalWindows + plan.firstSignal;
+            if (windows[0].count > 0) {
+                seqlockWrite(plan.aggregateSeq, [&] {
+                    for (int i = 0; i < plan.signalCount; i++) {
+                        int signal = plan.firstSignal + i;
+                        aggregateMin[signal].store(windows[i].min, std::memory_order_relaxed);
+                        aggregateMax[signal].store(windows[i].max, std::memory_order_relaxed);
+                        aggregateMean[signal].store(windows[i].sum / windows[i].count, std::memory_order_relaxed);
+                        aggregateLast[signal].store(windows[i].last, std::memory_order_relaxed);
+                        aggregateCount[signal].store(windows[i].count, std::memory_order_relaxed);
+                    }
+                    plan.aggregateEnd_ns.store(plan.windowEnd_ns, std::memory_order_relaxed);
+                });
+            }
+            for (int i = 0; i < plan.signalCount; i++) windows[i] = SignalWindow{};
+            plan.windowEnd_ns = (frameTimestamp / plan.window_ns + 1) * plan.window_ns;
+        }
+
+        /**
+            * @brief Метод согласованного чтения сигналов плана (читатель seqlock).
+            * @param plan План разбора.
+            * @param values Массив для значений.
+            * @param count Сколько сигналов скопировать.
+            * @param updates Количество принятых пакетов.
+            * @param timestamp Время приема последнего пакета.
+        */
+        void readPlan(PdoPlan& plan, double* values, int count, uint32_t& updates, uint64_t& timestamp) {
+            seqlockRead(plan.seq, [&] {
+                for (int i = 0; i < count; i++) {
+                    values[i] = signalValues[plan.firstSignal + i].load(std::memory_order_relaxed);
+                }
+                updates = plan.updates.load(std::memory_order_relaxed);
+                timestamp = plan.timestamp_ns.load(std::memory_order_relaxed);
+            });
+        }
+
+        /**
+            * @brief Метод согласованного чтения агрегатов плана (читатель seqlock).
+            * @param plan План разбора.
+            * @param out Массивы агрегатов.
+        */
+        void readAggregates(PdoPlan& plan, AggregateArrays* out) {
+            seqlockRead(plan.aggregateSeq, [&] {
+                uint64_t windowEnd = plan.aggregateEnd_ns.load(std::memory_order_relaxed);
+                for (int signal = plan.firstSignal; signal < plan.firstSignal + plan.signalCount; signal++) {
+                    if (out->min != nullptr) out->min[signal] = aggregateMin[signal].load(std::memory_order_relaxed);
+                    if (out->max != nullptr) out->max[signal] = aggregateMax[signal].load(std::memory_order_relaxed);
+                    if (out->mean != nullptr) out->mean[signal] = aggregateMean[signal].load(std::memory_order_relaxed);
+                    if (out->last != nullptr) out->last[signal] = aggregateLast[signal].load(std::memory_order_relaxed);
+                    if (out->count != nullptr) out->count[signal] = aggregateCount[signal].load(std::memory_order_relaxed);
+                    if (out->windowEnd_ns != nullptr) out->windowEnd_ns[signal] = windowEnd;
+                }
+            });
+        }
+
+        /**
+            * @brief Метод получения слота образа процесса по cobid.
+            * @param cobid cobid пакета.
+            * @return слот или nullptr если cobid вне диапазонов PDO и EMCY.
+        */
+        ImageSlot* imageSlot(int cobid) {
+            if (cobid >= min_cobid_pdo && cobid <= max_cobid_pdo) return &processImage[cobid - min_cobid_pdo];
+            if (cobid >= min_cobid_error && cobid <= max_cobid_error) return &processImage[image_pdo_slots + cobid - min_cobid_error];
+            return nullptr;
+        }
+
+        /**
+            * @brief Метод записи пакета из readBuffer в образ процесса (писатель seqlock).
+            * @param cobid cobid пакета.
+        */
+        void updateImage(int cobid) {
+            ImageSlot* slot = imageSlot(cobid);
+            if (slot == nullptr) return;
+
+            uint64_t payload = 0;
+            std::memcpy(&payload, readBuffer + num_byte_payload_pdo, sizeof(payload)); // байты как есть, читатель копирует их обратно
+
+            seqlockWrite(slot->seq, [&] {
+                slot->payload.store(payload, std::memory_order_relaxed);
+                slot->len.store(std::min<uint8_t>(readBuffer[num_byte_len_pdo_package], max_len_pdo_payload), std::memory_order_relaxed);
+                slot->timestamp_ns.store(frameTimestamp, std::memory_order_relaxed);
+                slot->updates.store(slot->updates.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+            });
+            if (sharedImage) sharedImage->WriteSlot(static_cast<int>(slot - processImage), payload, std::min<uint8_t>(readBuffer[num_byte_len_pdo_package], max_len_pdo_payload), frameTimestamp);
+        }
+
+        /**
+            * @brief Метод согласованного чтения слота образа процесса (читатель seqlock).
+            * @param slot Слот образа процесса.
+            * @param cobid cobid слота.
+            * @param entry Структура для состояния cobid.
+        */
+        void readImageSlot(ImageSlot& slot, int cobid, ProcessImageEntry* entry) {
+            uint64_t payload = 0;
+            seqlockRead(slot.seq, [&] {
+                payload = slot.payload.load(std::memory_order_relaxed);
+                entry->len = slot.len.load(std::memory_order_relaxed);
+                entry->updates = slot.updates.load(std::memory_order_relaxed);
+                entry->timestamp_ns = slot.timestamp_ns.load(std::memory_order_relaxed);
+            });
+            std::memcpy(entry->data, &payload, sizeof(payload));
+            entry->cobid = static_cast<uint16_t>(cobid);
+            entry->reserved = 0;
+        }
+
+        /**
+            * @brief Метод записи принятого PDO в кольцевой буфер.
+            * @return 1 - успешно -2 - буфер переполнен, пакет отброшен.
+        */
+        int pushPDO() {
+            uint32_t head = pdoRingHead.load(std::memory_order_relaxed);
+            uint32_t used = head - pdoRingTail.load(std::memory_order_acquire);
+            if (used > pdoRingMask) { // потребитель не успевает, отбрасываем новый пакет
+                pdoRingOverflows.fetch_add(1, std::memory_order_relaxed);
+                return -2;
+            }
+
+            PdoRecord& record = pdoRing[head & pdoRingMask];
+            record.timestamp_ns = frameTimestamp;
+            record.cobid = (static_cast<uint16_t>(readBuffer[first_cobid_byte]) << len_uint8) | readBuffer[second_cobid_byte];
+            record.len = std::min<uint8_t>(readBuffer[num_byte_len_pdo_package], max_len_pdo_payload);
+            std::copy(readBuffer + num_byte_payload_pdo, readBuffer + udp_len_package, record.data);
+            pdoRingHead.store(head + 1, std::memory_order_release); // публикуем запись потребителю
+
+            pdoRingPushed.fetch_add(1, std::memory_order_relaxed);
+            if (used + 1 > pdoRingHighWater.load(std::memory_order_relaxed)) {
+                pdoRingHighWater.store(used + 1, std::memory_order_relaxed);
+            }
+            return 1;
+        }
+
+        /**
+            * @brief Метод распределения ответов SDO по слотам незавершенных запросов.
+            * Ответы expedited запросов кладутся в слот, многокадровые передачи продвигаются прямо здесь.
+            * @return 1 - успешно -1 - не подключены -2 - ответ никто не ждет.
+        */
+        int GetSDO() {
+            if (!isConnected && !replaying) return -1;
+
+            uint16_t can_id = (static_cast<uint16_t>(readBuffer[first_cobid_byte]) << len_uint8) | readBuffer[second_cobid_byte]; //считаем cobid из двух байт принятого пакета
+            int node = can_id - receive_cobid; // узел, который ответил
+            if (node < min_node_id || node > max_node_id) return -2;
+
+            sdoTxCount = 0;
+            {
+                std::lock_guard<std::mutex> lock(sdoMutex);
+                SdoTransfer& transfer = sdoTable[node];
+                if (!transfer.active || transfer.done) return -2; // от этого узла ничего не ждем
+
+                unsigned char command = readBuffer[num_sdo_command];
+                if (transfer.mode != sdo_mode_expedited) {
+                    advanceTransfer(transfer, node);
+                } else if (verifySDO(readBuffer, node, transfer.index, transfer.subIndex) != succes_verify) {
+                    return -2; // ответ на другой объект
+                } else if (command == sdo_command_abort) {
+                    transfer.abortCode = loadLE32(readBuffer + first_byte_data_sdo_w);
+                    finishTransfer(transfer, -5);
+                } else if (transfer.write ? command == sdo_command_read
+                                          : (command & sdo_mask_scs) == sdo_scs_upload_initiate && (command & sdo_flag_expedited)) {
+                    std::copy(readBuffer, readBuffer + udp_len_package, transfer.answer);
+                    finishTransfer(transfer, 1);
+                } else if (!transfer.write && (command & sdo_mask_scs) == sdo_scs_upload_initiate) { // объект больше 4 байт, нужен UploadSDO
+                    abortTransfer(transfer, node, sdo_abort_general, -6);
+                } else {
+                    return -2;
+                }
+                transfer.progress++;
+                if (transfer.done) { // ack конца блока и abort уходят до того, как ожидающий поток займет слот следующим запросом
+                    for (int i = 0; i < sdoTxCount; i++) sendFrame(sdoTx[i]);
+                    sdoTxCount = 0;
+                }
+            }
+
+            for (int i = 0; i < sdoTxCount; i++) { // отправляем следующие шаги протокола уже без мьютекса
+                sendFrame(sdoTx[i]);
+            }
+            return 1;
+        }
+
+        /**
+         * @brief Метод получения кода ошибки
+         * @return 1 - успешно.
+        */
+        int GetError() {
+            int cobid = (static_cast<uint16_t>(readBuffer[first_cobid_byte]) << len_uint8) | readBuffer[second_cobid_byte];
+            updateImage(cobid); // последняя ошибка узла в образе процесса
+            if (!trackEmcy(cobid - emcy_cobid_base)) return 1; // повтор или лимит, errorbuffer и callback не трогаем
+
+            errorbuffer[first_cobid_outer_buf] = readBuffer[second_cobid_byte]; // первая часть cobid в перевернутом виде
+            errorbuffer[second_cobid_outer_buf] = readBuffer[first_cobid_byte]; // вторая часть cobid в перевернутом виде
+            std::copy(readBuffer + num_byte_payload_pdo,readBuffer + udp_len_package, errorbuffer+num_byte_error_payload); // записываем содержимое пакета ошибки
+            if (callback_error) invokeCallback(callback_error, errorbuffer, callback_format_error);
+            return 1;
+        }
+        /**
+            * @brief Метод обновления состояния ошибок узла (писатель seqlock) и решения о доставке emcy.
+            * @param node ID узла.
+            * @return true - emcy нужно передать в errorbuffer/callback_error.
+        */
+        bool trackEmcy(int node) {
+            if (node < min_node_id || node > max_node_id) return true;
+            EmcyNode& state = emcyNodes[node];
+            uint32_t code = static_cast<uint32_t>(readBuffer[num_byte_payload_pdo]) | (static_cast<uint32_t>(readBuffer[num_byte_payload_pdo + 1]) << len_uint8) |
+                            (static_cast<uint32_t>(readBuffer[num_byte_payload_pdo + emcy_offset_register]) << (2 * len_uint8));
+            bool changed = state.total.load(std::memory_order_relaxed) == 0 || state.code.load(std::memory_order_relaxed) != code;
+
+            bool deliver = emcyMode.load(std::memory_order_relaxed) == emcy_deliver_all || changed;
+            uint32_t rate = emcyRate.load(std::memory_order_relaxed);
+            if (deliver && rate != 0) { // окно лимита - секунда от первого доставленного emcy
+                if (frameTimestamp - state.windowStart_ns >= static_cast<uint64_t>(ms_in_sec) * us_in_ms * ns_in_us) {
+                    state.windowStart_ns = frameTimestamp;
+                    state.windowDelivered = 0;
+                }
+                deliver = state.windowDelivered < rate;
+                if (deliver) state.windowDelivered++;
+            }
+
+            seqlockWrite(state.seq, [&] {
+                if (changed) {
+                    state.code.store(code, std::memory_order_relaxed);
+                    state.occurrences.store(0, std::memory_order_relaxed);
+                    state.firstSeen_ns.store(frameTimestamp, std::memory_order_relaxed);
+                }
+                state.occurrences.store(state.occurrences.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+                state.total.store(state.total.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+                std::atomic<uint64_t>& counter = deliver ? state.delivered : state.suppressed;
+                counter.store(counter.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+                state.lastSeen_ns.store(frameTimestamp, std::memory_order_relaxed);
+            });
+            return deliver;
+        }
+
+        /**
+            * @brief Метод согласованного чтения состояния ошибок узла (читатель seqlock).
+            * @param node ID узла.
+            * @param out Структура для состояния.
+        */
+        void readEmcyNode(int node, EmcyState* out) {
+            EmcyNode& state = emcyNodes[node];
+            seqlockRead(state.seq, [&] {
+                uint32_t code = state.code.load(std::memory_order_relaxed);
+                *out = EmcyState{};
+                out->nodeId = node;
+                out->errorCode = static_cast<uint16_t>(code); // младшие 16 бит
+                out->errorRegister = static_cast<uint8_t>(code >> (2 * len_uint8));
+                out->occurrences = state.occurrences.load(std::memory_order_relaxed);
+                out->total = state.total.load(std::memory_order_relaxed);
+                out->delivered = state.delivered.load(std::memory_order_relaxed);
+                out->suppressed = state.suppressed.load(std::memory_order_relaxed);
+                out->firstSeen_ns = state.firstSeen_ns.load(std::memory_order_relaxed);
+                out->lastSeen_ns = state.lastSeen_ns.load(std::memory_order_relaxed);
+            });
+        }
+
+        /**
+            * @brief Метод создания заголовка SDO пакета.
+            * @param package Массив в котором формируется пакет.
+            * @param write Флаг чтения или записи.
+            * @param receiverId Id получателя.
+            * @param index Индекс SDO объекта.
+            * @param subIndex Под индекс SDO объекта.
+            * @param dataSize Количество байт данных (используется только для вариантта записи).
+            * @return 1 - успешно -1 - не подключены.
+        */
+        int makeSDOhead(unsigned char* package, bool write, int receiverId, int index, int subIndex, int dataSize) {
+            if (!isConnected) return -1;
+            fillSDOhead(package, write, receiverId, index, subIndex, dataSize);
+            return 1;
+        }
+
+        /**
+            * @brief Метод заполнения заголовка SDO пакета без проверки подключения.
+            * @param package Массив в котором формируется пакет.
+            * @param write Флаг чтения или записи.
+            * @param receiverId Id получателя.
+            * @param index Индекс SDO объекта.
+            * @param subIndex Под индекс SDO объекта.
+            * @param dataSize Количество байт данных (используется только для вариантта записи).
+        */
+        static void fillSDOhead(unsigned char* package, bool write, int receiverId, int index, int subIndex, int dataSize) {
+            package[second_cobid_byte] = receiverId; // id получателя
+            package[first_cobid_byte] = static_cast<uint8_t>((send_cobid) >> len_uint8);
+            package[num_byte_len_pdo_package] = len_sdo; // длинна пакета
+            if (write) {
+                package[num_sdo_command] = command_write_payload_sdo | ((max_count_byte_payload - dataSize) << shift_command_len_payload); // количество действительных байт исходя из длины 
+            } else {
+                package[num_sdo_command] = command_sdo_read; // команда чтения
+            }
+            package[num_byte_second_index] = index & mask_convert_16t08; // вторая часть индекса
+            package[num_byte_dirst_index] = (index >> len_uint8) & mask_convert_16t08; // первая часть индекса
+            package[num_byte_subindex] = subIndex; // под индекс 
+        }
+
+        /**
+            * @brief Метод верификации ответа на наш запрос SDO.
+            * @param package Массив в котором находится пакет.
+            * @param receiverId Id получателя которому отправляли запрос.
+            * @param index Индекс SDO объекта.
+            * @param subIndex Под индекс SDO объекта.
+            * @return 1 - наш пакет -1 - НЕ наш пакет.
+        */
+        int verifySDO(unsigned char* package, int receiverId, int index, int subIndex) {
 
             uint16_t can_id = (static_cast<uint16_t>(package[first_cobid_byte]) << len_uint8) | package[second_cobid_byte]; //считаем cobid из двух байт принятого пакета
 
-            if (can_id == receiverId | receive_cobid && // проверяем cobid пакета slave + master
-                package[num_byte_second_index] == (index & mask_convert_16t08) && //первая часть индекса
-                package[num_byte_dirst_index] == ((index >> len_uint8) & mask_convert_16t08) && // вторая часть индекса
-                package[num_byte_subindex] == subIndex) { //сабиндекс
+            if (can_id == (receiverId | receive_cobid) && // проверяем cobid пакета slave + master
+                package[num_byte_second_index] == (index & mask_convert_16t08) && //первая часть индекса
+                package[num_byte_dirst_index] == ((index >> len_uint8) & mask_convert_16t08) && // вторая часть индекса
+                package[num_byte_subindex] == subIndex) { //сабиндекс
+
+                return 1;
+            } else {
+                return -1;
+            }
+        }
+
+        /**
+            * @brief Метод продвижения многокадровой передачи по принятому пакету, вызывается под sdoMutex.
+            * Пакеты для отправки узлу складываются в sdoTx.
+            * @param transfer Слот передачи.
+            * @param node ID узла.
+        */
+        void advanceTransfer(SdoTransfer& transfer, int node) {
+            unsigned char command = readBuffer[num_sdo_command];
+            bool initiate = transfer.state == sdo_state_initiate;
+
+            if (command == sdo_command_abort) { // сегмент блока не может начинаться с 0x80, это всегда прерывание
+                if (verifySDO(readBuffer, node, transfer.index, transfer.subIndex) != succes_verify) return;
+                transfer.abortCode = loadLE32(readBuffer + first_byte_data_sdo_w);
+                finishTransfer(transfer, -5);
+                return;
+            }
+            if (initiate && verifySDO(readBuffer, node, transfer.index, transfer.subIndex) != succes_verify) return; // ответ на другой объект
+
+            if (!transfer.write) {
+                if (initiate && (command & sdo_mask_scs) == sdo_scs_upload_initiate) { // сегментированное чтение или узел отказался от блочного
+                    if (command & sdo_flag_expedited) { // объект поместился в один пакет
+                        uint32_t size = max_count_byte_payload;
+                        if (command & sdo_flag_size_indicated) size -= (command >> shift_command_len_payload) & sdo_mask_unused_bytes;
+                        if (size > transfer.size) {
+                            finishTransfer(transfer, -7);
+                            return;
+                        }
+                        std::memcpy(transfer.buffer, readBuffer + first_byte_data_sdo_w, size);
+                        transfer.offset = transfer.total = size;
+                        finishTransfer(transfer, static_cast<int>(size));
+                        return;
+                    }
+                    transfer.total = (command & sdo_flag_size_indicated) ? loadLE32(readBuffer + first_byte_data_sdo_w) : 0;
+                    if (transfer.total > transfer.size) {
+                        abortTransfer(transfer, node, sdo_abort_memory, -7);
+                        return;
+                    }
+                    transfer.mode = sdo_mode_segmented;
+                    transfer.state = sdo_state_segment;
+                    nextTxFrame(node)[num_sdo_command] = sdo_ccs_upload_segment; // запрос первого сегмента
+                } else if (initiate && (command & sdo_mask_block_upload) == sdo_scs_block_upload) {
+                    transfer.crc = (command & sdo_block_flag_crc) != 0;
+                    transfer.total = (command & sdo_flag_expedited) ? loadLE32(readBuffer + first_byte_data_sdo_w) : 0; // бит s на месте бита e
+                    if (transfer.total > transfer.size) {
+                        abortTransfer(transfer, node, sdo_abort_memory, -7);
+                        return;
+                    }
+                    transfer.state = sdo_state_block_data;
+                    transfer.seqno = 1;
+                    nextTxFrame(node)[num_sdo_command] = sdo_block_upload_start;
+                } else if (transfer.state == sdo_state_segment && (command & sdo_mask_scs) == sdo_scs_upload_segment) {
+                    if (((command & sdo_flag_toggle) >> sdo_shift_toggle) != transfer.toggle) {
+                        abortTransfer(transfer, node, sdo_abort_toggle, -6);
+                        return;
+                    }
+                    uint32_t count = sdo_segment_payload - ((command >> sdo_shift_segment_unused) & sdo_mask_segment_unused);
+                    if (transfer.offset + count > transfer.size) {
+                        abortTransfer(transfer, node, sdo_abort_memory, -7);
+                        return;
+                    }
+                    std::memcpy(transfer.buffer + transfer.offset, readBuffer + first_byte_segment, count);
+                    transfer.offset += count;
+                    if (command & sdo_flag_last_segment) {
+                        finishTransfer(transfer, static_cast<int>(transfer.offset));
+                        return;
+                    }
+                    transfer.toggle ^= 1;
+                    nextTxFrame(node)[num_sdo_command] = sdo_ccs_upload_segment | (transfer.toggle << sdo_shift_toggle);
+                } else if (transfer.state == sdo_state_block_data) {
+                    int seqno = command & sdo_block_mask_seqno;
+                    bool last = (command & sdo_block_flag_last) != 0;
+                    if (seqno == transfer.seqno) { // сегмент по порядку, кладем прямо в буфер вызывающего
+                        if (transfer.offset < transfer.size) {
+                            uint32_t count = std::min<uint32_t>(sdo_segment_payload, transfer.size - transfer.offset);
+                            std::memcpy(transfer.buffer + transfer.offset, readBuffer + first_byte_segment, count);
+                        }
+                        transfer.offset += sdo_segment_payload; // хвост последнего сегмента уточнит завершение блочной передачи
+                        transfer.seqno++;
+                        transfer.last = last;
+                    }
+                    if (last || seqno >= transfer.blockSize) { // конец блока, подтверждаем последний сегмент по порядку
+                        unsigned char* ack = nextTxFrame(node);
+                        ack[num_sdo_command] = sdo_block_ack;
+                        ack[num_byte_block_ackseq] = static_cast<unsigned char>(transfer.seqno - 1);
+                        ack[num_byte_block_blksize] = transfer.blockSize;
+                        transfer.seqno = 1;
+                        if (transfer.last) transfer.state = sdo_state_block_end;
+                    }
+                } else if (transfer.state == sdo_state_block_end && (command & sdo_mask_block_upload) == (sdo_scs_block_upload | sdo_flag_size_indicated)) {
+                    uint32_t unused = (command >> sdo_block_shift_unused) & sdo_mask_segment_unused;
+                    uint32_t size = transfer.offset - unused;
+                    if (size > transfer.size) {
+                        abortTransfer(transfer, node, sdo_abort_memory, -7);
+                        return;
+                    }
+                    transfer.offset = size;
+                    if (transfer.crc && crc16(transfer.buffer, size) != loadLE16(readBuffer + num_byte_block_crc)) {
+                        abortTransfer(transfer, node, sdo_abort_crc, -8);
+                        return;
+                    }
+                    nextTxFrame(node)[num_sdo_command] = sdo_block_end_ack;
+                    finishTransfer(transfer, static_cast<int>(size));
+                }
+                return;
+            }
+
+            if (initiate && command == sdo_command_read) { // узел готов к сегментированной записи
+                transfer.state = sdo_state_segment;
+                sendDownloadSegment(transfer, node);
+            } else if (initiate && (command & sdo_mask_block_download) == sdo_scs_block_download) {
+                transfer.crc = (command & sdo_block_flag_crc) != 0;
+                transfer.blockSize = std::max<uint8_t>(1, std::min<uint8_t>(readBuffer[num_byte_block_size_initiate], max_sdo_block_size));
+                transfer.state = sdo_state_block_ack;
+                sendDownloadBlock(transfer, node);
+            } else if (transfer.state == sdo_state_segment && (command & sdo_mask_scs) == sdo_scs_download_segment) {
+                if (((command & sdo_flag_toggle) >> sdo_shift_toggle) != transfer.toggle) {
+                    abortTransfer(transfer, node, sdo_abort_toggle, -6);
+                    return;
+                }
+                if (transfer.offset >= transfer.size) {
+                    finishTransfer(transfer, 1);
+                    return;
+                }
+                transfer.toggle ^= 1;
+                sendDownloadSegment(transfer, node);
+            } else if (transfer.state == sdo_state_block_ack && (command & sdo_mask_block_download) == (sdo_scs_block_download | sdo_flag_expedited)) {
+                int ackseq = readBuffer[num_byte_block_ackseq] & sdo_block_mask_seqno;
+                transfer.offset = std::min<uint32_t>(transfer.blockStart + ackseq * sdo_segment_payload, transfer.size); // повторяем все после ackseq
+                transfer.blockSize = std::max<uint8_t>(1, std::min<uint8_t>(readBuffer[num_byte_block_blksize], max_sdo_block_size));
+                if (transfer.offset < transfer.size) {
+                    sendDownloadBlock(transfer, node);
+                    return;
+                }
+                unsigned char* end = nextTxFrame(node);
+                uint32_t unused = (sdo_segment_payload - transfer.size % sdo_segment_payload) % sdo_segment_payload;
+                end[num_sdo_command] = sdo_block_download_end | (unused << sdo_block_shift_unused);
+                storeLE16(end + num_byte_block_crc, transfer.crc ? crc16(transfer.source, transfer.size) : 0);
+                transfer.state = sdo_state_block_end;
+            } else if (transfer.state == sdo_state_block_end && (command & sdo_mask_block_download) == (sdo_scs_block_download | sdo_flag_size_indicated)) {
+                finishTransfer(transfer, 1);
+            }
+        }
+
+        /**
+            * @brief Метод формирования очередного сегмента сегментированной записи в sdoTx.
+            * @param transfer Слот передачи.
+            * @param node ID узла.
+        */
+        void sendDownloadSegment(SdoTransfer& transfer, int node) {
+            uint32_t count = std::min<uint32_t>(sdo_segment_payload, transfer.size - transfer.offset);
+            unsigned char* frame = nextTxFrame(node);
+            frame[num_sdo_command] = (transfer.toggle << sdo_shift_toggle) | ((sdo_segment_payload - count) << sdo_shift_segment_unused);
+            std::memcpy(frame + first_byte_segment, transfer.source + transfer.offset, count);
+            transfer.offset += count;
+            if (transfer.offset >= transfer.size) frame[num_sdo_command] |= sdo_flag_last_segment;
+        }
+
+        /**
+            * @brief Метод формирования очередного блока блочной записи в sdoTx, начиная с transfer.offset.
+            * @param transfer Слот передачи.
+            * @param node ID узла.
+        */
+        void sendDownloadBlock(SdoTransfer& transfer, int node) {
+            transfer.blockStart = transfer.offset;
+            uint32_t offset = transfer.offset;
+            for (int seqno = 1; seqno <= transfer.blockSize && offset < transfer.size; seqno++) {
+                uint32_t count = std::min<uint32_t>(sdo_segment_payload, transfer.size - offset);
+                unsigned char* frame = nextTxFrame(node);
+                frame[num_sdo_command] = static_cast<unsigned char>(seqno);
+                std::memcpy(frame + first_byte_segment, transfer.source + offset, count);
+                offset += count;
+                if (offset >= transfer.size) frame[num_sdo_command] |= sdo_block_flag_last;
+            }
+        }
+
+        /**
+            * @brief Метод получения очередного пустого SDO пакета к узлу в sdoTx.
+            * @param node ID узла.
+            * @return пакет с заполненным заголовком.
+        */
+        unsigned char* nextTxFrame(int node) {
+            unsigned char* frame = sdoTx[sdoTxCount++];
+            std::memset(frame, empty_data, udp_len_package);
+            frame[second_cobid_byte] = static_cast<unsigned char>(node); // id получателя
+            frame[first_cobid_byte] = static_cast<uint8_t>((send_cobid) >> len_uint8);
+            frame[num_byte_len_pdo_package] = len_sdo; // длинна пакета
+            return frame;
+        }
+
+        /**
+            * @brief Метод прерывания передачи: формирует пакет abort в sdoTx и завершает передачу, вызывается под sdoMutex.
+            * @param transfer Слот передачи.
+            * @param node ID узла.
+            * @param abortCode Код прерывания для узла.
+            * @param result Итог передачи для ожидающего потока.
+        */
+        void abortTransfer(SdoTransfer& transfer, int node, uint32_t abortCode, int result) {
+            unsigned char* frame = nextTxFrame(node);
+            frame[num_sdo_command] = sdo_command_abort;
+            frame[num_byte_second_index] = transfer.index & mask_convert_16t08;
+            frame[num_byte_dirst_index] = (transfer.index >> len_uint8) & mask_convert_16t08;
+            frame[num_byte_subindex] = static_cast<unsigned char>(transfer.subIndex);
+            storeLE32(frame + first_byte_data_sdo_w, abortCode);
+            transfer.abortCode = abortCode;
+            finishTransfer(transfer, result);
+        }
+
+        /**
+            * @brief Метод завершения передачи и пробуждения ожидающего потока, вызывается под sdoMutex.
+            * Поток проснется только после снятия sdoMutex, GetSDO к этому моменту уже отправит пакеты из sdoTx.
+            * @param transfer Слот передачи.
+            * @param result Итог передачи.
+        */
+        void finishTransfer(SdoTransfer& transfer, int result) {
+            transfer.result = result;
+            transfer.done = true;
+            transfer.answered_ns = frameTracing ? frameTimestamp : 0; // вызывается только потоком чтения
+            transfer.kernel_ns = frameKernelNs;
+            if (frameTracing && transfer.mode == sdo_mode_expedited) frameTotalDeferred = true; // конец пути - CompleteSDO
+            transfer.elapsed_ns = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - transfer.started).count();
+            if (result < 0) {
+                sdoAborts.fetch_add(1, std::memory_order_relaxed);
+            } else if (transfer.mode == sdo_mode_expedited) { // время обмена одной парой пакетов
+                sdoLatency[&transfer - sdoTable].record(transfer.elapsed_ns);
+                sdoLatency[0].record(transfer.elapsed_ns);
+            }
+            transfer.answered.notify_one(); // будим ожидающий поток
+            sdoEvents++;
+            sdoEvent.notify_all();
+        }
+
+        /**
+            * @brief Метод занятия слота узла и отправки первого пакета передачи.
+            * @param receiverId ID узла.
+            * @param packet Первый пакет передачи.
+            * @param setup Заполнение полей слота, специфичных для передачи (вызывается под sdoMutex).
+            * @return 1 - успешно -2 - ошибка записи -3 - к узлу уже есть незавершенный запрос.
+        */
+        int startTransfer(int receiverId, const unsigned char* packet, const std::function<void(SdoTransfer&)>& setup) {
+            {
+                std::lock_guard<std::mutex> lock(sdoMutex);
+                SdoTransfer& transfer = sdoTable[receiverId];
+                if (transfer.active) return -3; // узел еще не ответил на предыдущий запрос
+                transfer.active = true; // занимаем слот до отправки, чтобы не пропустить быстрый ответ
+                transfer.done = false;
+                transfer.state = sdo_state_initiate;
+                transfer.result = 1;
+                transfer.buffer = nullptr;
+                transfer.source = nullptr;
+                transfer.size = transfer.total = transfer.offset = transfer.blockStart = 0;
+                transfer.toggle = 0;
+                transfer.seqno = 1;
+                transfer.crc = transfer.last = false;
+                transfer.abortCode = 0;
+                transfer.writtenSize = 0;
+                transfer.generation = nodeGeneration[receiverId].load(std::memory_order_relaxed); // до отправки: boot-up до ответа сделает его устаревшим
+                transfer.progress = 0;
+                transfer.started = std::chrono::steady_clock::now();
+                transfer.elapsed_ns = 0;
+                setup(transfer);
+            }
+
+            int sendResult = sendFrame(packet); // отправляем наш пакет
+            if (sendResult == SOCKET_ERROR) {
+                std::lock_guard<std::mutex> lock(sdoMutex);
+                releaseSDO(sdoTable[receiverId]); // освобождаем слот, ответа не будет
+                return -2; // не смогли отправить
+            }
+            return 1;
+        }
+
+        /**
+            * @brief Метод ожидания завершения многокадровой передачи.
+            * Таймаут отсчитывается от последнего принятого от узла пакета, а не от начала передачи.
+            * @param receiverId ID узла.
+            * @param timeout_ms Таймаут ожидания очередного пакета в миллисекундах.
+            * @return итог передачи -3 - передачу отменили -4 - нет ответа.
+        */
+        int waitTransfer(int receiverId, int timeout_ms) {
+            std::unique_lock<std::mutex> lock(sdoMutex);
+            SdoTransfer& transfer = sdoTable[receiverId];
+            uint64_t seen = transfer.progress;
+            auto deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(timeout_ms);
+            while (transfer.active && !transfer.done) {
+                if (transfer.answered.wait_until(lock, deadline) != std::cv_status::timeout) continue;
+                if (transfer.progress != seen) { // узел еще отвечает, продлеваем ожидание
+                    seen = transfer.progress;
+                    deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(timeout_ms);
+                    continue;
+                }
+                unsigned char abortPacket[udp_len_package] = {empty_data}; // sdoTx принадлежит потоку чтения, abort формируем отдельно
+                abortPacket[second_cobid_byte] = static_cast<unsigned char>(receiverId);
+                abortPacket[first_cobid_byte] = static_cast<uint8_t>((send_cobid) >> len_uint8);
+                abortPacket[num_byte_len_pdo_package] = len_sdo;
+                abortPacket[num_sdo_command] = sdo_command_abort;
+                abortPacket[num_byte_second_index] = transfer.index & mask_convert_16t08;
+                abortPacket[num_byte_dirst_index] = (transfer.index >> len_uint8) & mask_convert_16t08;
+                abortPacket[num_byte_subindex] = static_cast<unsigned char>(transfer.subIndex);
+                storeLE32(abortPacket + first_byte_data_sdo_w, sdo_abort_timeout);
+                transfer.abortCode = sdo_abort_timeout;
+                transfer.elapsed_ns = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - transfer.started).count();
+                sendFrame(abortPacket); // сообщаем узлу что передача прервана, до освобождения слота следующему запросу
+                releaseSDO(transfer); // опоздавшие пакеты будут отброшены
+                lock.unlock();
+                sdoTimeouts.fetch_add(1, std::memory_order_relaxed);
+                return -4;
+            }
+            if (!transfer.active) return -3; // передачу отменили пока ждали
+            int result = transfer.result;
+            releaseSDO(transfer);
+            return result;
+        }
+
+        /**
+            * @brief Метод освобождения слота SDO запроса, вызывается под sdoMutex.
+            * @param transfer Слот запроса.
+        */
+        void releaseSDO(SdoTransfer& transfer) {
+            cacheTransfer(transfer); // пока слот занят, другая передача к узлу не завершится и не обгонит нас в кэше
+            transfer.active = false;
+            transfer.answered.notify_all(); // будим тех, кто еще ждет отмененный запрос
+            sdoEvents++;
+            sdoEvent.notify_all();
+        }
+
+        /**
+            * @brief Методы чтения/записи little-endian чисел в пакете.
+        */
+        static uint32_t loadLE32(const unsigned char* bytes) {
+            return bytes[0] | (bytes[1] << len_uint8) | (bytes[2] << (2 * len_uint8)) | (static_cast<uint32_t>(bytes[3]) << (3 * len_uint8));
+        }
+        static uint16_t loadLE16(const unsigned char* bytes) {
+            return static_cast<uint16_t>(bytes[0] | (bytes[1] << len_uint8));
+        }
+        static void storeLE32(unsigned char* bytes, uint32_t value) {
+            for (int b = 0; b < 4; b++) bytes[b] = static_cast<unsigned char>(value >> (len_uint8 * b));
+        }
+        static void storeLE16(unsigned char* bytes, uint16_t value) {
+            bytes[0] = static_cast<unsigned char>(value);
+            bytes[1] = static_cast<unsigned char>(value >> len_uint8);
+        }
+
+        /**
+            * @brief Метод получения ключа объекта в кэше SDO.
+        */
+        static uint64_t sdoCacheKey(int node, int index, int subIndex) {
+            return (static_cast<uint64_t>(node) << 32) | (static_cast<uint64_t>(index & 0xFFFF) << 8) | static_cast<uint64_t>(subIndex & 0xFF);
+        }
+
+        /**
+            * @brief Метод получения ttl объектов индекса (вызывается под sdoCacheMutex).
+            * @return ttl в наносекундах, < 0 - бесконечный, 0 - индекс не кэшируется.
+        */
+        int64_t cacheTtl(int index) {
+            auto it = sdoCacheIndexTtl_ns.find(index);
+            return it != sdoCacheIndexTtl_ns.end() ? it->second : sdoCacheTtl_ns;
+        }
+
+        /**
+            * @brief Метод поиска объекта в кэше SDO.
+            * @param outBuffer Массив для ответа в формате ReadSDO (может быть nullptr).
+            * @return true - объект свежий и скопирован в outBuffer.
+        */
+        bool cacheLookup(int node, int index, int subIndex, unsigned char* outBuffer) {
+            if (node < min_node_id || node > max_node_id) return false;
+            std::lock_guard<std::mutex> lock(sdoCacheMutex);
+            auto it = sdoCache.find(sdoCacheKey(node, index, subIndex));
+            if (it == sdoCache.end()) {
+                sdoCacheMisses++;
+                return false;
+            }
+            const SdoCacheEntry& entry = it->second;
+            if ((entry.expires_ns != 0 && steadyNs() >= entry.expires_ns) ||
+                entry.generation != nodeGeneration[node].load(std::memory_order_relaxed)) {
+                sdoCacheStale++;
+                sdoCache.erase(it);
+                return false;
+            }
+            sdoCacheHits++;
+            if (outBuffer != nullptr) std::memcpy(outBuffer, entry.answer, sizeof(entry.answer));
+            return true;
+        }
+
+        /**
+            * @brief Метод сохранения объекта в кэш SDO.
+            * @param answer Ответ в формате выходного массива ReadSDO.
+            * @param generation nodeGeneration узла при отправке запроса.
+            * @param written true - значение записано нами (write-through).
+        */
+        void cacheStore(int node, int index, int subIndex, const unsigned char* answer, uint32_t generation, bool written) {
+            std::lock_guard<std::mutex> lock(sdoCacheMutex);
+            if (written) sdoCacheWriteThrough++;
+            int64_t ttl = cacheTtl(index);
+            uint64_t key = sdoCacheKey(node, index, subIndex);
+            if (generation != nodeGeneration[node].load(std::memory_order_relaxed)) { // узел перезагрузился, пока шел запрос
+                sdoCacheInvalidations += sdoCache.erase(key);
+                return;
+            }
+            if (ttl == 0 || (sdoCache.size() >= static_cast<size_t>(max_sdo_cache_entries) && sdoCache.count(key) == 0)) {
+                sdoCacheInvalidations += sdoCache.erase(key); // старое значение уже неверно
+                return;
+            }
+            SdoCacheEntry& entry = sdoCache[key];
+            std::memcpy(entry.answer, answer, sizeof(entry.answer));
+            entry.expires_ns = ttl < 0 ? 0 : steadyNs() + static_cast<uint64_t>(ttl);
+            entry.generation = generation;
+        }
+
+        /**
+            * @brief Метод обновления кэша SDO итогом передачи при освобождении ее слота, вызывается под sdoMutex.
+            * Успешные expedited чтение и запись попадают в кэш, после остальных записей (ошибка, таймаут, отмена,
+            * сегментированная и блочная запись) объект удаляется из кэша.
+            * @param transfer Слот передачи.
+        */
+        void cacheTransfer(const SdoTransfer& transfer) {
+            if (!sdoCacheEnabled.load(std::memory_order_relaxed)) return;
+            int node = static_cast<int>(&transfer - sdoTable);
+            bool expedited = transfer.done && transfer.result == 1 && transfer.mode == sdo_mode_expedited;
+            unsigned char answer[max_count_byte_payload + distination_byte_sdo_read_r] = {empty_data};
+            if (!transfer.write) {
+                if (!expedited) return;
+                answer[num_byte_len_payload_sdo_r] = transfer.answer[num_byte_len_payload_sdo];
+                std::copy(transfer.answer + first_byte_sdo_read_r, transfer.answer + last_byte_sdo_read_r, answer + distination_byte_sdo_read_r);
+            } else if (expedited && transfer.writtenSize > zero_len) {
+                answer[num_byte_len_payload_sdo_r] = static_cast<unsigned char>(min_command_sdo_w | ((max_count_byte_payload - transfer.writtenSize) << shift_command_len_payload)); // как ответ узла на чтение
+                std::memcpy(answer + distination_byte_sdo_read_r, transfer.written, transfer.writtenSize);
+            } else { // значение на узле неизвестно
+                std::lock_guard<std::mutex> lock(sdoCacheMutex);
+                sdoCacheInvalidations += sdoCache.erase(sdoCacheKey(node, transfer.index, transfer.subIndex));
+                return;
+            }
+            cacheStore(node, transfer.index, transfer.subIndex, answer, transfer.generation, transfer.write);
+        }
+
+        /**
+            * @brief Метод пакетного чтения/записи SDO (TransferSDOBatch и ScanNetwork).
+            * @param until Общий срок: ответ на любой запрос ждем не дольше него.
+            * @param dropSilent true - после запроса, на который узел не ответил (ни значением, ни прерыванием),
+            * остальные запросы узла не отправляются и получают -4.
+            * @return количество успешных запросов -1 - не подключены -2 - неверные аргументы.
+        */
+        int transferBatch(bool write, const SdoRequest* reqs, int n, SdoResult* out, int timeout_ms,
+                          std::chrono::steady_clock::time_point until, bool dropSilent) {
+            if (!isConnected) return -1;
+            if (reqs == nullptr || out == nullptr || out->status == nullptr || n < zero_len) return -2;
+
+            // очередь запросов каждого узла в виде односвязного списка в порядке массива reqs
+            std::vector<int> nextInNode(n, batch_end);
+            int head[max_node_id + 1];
+            int tail[max_node_id + 1];
+            std::fill(head, head + max_node_id + 1, batch_end);
+            std::fill(tail, tail + max_node_id + 1, batch_end);
+
+            int left = n; // сколько запросов еще не завершено
+            for (int i = 0; i < n; i++) {
+                int node = reqs[i].receiverId;
+                if (node < min_node_id || node > max_node_id) {
+                    out->status[i] = -3; // неверный id узла
+                    left--;
+                    continue;
+                }
+                if (head[node] == batch_end) head[node] = i; else nextInNode[tail[node]] = i;
+                tail[node] = i;
+            }
+
+            const auto never = std::chrono::steady_clock::time_point::max();
+            std::chrono::steady_clock::time_point deadline[max_node_id + 1]; // срок ответа на запрос узла или срок ожидания чужого слота
+            bool inFlight[max_node_id + 1] = {};
+            std::fill(deadline, deadline + max_node_id + 1, never);
+
+            int success = 0;
+            unsigned char answer[max_count_byte_payload + distination_byte_sdo_read_r]; // количество значимых байт и данные
+            while (left > 0) {
+                uint64_t seenEvents;
+                {
+                    std::lock_guard<std::mutex> lock(sdoMutex);
+                    seenEvents = sdoEvents; // события после этой точки разбудят нас после прохода по узлам
+                }
+                auto now = std::chrono::steady_clock::now();
+                auto wakeup = never;
+
+                for (int node = min_node_id; node <= max_node_id; node++) {
+                    int i = head[node];
+                    if (i == batch_end) continue;
+
+                    int result;
+                    if (!inFlight[node]) { // отправляем очередной запрос узлу
+                        result = SubmitSDO(write, node, reqs[i].index, reqs[i].subIndex, reqs[i].data, reqs[i].dataSize);
+                        if (result == 1) {
+                            inFlight[node] = true;
+                            deadline[node] = std::min(until, std::chrono::steady_clock::now() + std::chrono::milliseconds(timeout_ms));
+                            wakeup = std::min(wakeup, deadline[node]);
+                            continue;
+                        }
+                        if (result == -3) { // слот узла занят чужим запросом, ждем его освобождения не дольше таймаута
+                            if (deadline[node] == never) deadline[node] = std::min(until, now + std::chrono::milliseconds(timeout_ms));
+                            if (now < deadline[node]) {
+                                wakeup = std::min(wakeup, deadline[node]);
+                                continue;
+                            }
+                        }
+                    } else {
+                        result = CompleteSDO(node, answer, zero_len); // только проверяем наличие ответа
+                        if (result == sdo_pending) {
+                            if (now < deadline[node]) {
+                                wakeup = std::min(wakeup, deadline[node]);
+                                continue;
+                            }
+                            CancelSDO(node); // опоздавший ответ будет отброшен
+                            sdoTimeouts.fetch_add(1, std::memory_order_relaxed);
+                            result = -4;
+                        }
+                    }
+
+                    out->status[i] = result;
+                    if (result == 1) {
+                        success++;
+                        if (!write) storeBatchValue(out, i, answer); // пакет только пополняет кэш (CompleteSDO), но не читает из него
+                    }
+                    inFlight[node] = false;
+                    deadline[node] = never;
+                    head[node] = nextInNode[i];
+                    left--;
+                    if (dropSilent && result != 1 && result != -5 && result != -6) { // узел не ответил, остальные его запросы не отправляем
+                        for (; head[node] != batch_end; head[node] = nextInNode[head[node]], left--) out->status[head[node]] = -4;
+                    }
+                    if (head[node] != batch_end) wakeup = now; // следующий запрос узла отправим сразу
+                }
+
+                if (left > 0 && wakeup != now) {
+                    std::unique_lock<std::mutex> lock(sdoMutex);
+                    sdoEvent.wait_until(lock, wakeup, [this, seenEvents] { return sdoEvents != seenEvents; }); // ждем ответа, освобождения слота или таймаута
+                }
+            }
+            return success;
+        }
+
+        /**
+            * @brief Метод записи прочитанного значения в массивы результатов пакетного чтения.
+            * @param out Массивы результатов.
+            * @param i Номер запроса.
+            * @param answer Количество значимых байт и данные в формате выходного массива ReadSDO.
+        */
+        void storeBatchValue(SdoResult* out, int i, const unsigned char* answer) {
+            int command = answer[num_byte_len_payload_sdo_r];
+            int size = max_count_byte_payload;
+            if (command & sdo_flag_size_indicated) { // узел указал сколько байт значимые
+                size -= (command >> shift_command_len_payload) & sdo_mask_unused_bytes;
+            }
+            uint32_t value = 0;
+            for (int b = 0; b < size; b++) {
+                value |= static_cast<uint32_t>(answer[distination_byte_sdo_read_r + b]) << (len_uint8 * b); // собираем little-endian
+            }
+            if (out->dataSize != nullptr) out->dataSize[i] = size;
+            if (out->value != nullptr) out->value[i] = value;
+        }
+
+        /**
+            * @brief Метод таймаута ожидания ответа
+        */
+        bool timeout_SDO_answer(std::chrono::steady_clock::time_point start, int timeout_ms) {
+            if (std::chrono::steady_clock::now() - start >= std::chrono::milliseconds(timeout_ms)) return true;
+            return false;
+        }
+
+    };
+
+
+    /**
+        * Виртуальные узлы CANopen для нагрузочных тестов без ПЛК: слушает udp как socat и отвечает
+        * в том же формате пакетов, что и ConnectToUDPServer. Узлы отвечают на expedited SDO, шлют TPDO и EMCY.
+    */
+    class Simulator {
+    public:
+        /**
+            * @brief Конструктор, привязывает сокет. Потоки запускаются только при успешной привязке.
+            * @param ipAddress IP-адрес для привязки.
+            * @param port Порт, 0 - выбрать свободный (см. GetPort).
+        */
+        Simulator(const char* ipAddress, int port) {
+            WSADATA wsaData;
+            if (WSAStartup(MAKEWORD(minor_ver_socket, major_ver_socket), &wsaData) != socket_init_success) return;
+            wsaStarted = true;
+            simSocket = socket(AF_INET, SOCK_DGRAM, protocol_socket);
+            if (simSocket == INVALID_SOCKET) return;
+            sockaddr_in addr = {};
+            addr.sin_family = AF_INET;
+            addr.sin_port = htons(port);
+            addr.sin_addr.s_addr = inet_addr(ipAddress);
+            socklen_t addrLen = sizeof(addr);
+            if (bind(simSocket, (sockaddr*)&addr, sizeof(addr)) == SOCKET_ERROR || getsockname(simSocket, (sockaddr*)&addr, &addrLen) == SOCKET_ERROR) {
+                closesocket(simSocket);
+                simSocket = INVALID_SOCKET;
+                return;
+            }
+            boundPort = ntohs(addr.sin_port);
+            running = true;
+            rxThread = std::thread(&Simulator::Responder, this);
+            txThread = std::thread(&Simulator::Producer, this);
+        }
+
+        /**
+            * @brief Деструктор, останавливает потоки и закрывает сокет.
+        */
+        ~Simulator() {
+            running = false;
+            if (rxThread.joinable()) rxThread.join();
+            if (txThread.joinable()) txThread.join();
+            if (simSocket != INVALID_SOCKET) closesocket(simSocket);
+            if (wsaStarted) WSACleanup();
+        }
+
+        /**
+            * @brief Метод получения порта симулятора.
+            * @return порт -1 - сокет не привязан.
+        */
+        int GetPort() {
+            return running ? boundPort : -1;
+        }
+
+        /**
+            * @brief Метод добавления виртуального узла со стандартными объектами 0x1000 и 0x1018:01..04.
+            * @param node ID узла.
+            * @return 1 - успешно -3 - неверный id узла.
+        */
+        int AddNode(int node) {
+            if (node < min_node_id || node > max_node_id) return -3;
+            std::lock_guard<std::mutex> lock(nodesMutex);
+            SimNode& entry = nodes[node];
+            entry.present = true;
+            entry.objects[objectKey(od_device_type, 0)] = {sim_device_type, max_count_byte_payload};
+            for (int sub = 1; sub <= od_identity_entries; sub++) entry.objects[objectKey(od_identity, sub)] = {static_cast<uint32_t>(node), max_count_byte_payload}; // identity = id узла
+            return 1;
+        }
+
+        /**
+            * @brief Метод записи объекта словаря узла.
+            * @param node ID узла.
+            * @param index Индекс объекта.
+            * @param subIndex Сабиндекс объекта.
+            * @param value Значение.
+            * @param size Размер значения в байтах (1..4).
+            * @return 1 - успешно -2 - неверный размер -3 - узел не добавлен.
+        */
+        int SetObject(int node, int index, int subIndex, uint32_t value, int size) {
+            if (size <= zero_len || size > max_count_byte_payload) return -2;
+            std::lock_guard<std::mutex> lock(nodesMutex);
+            if (node < min_node_id || node > max_node_id || !nodes[node].present) return -3;
+            nodes[node].domains.erase(objectKey(index, subIndex));
+            nodes[node].objects[objectKey(index, subIndex)] = {value, static_cast<uint8_t>(size)};
+            return 1;
+        }
+
+        /**
+            * @brief Метод чтения объекта словаря узла (например чтобы проверить запись dll).
+            * @param node ID узла.
+            * @param index Индекс объекта.
+            * @param subIndex Сабиндекс объекта.
+            * @param value Значение.
+            * @return размер значения -2 - объекта нет -3 - узел не добавлен.
+        */
+        int GetObject(int node, int index, int subIndex, uint32_t* value) {
+            std::lock_guard<std::mutex> lock(nodesMutex);
+            if (node < min_node_id || node > max_node_id || !nodes[node].present) return -3;
+            auto it = nodes[node].objects.find(objectKey(index, subIndex));
+            if (it == nodes[node].objects.end()) return -2;
+            *value = it->second.value;
+            return it->second.size;
+        }
+
+        /**
+            * @brief Метод записи объекта словаря узла произвольного размера (читается сегментированной или блочной передачей).
+            * @param node ID узла.
+            * @param index Индекс объекта.
+            * @param subIndex Сабиндекс объекта.
+            * @param data Данные.
+            * @param size Размер данных 1..max_sim_domain_size.
+            * @return 1 - успешно -2 - неверный размер -3 - узел не добавлен.
+        */
+        int SetDomain(int node, int index, int subIndex, const unsigned char* data, int size) {
+            if (data == nullptr || size <= zero_len || size > max_sim_domain_size) return -2;
+            std::lock_guard<std::mutex> lock(nodesMutex);
+            if (node < min_node_id || node > max_node_id || !nodes[node].present) return -3;
+            uint32_t key = objectKey(index, subIndex);
+            nodes[node].objects.erase(key);
+            nodes[node].domains[key].assign(data, data + size);
+            return 1;
+        }
+
+        /**
+            * @brief Метод чтения объекта словаря узла произвольного размера (например чтобы проверить DownloadSDO).
+            * Объекты до 4 байт, записанные expedited, тоже читаются.
+            * @param node ID узла.
+            * @param index Индекс объекта.
+            * @param subIndex Сабиндекс объекта.
+            * @param buffer Буфер для данных.
+            * @param capacity Размер буфера.
+            * @return размер объекта -2 - объекта нет -3 - узел не добавлен -7 - объект не помещается в буфер.
+        */
+        int GetDomain(int node, int index, int subIndex, unsigned char* buffer, int capacity) {
+            std::lock_guard<std::mutex> lock(nodesMutex);
+            if (node < min_node_id || node > max_node_id || !nodes[node].present) return -3;
+            std::vector<unsigned char> data;
+            if (!objectBytes(nodes[node], objectKey(index, subIndex), data)) return -2;
+            if (buffer == nullptr || static_cast<int>(data.size()) > capacity) return -7;
+            std::memcpy(buffer, data.data(), data.size());
+            return static_cast<int>(data.size());
+        }
+
+        /**
+            * @brief Метод включения crc в блочных передачах виртуальных узлов (по умолчанию включен, если его просит dll).
+            * @param enabled 0 - узлы отвечают без поддержки crc.
+            * @return 1 - успешно.
+        */
+        int SetBlockCrc(int enabled) {
+            blockCrc.store(enabled != 0, std::memory_order_relaxed);
+            return 1;
+        }
+
+        /**
+            * @brief Метод настройки периодической отправки TPDO узла. Payload - счетчик отправок little-endian, обрезанный до len.
+            * @param node ID узла.
+            * @param pdoNumber Номер TPDO 1..4.
+            * @param period_us Период в микросекундах, 0 - выключить.
+            * @param len Количество значимых байт 0..8.
+            * @return 1 - успешно -2 - неверные аргументы -3 - узел не добавлен.
+        */
+        int SetTPDO(int node, int pdoNumber, int period_us, int len) {
+            if (pdoNumber < 1 || pdoNumber > max_sim_tpdos || period_us < zero_len || len < zero_len || len > max_len_pdo_payload) return -2;
+            std::lock_guard<std::mutex> lock(nodesMutex);
+            if (node < min_node_id || node > max_node_id || !nodes[node].present) return -3;
+            SimTpdo& tpdo = nodes[node].tpdos[pdoNumber - 1];
+            tpdo.period_ns = static_cast<uint64_t>(period_us) * ns_in_us;
+            tpdo.len = static_cast<uint8_t>(len);
+            if (tpdo.period_ns > 0) tpdo.due_ns = (steadyNs() / tpdo.period_ns + 1) * tpdo.period_ns; // сроки на сетке периода, TPDO с одним периодом уходят одной пачкой
+            return 1;
+        }
+
+        /**
+            * @brief Метод отправки EMCY от имени узла.
+            * @param node ID узла.
+            * @param errorCode Код ошибки.
+            * @param errorRegister Регистр ошибок (0x1001).
+            * @return 1 - успешно -1 - dll еще не подключилась -2 - ошибка отправки -3 - узел не добавлен.
+        */
+        int InjectEmcy(int node, int errorCode, int errorRegister) {
+            {
+                std::lock_guard<std::mutex> lock(nodesMutex);
+                if (node < min_node_id || node > max_node_id || !nodes[node].present) return -3;
+            }
+            if (!hasPeer.load(std::memory_order_acquire)) return -1;
+            unsigned char frame[1][udp_len_package] = {};
+            makeFrame(frame[0], emcy_cobid_base + node, len_sdo);
+            frame[0][num_byte_payload_pdo] = static_cast<unsigned char>(errorCode);
+            frame[0][num_byte_payload_pdo + 1] = static_cast<unsigned char>(errorCode >> len_uint8);
+            frame[0][num_byte_payload_pdo + 2] = static_cast<unsigned char>(errorRegister);
+            if (sendFrames(frame, 1) != 1) return -2;
+            emcyFrames.fetch_add(1, std::memory_order_relaxed);
+            return 1;
+        }
+
+        /**
+            * @brief Метод получения счетчиков симулятора.
+            * @param stats Структура для счетчиков.
+            * @return 1 - успешно.
+        */
+        int GetStats(SimulatorStats* stats) {
+            stats->rxFrames = rxFrames.load(std::memory_order_relaxed);
+            stats->txFrames = txFrames.load(std::memory_order_relaxed);
+            stats->sdoRequests = sdoRequests.load(std::memory_order_relaxed);
+            stats->sdoAborts = sdoAborts.load(std::memory_order_relaxed);
+            stats->tpdoFrames = tpdoFrames.load(std::memory_order_relaxed);
+            stats->emcyFrames = emcyFrames.load(std::memory_order_relaxed);
+            stats->txSyscalls = txSyscalls.load(std::memory_order_relaxed);
+            stats->overruns = overruns.load(std::memory_order_relaxed);
+            return 1;
+        }
+
+    private:
+        /**
+            * Объект словаря виртуального узла.
+        */
+        struct SimObject {
+            uint32_t value;
+            uint8_t size;                           // размер значения в байтах
+        };
+
+        /**
+            * Периодический TPDO виртуального узла.
+        */
+        struct SimTpdo {
+            uint64_t period_ns = 0;                 // 0 - выключен
+            uint64_t due_ns = 0;                    // срок следующей отправки
+            uint64_t counter = 0;                   // payload следующей отправки
+            uint8_t len = 0;
+        };
+
+        /**
+            * Многокадровая SDO передача виртуального узла (сервер сегментированной и блочной передачи).
+        */
+        struct SimTransfer {
+            int state = sim_sdo_idle;
+            uint32_t key = 0;                       // объект передачи
+            std::vector<unsigned char> data;        // отдаваемый или принимаемый объект
+            uint32_t offset = 0;                    // отдано байт (чтение)
+            uint32_t blockStart = 0;                // смещение первого сегмента текущего блока чтения
+            int toggle = 0;
+            bool crc = false;
+            int blockSize = max_sdo_block_size;
+            int seqno = 0;                          // последний принятый по порядку сегмент блока записи
+        };
+
+        /**
+            * Виртуальный узел: словарь объектов, объекты больше 4 байт, TPDO и текущая SDO передача.
+        */
+        struct SimNode {
+            bool present = false;
+            std::unordered_map<uint32_t, SimObject> objects;
+            std::unordered_map<uint32_t, std::vector<unsigned char>> domains; // записанные сегментированной или блочной передачей
+            SimTpdo tpdos[max_sim_tpdos];
+            SimTransfer transfer;
+        };
+
+        SOCKET simSocket = INVALID_SOCKET;
+        bool wsaStarted = false;
+        int boundPort = 0;
+        std::atomic<bool> running{false};
+        std::thread rxThread;                   // ответы на SDO
+        std::thread txThread;                   // отправка TPDO
+        std::mutex nodesMutex;                  // защищает nodes
+        SimNode nodes[max_node_id + 1];
+        sockaddr_in peerAddr = {};              // адрес dll, пишется до hasPeer
+        std::atomic<bool> hasPeer{false};
+        std::atomic<bool> blockCrc{true};       // узлы поддерживают crc блочной передачи
+        std::atomic<uint64_t> rxFrames{0};
+        std::atomic<uint64_t> txFrames{0};
+        std::atomic<uint64_t> sdoRequests{0};
+        std::atomic<uint64_t> sdoAborts{0};
+        std::atomic<uint64_t> tpdoFrames{0};
+        std::atomic<uint64_t> emcyFrames{0};
+        std::atomic<uint64_t> txSyscalls{0};
+        std::atomic<uint64_t> overruns{0};
+
+        static uint32_t objectKey(int index, int subIndex) {
+            return (static_cast<uint32_t>(index & 0xFFFF) << len_uint8) | (subIndex & mask_convert_16t08);
+        }
+
+        /**
+            * @brief Метод заполнения заголовка пакета (cobid и длина), остальные байты обнуляются.
+        */
+        static void makeFrame(unsigned char* frame, int cobid, int len) {
+            std::memset(frame, empty_data, udp_len_package);
+            frame[second_cobid_byte] = static_cast<unsigned char>(cobid & mask_cobid);
+            frame[first_cobid_byte] = static_cast<unsigned char>(cobid >> len_uint8);
+            frame[num_byte_len_pdo_package] = static_cast<unsigned char>(len);
+        }
+
+        /**
+            * @brief Метод отправки пачки пакетов в dll: sendmmsg на Linux, sendto на остальных.
+            * @return количество отправленных пакетов.
+        */
+        int sendFrames(const unsigned char (*packets)[udp_len_package], int count) {
+            int sent = 0;
+            while (sent < count) {
+                int chunk = std::min(count - sent, send_batch_size);
+#ifdef __linux__
+                mmsghdr msgs[send_batch_size] = {};
+                iovec iov[send_batch_size];
+                for (int i = 0; i < chunk; i++) {
+                    iov[i].iov_base = const_cast<unsigned char*>(packets[sent + i]);
+                    iov[i].iov_len = udp_len_package;
+                    msgs[i].msg_hdr.msg_name = &peerAddr;
+                    msgs[i].msg_hdr.msg_namelen = sizeof(peerAddr);
+                    msgs[i].msg_hdr.msg_iov = &iov[i];
+                    msgs[i].msg_hdr.msg_iovlen = 1;
+                }
+                int result = sendmmsg(simSocket, msgs, chunk, 0);
+                txSyscalls.fetch_add(1, std::memory_order_relaxed);
+#else
+                int result = 0;
+                for (int i = 0; i < chunk; i++) {
+                    if (sendto(simSocket, (const char*)packets[sent + i], udp_len_package, 0, (sockaddr*)&peerAddr, sizeof(peerAddr)) == SOCKET_ERROR) break;
+                    txSyscalls.fetch_add(1, std::memory_order_relaxed);
+                    result++;
+                }
+#endif
+                if (result <= 0) break;
+                sent += result;
+                if (result < chunk) break;
+            }
+            txFrames.fetch_add(sent, std::memory_order_relaxed);
+            return sent;
+        }
+
+        /**
+            * @brief Метод потока ответов: принимает пакеты dll и отвечает на SDO запросы виртуальных узлов.
+            * Первый пакет от нового адреса (стартовый пакет ConnectToUDPServer) запоминает адрес dll, ему отвечают boot-up всех узлов.
+        */
+        void Responder() {
+            unsigned char request[udp_len_package];
+            unsigned char answers[recv_batch_size + max_sdo_block_size][udp_len_package]; // блок чтения целиком после пачки ответов
+            while (running) {
+                fd_set readSet;
+                FD_ZERO(&readSet);
+                FD_SET(simSocket, &readSet);
+                timeval timeout = {0, listener_poll_us};
+                if (select(static_cast<int>(simSocket) + 1, &readSet, nullptr, nullptr, &timeout) <= data_not_exist) continue;
+
+                int count = 0;
+                unsigned long pending = 1;
+                while (count < recv_batch_size && pending > 0) { // отвечаем пачкой на все накопленные запросы
+                    sockaddr_in from = {};
+                    socklen_t fromLen = sizeof(from);
+                    int received = recvfrom(simSocket, (char*)request, udp_len_package, 0, (sockaddr*)&from, &fromLen);
+                    if (received == SOCKET_ERROR) break;
+                    rxFrames.fetch_add(1, std::memory_order_relaxed);
+                    if (!hasPeer.load(std::memory_order_relaxed) || from.sin_port != peerAddr.sin_port || from.sin_addr.s_addr != peerAddr.sin_addr.s_addr) {
+                        if (count > 0) sendFrames(answers, count); // ответы старому адресу
+                        count = 0;
+                        hasPeer.store(false, std::memory_order_relaxed);
+                        peerAddr = from;
+                        hasPeer.store(true, std::memory_order_release);
+                        count = bootup(answers);
+                    } else if (received == udp_len_package) {
+                        count += handleRequest(request, answers + count);
+                    }
+                    if (ioctlsocket(simSocket, FIONREAD, &pending) == SOCKET_ERROR) break;
+                }
+                if (count > 0) sendFrames(answers, count);
+            }
+        }
+
+        /**
+            * @brief Метод формирования ответа на стартовый пакет и boot-up всех узлов.
+            * ConnectToUDPServer забирает первый пакет как подтверждение связи, поэтому первым идет пустой пакет, а не boot-up узла.
+            * @param answers Пакеты ответа (не меньше max_node_id + 1).
+            * @return количество пакетов.
+        */
+        int bootup(unsigned char (*answers)[udp_len_package]) {
+            std::lock_guard<std::mutex> lock(nodesMutex);
+            int count = 0;
+            makeFrame(answers[count++], zero_len, zero_len); // подтверждение связи для ConnectToUDPServer
+            for (int node = min_node_id; node <= max_node_id; node++) {
+                if (!nodes[node].present) continue;
+                makeFrame(answers[count], (id_heartbeat << len_uint8) + node, len_heartbeat);
+                answers[count++][num_byte_payload_pdo] = node_state_bootup;
+            }
+            return count;
+        }
+
+        /**
+            * @brief Метод обработки SDO запроса к виртуальному узлу: expedited, сегментированная и блочная передачи.
+            * @param request Принятый пакет.
+            * @param answers Пакеты ответа (не меньше max_sdo_block_size).
+            * @return количество пакетов ответа.
+        */
+        int handleRequest(const unsigned char* request, unsigned char (*answers)[udp_len_package]) {
+            int cobid = ((request[first_cobid_byte] << len_uint8) | request[second_cobid_byte]) & max_cobid;
+            int node = cobid - send_cobid;
+            if (node < min_node_id || node > max_node_id) return 0; // pdo, heartbeat, sync и прочее только считаем
+
+            int index = request[num_byte_second_index] | (request[num_byte_dirst_index] << len_uint8);
+            int subIndex = request[num_byte_subindex];
+            unsigned char command = request[num_sdo_command];
+            unsigned char* answer = answers[0];
+            uint32_t abortCode = 0;
+            uint32_t abortKey = 0;
+            int count = 1;
+            makeFrame(answer, receive_cobid + node, len_sdo);
+            std::memcpy(answer + num_byte_second_index, request + num_byte_second_index, 3); // индекс и сабиндекс как в запросе, их проверяет verifySDO
+            {
+                std::lock_guard<std::mutex> lock(nodesMutex);
+                SimNode& entry = nodes[node];
+                if (!entry.present) return 0; // узла нет на шине, dll получит таймаут
+                SimTransfer& transfer = entry.transfer;
+                sdoRequests.fetch_add(1, std::memory_order_relaxed);
+                if (command == sdo_command_abort) {
+                    transfer.state = sim_sdo_idle;
+                    return 0; // dll прервала передачу, отвечать не нужно
+                }
+                if (transfer.state == sim_sdo_block_download) return receiveBlockSegment(node, transfer, request, answer); // сегмент блока может начинаться любым байтом
 
+                if (command == command_sdo_read) {
+                    transfer.state = sim_sdo_idle;
+                    transfer.key = objectKey(index, subIndex);
+                    auto it = entry.objects.find(objectKey(index, subIndex));
+                    auto domain = entry.domains.find(objectKey(index, subIndex));
+                    if (it != entry.objects.end()) {
+                        answer[num_sdo_command] = static_cast<unsigned char>(sdo_scs_upload_initiate | sdo_flag_expedited | sdo_flag_size_indicated |
+                                                                             ((max_count_byte_payload - it->second.size) << shift_command_len_payload));
+                        for (int b = 0; b < max_count_byte_payload; b++) answer[first_byte_data_sdo_w + b] = static_cast<unsigned char>(it->second.value >> (len_uint8 * b));
+                    } else if (domain != entry.domains.end()) { // начало сегментированного чтения с размером
+                        transfer.state = sim_sdo_upload_segment;
+                        transfer.key = objectKey(index, subIndex);
+                        transfer.data = domain->second;
+                        transfer.offset = 0;
+                        transfer.toggle = 0;
+                        answer[num_sdo_command] = sdo_scs_upload_initiate | sdo_flag_size_indicated;
+                        storeSize(answer, static_cast<uint32_t>(transfer.data.size()));
+                    } else {
+                        abortCode = sdo_abort_no_object;
+                    }
+                } else if ((command & sdo_mask_scs) == sdo_scs_download_segment && (command & sdo_flag_expedited)) {
+                    int size = max_count_byte_payload;
+                    if (command & sdo_flag_size_indicated) size -= (command >> shift_command_len_payload) & sdo_mask_unused_bytes;
+                    uint32_t value = 0;
+                    for (int b = 0; b < size; b++) value |= static_cast<uint32_t>(request[first_byte_data_sdo_w + b]) << (len_uint8 * b);
+                    transfer.state = sim_sdo_idle;
+                    entry.domains.erase(objectKey(index, subIndex));
+                    entry.objects[objectKey(index, subIndex)] = {value, static_cast<uint8_t>(size)};
+                    answer[num_sdo_command] = sdo_command_read; // подтверждение записи 0x60
+                } else if ((command & sdo_mask_scs) == sdo_scs_download_segment) { // начало сегментированной записи
+                    transfer.state = sim_sdo_download_segment;
+                    transfer.key = objectKey(index, subIndex);
+                    transfer.data.clear();
+                    transfer.toggle = 0;
+                    answer[num_sdo_command] = sdo_command_read;
+                } else if ((command & sdo_mask_scs) == sdo_ccs_upload_segment && transfer.state == sim_sdo_upload_segment) {
+                    if (((command & sdo_flag_toggle) >> sdo_shift_toggle) != transfer.toggle) {
+                        abortCode = sdo_abort_toggle;
+                    } else {
+                        uint32_t size = std::min<uint32_t>(sdo_segment_payload, static_cast<uint32_t>(transfer.data.size()) - transfer.offset);
+                        bool last = transfer.offset + size >= transfer.data.size();
+                        answer[num_sdo_command] = static_cast<unsigned char>((transfer.toggle << sdo_shift_toggle) | ((sdo_segment_payload - size) << sdo_shift_segment_unused) |
+                                                                             (last ? sdo_flag_last_segment : 0));
+                        std::memset(answer + first_byte_segment, empty_data, sdo_segment_payload);
+                        std::memcpy(answer + first_byte_segment, transfer.data.data() + transfer.offset, size);
+                        transfer.offset += size;
+                        transfer.toggle ^= 1;
+                        if (last) transfer.state = sim_sdo_idle;
+                    }
+                } else if ((command & sdo_mask_scs) == sdo_scs_upload_segment && transfer.state == sim_sdo_download_segment) {
+                    if (((command & sdo_flag_toggle) >> sdo_shift_toggle) != transfer.toggle) {
+                        abortCode = sdo_abort_toggle;
+                    } else {
+                        int size = sdo_segment_payload - ((command >> sdo_shift_segment_unused) & sdo_mask_segment_unused);
+                        transfer.data.insert(transfer.data.end(), request + first_byte_segment, request + first_byte_segment + size);
+                        answer[num_sdo_command] = static_cast<unsigned char>(sdo_scs_download_segment | (transfer.toggle << sdo_shift_toggle));
+                        std::memset(answer + first_byte_segment, empty_data, sdo_segment_payload);
+                        transfer.toggle ^= 1;
+                        if (command & sdo_flag_last_segment) storeTransfer(entry, transfer);
+                    }
+                } else if ((command & sdo_mask_scs) == sdo_scs_block_download) { // клиент: блочное чтение
+                    count = handleBlockUpload(node, entry, transfer, request, answers, abortCode);
+                } else if ((command & sdo_mask_scs) == sdo_scs_block_upload) { // клиент: блочная запись
+                    count = handleBlockDownload(entry, transfer, request, answer, abortCode);
+                } else {
+                    transfer.key = objectKey(index, subIndex);
+                    abortCode = sdo_abort_command;
+                }
+                if (transfer.data.size() > static_cast<size_t>(max_sim_domain_size)) abortCode = sdo_abort_memory;
+                if (abortCode != 0) {
+                    transfer.state = sim_sdo_idle;
+                    abortKey = transfer.key; // сегменты не несут индекс, dll сверяет прерывание с объектом передачи
+                }
+            }
+            if (abortCode != 0) {
+                makeFrame(answer, receive_cobid + node, len_sdo);
+                answer[num_sdo_command] = sdo_command_abort;
+                answer[num_byte_second_index] = static_cast<unsigned char>(abortKey >> len_uint8);
+                answer[num_byte_dirst_index] = static_cast<unsigned char>(abortKey >> (2 * len_uint8));
+                answer[num_byte_subindex] = static_cast<unsigned char>(abortKey);
+                for (int b = 0; b < max_count_byte_payload; b++) answer[first_byte_data_sdo_w + b] = static_cast<unsigned char>(abortCode >> (len_uint8 * b));
+                sdoAborts.fetch_add(1, std::memory_order_relaxed);
                 return 1;
-            } else {
-                return -1;
             }
+            return count;
         }
 
         /**
-            * @brief Метод таймаута ожидания ответа
+            * @brief Метод обработки команд блочного чтения (начало, старт, подтверждение блока, завершение), вызывается под nodesMutex.
+            * @param abortCode Код прерывания, если передачу нужно прервать.
+            * @return количество пакетов ответа.
         */
-        bool timeout_SDO_answer(DWORD start, int timeout_ms) {
-            if (GetTickCount() - start >= static_cast<DWORD>(timeout_ms)) return true;
-            return false;
+        int handleBlockUpload(int node, SimNode& entry, SimTransfer& transfer, const unsigned char* request, unsigned char (*answers)[udp_len_package], uint32_t& abortCode) {
+            unsigned char command = request[num_sdo_command];
+            unsigned char* answer = answers[0];
+            if (command == sdo_block_end_ack && transfer.state == sim_sdo_block_upload_end) {
+                transfer.state = sim_sdo_idle;
+                return 0;
+            }
+            if (command == sdo_block_upload_start && transfer.state == sim_sdo_block_upload_start) return sendUploadBlock(node, transfer, answers);
+            if (command == sdo_block_ack && transfer.state == sim_sdo_block_upload_ack) {
+                int ackseq = request[num_byte_block_ackseq] & sdo_block_mask_seqno;
+                transfer.offset = std::min<uint32_t>(transfer.blockStart + ackseq * sdo_segment_payload, static_cast<uint32_t>(transfer.data.size())); // повторяем все после ackseq
+                transfer.blockSize = std::max(1, std::min<int>(request[num_byte_block_blksize], max_sdo_block_size));
+                if (transfer.offset < transfer.data.size()) return sendUploadBlock(node, transfer, answers);
+                uint32_t size = static_cast<uint32_t>(transfer.data.size());
+                uint32_t unused = (sdo_segment_payload - size % sdo_segment_payload) % sdo_segment_payload;
+                makeFrame(answer, receive_cobid + node, len_sdo);
+                answer[num_sdo_command] = static_cast<unsigned char>(sdo_scs_block_upload | (unused << sdo_block_shift_unused) | sdo_flag_size_indicated);
+                uint16_t crc = transfer.crc ? crc16(transfer.data.data(), size) : 0;
+                answer[num_byte_block_crc] = static_cast<unsigned char>(crc);
+                answer[num_byte_block_crc + 1] = static_cast<unsigned char>(crc >> len_uint8);
+                transfer.state = sim_sdo_block_upload_end;
+                return 1;
+            }
+            if ((command & sdo_mask_unused_bytes) != 0) { // старт, подтверждение или завершение вне передачи
+                abortCode = sdo_abort_command;
+                return 1;
+            }
+            int index = request[num_byte_second_index] | (request[num_byte_dirst_index] << len_uint8);
+            transfer.key = objectKey(index, request[num_byte_subindex]);
+            if (!objectBytes(entry, transfer.key, transfer.data)) {
+                abortCode = sdo_abort_no_object;
+                return 1;
+            }
+            transfer.crc = (command & sdo_block_flag_crc) && blockCrc.load(std::memory_order_relaxed);
+            transfer.blockSize = std::max(1, std::min<int>(request[num_byte_block_size_initiate], max_sdo_block_size));
+            transfer.offset = 0;
+            transfer.state = sim_sdo_block_upload_start;
+            answer[num_sdo_command] = static_cast<unsigned char>(sdo_scs_block_upload | (transfer.crc ? sdo_block_flag_crc : 0) | sdo_flag_expedited); // бит s на месте бита e
+            storeSize(answer, static_cast<uint32_t>(transfer.data.size()));
+            return 1;
+        }
+
+        /**
+            * @brief Метод формирования очередного блока чтения с transfer.offset, вызывается под nodesMutex.
+            * @return количество сегментов.
+        */
+        int sendUploadBlock(int node, SimTransfer& transfer, unsigned char (*answers)[udp_len_package]) {
+            transfer.blockStart = transfer.offset;
+            uint32_t size = static_cast<uint32_t>(transfer.data.size());
+            uint32_t offset = transfer.offset;
+            int count = 0;
+            for (int seqno = 1; seqno <= transfer.blockSize && offset < size; seqno++) {
+                uint32_t chunk = std::min<uint32_t>(sdo_segment_payload, size - offset);
+                unsigned char* frame = answers[count++];
+                makeFrame(frame, receive_cobid + node, len_sdo);
+                std::memcpy(frame + first_byte_segment, transfer.data.data() + offset, chunk);
+                offset += chunk;
+                frame[num_sdo_command] = static_cast<unsigned char>(seqno | (offset >= size ? sdo_block_flag_last : 0));
+            }
+            transfer.state = sim_sdo_block_upload_ack;
+            return count;
+        }
+
+        /**
+            * @brief Метод обработки начала и завершения блочной записи, вызывается под nodesMutex.
+            * @param abortCode Код прерывания, если передачу нужно прервать.
+            * @return количество пакетов ответа.
+        */
+        int handleBlockDownload(SimNode& entry, SimTransfer& transfer, const unsigned char* request, unsigned char* answer, uint32_t& abortCode) {
+            unsigned char command = request[num_sdo_command];
+            if ((command & sdo_flag_size_indicated) == 0) { // начало
+                int index = request[num_byte_second_index] | (request[num_byte_dirst_index] << len_uint8);
+                transfer.key = objectKey(index, request[num_byte_subindex]);
+                transfer.crc = (command & sdo_block_flag_crc) && blockCrc.load(std::memory_order_relaxed);
+                transfer.blockSize = max_sdo_block_size;
+                transfer.data.clear();
+                transfer.seqno = 0;
+                transfer.state = sim_sdo_block_download;
+                answer[num_sdo_command] = static_cast<unsigned char>(sdo_scs_block_download | (transfer.crc ? sdo_block_flag_crc : 0));
+                answer[num_byte_block_size_initiate] = static_cast<unsigned char>(transfer.blockSize);
+                return 1;
+            }
+            if (transfer.state != sim_sdo_block_download_end) {
+                abortCode = sdo_abort_command;
+                return 1;
+            }
+            uint32_t unused = (command >> sdo_block_shift_unused) & sdo_mask_segment_unused;
+            transfer.data.resize(transfer.data.size() - std::min<size_t>(unused, transfer.data.size()));
+            uint16_t crc = static_cast<uint16_t>(request[num_byte_block_crc] | (request[num_byte_block_crc + 1] << len_uint8));
+            if (transfer.crc && crc16(transfer.data.data(), static_cast<uint32_t>(transfer.data.size())) != crc) {
+                abortCode = sdo_abort_crc;
+                return 1;
+            }
+            storeTransfer(entry, transfer);
+            answer[num_sdo_command] = sdo_block_end_ack;
+            return 1;
+        }
+
+        /**
+            * @brief Метод приема сегмента блочной записи, вызывается под nodesMutex.
+            * @return количество пакетов ответа (подтверждение в конце блока).
+        */
+        int receiveBlockSegment(int node, SimTransfer& transfer, const unsigned char* request, unsigned char* answer) {
+            int seqno = request[num_sdo_command] & sdo_block_mask_seqno;
+            bool last = (request[num_sdo_command] & sdo_block_flag_last) != 0;
+            if (seqno == transfer.seqno + 1) { // сегмент по порядку
+                transfer.data.insert(transfer.data.end(), request + first_byte_segment, request + first_byte_segment + sdo_segment_payload);
+                transfer.seqno = seqno;
+                if (last) transfer.state = sim_sdo_block_download_end;
+            }
+            if (!last && seqno < transfer.blockSize) return 0;
+            makeFrame(answer, receive_cobid + node, len_sdo);
+            answer[num_sdo_command] = sdo_block_ack;
+            answer[num_byte_block_ackseq] = static_cast<unsigned char>(transfer.seqno);
+            answer[num_byte_block_blksize] = static_cast<unsigned char>(transfer.blockSize);
+            transfer.seqno = 0;
+            return 1;
         }
 
+        /**
+            * @brief Метод сохранения принятого объекта передачи в словарь узла, вызывается под nodesMutex.
+        */
+        static void storeTransfer(SimNode& entry, SimTransfer& transfer) {
+            entry.objects.erase(transfer.key);
+            entry.domains[transfer.key] = transfer.data;
+            transfer.state = sim_sdo_idle;
+        }
+
+        /**
+            * @brief Метод получения байт объекта словаря узла (expedited объект или объект произвольного размера), вызывается под nodesMutex.
+            * @return true - объект есть.
+        */
+        static bool objectBytes(const SimNode& entry, uint32_t key, std::vector<unsigned char>& out) {
+            auto domain = entry.domains.find(key);
+            if (domain != entry.domains.end()) {
+                out = domain->second;
+                return true;
+            }
+            auto it = entry.objects.find(key);
+            if (it == entry.objects.end()) return false;
+            out.resize(it->second.size);
+            for (int b = 0; b < it->second.size; b++) out[b] = static_cast<unsigned char>(it->second.value >> (len_uint8 * b));
+            return true;
+        }
+
+        /**
+            * @brief Метод записи размера объекта в байты данных ответа на начало передачи.
+        */
+        static void storeSize(unsigned char* answer, uint32_t size) {
+            for (int b = 0; b < max_count_byte_payload; b++) answer[first_byte_data_sdo_w + b] = static_cast<unsigned char>(size >> (len_uint8 * b));
+        }
+
+        /**
+            * @brief Метод потока TPDO: в каждый срок все наступившие TPDO всех узлов уходят одной пачкой sendmmsg.
+        */
+        void Producer() {
+            std::vector<unsigned char> buffer((max_node_id + 1) * max_sim_tpdos * udp_len_package); // память выделяется до первого срока
+            unsigned char (*packets)[udp_len_package] = reinterpret_cast<unsigned char (*)[udp_len_package]>(buffer.data());
+            while (running) {
+                uint64_t now = steadyNs();
+                uint64_t wakeup = now + static_cast<uint64_t>(sim_idle_ms) * us_in_ms * ns_in_us;
+                int count = 0;
+                if (hasPeer.load(std::memory_order_acquire)) {
+                    std::lock_guard<std::mutex> lock(nodesMutex);
+                    for (int node = min_node_id; node <= max_node_id; node++) {
+                        if (!nodes[node].present) continue;
+                        for (int n = 0; n < max_sim_tpdos; n++) {
+                            SimTpdo& tpdo = nodes[node].tpdos[n];
+                            if (tpdo.period_ns == 0) continue;
+                            if (tpdo.due_ns <= now) {
+                                makeFrame(packets[count], tpdo_cobid_base + n * tpdo_cobid_step + node, tpdo.len);
+                                uint64_t counter = tpdo.counter++;
+                                for (int b = 0; b < tpdo.len; b++) packets[count][num_byte_payload_pdo + b] = static_cast<unsigned char>(counter >> (len_uint8 * b));
+                                count++;
+                                tpdo.due_ns += tpdo.period_ns;
+                                if (tpdo.due_ns <= now) { // поток опоздал больше чем на период, пропущенное не догоняем
+                                    uint64_t missed = (now - tpdo.due_ns) / tpdo.period_ns + 1;
+                                    overruns.fetch_add(missed, std::memory_order_relaxed);
+                                    tpdo.due_ns += missed * tpdo.period_ns;
+                                }
+                            }
+                            wakeup = std::min(wakeup, tpdo.due_ns);
+                        }
+                    }
+                }
+                if (count > 0) tpdoFrames.fetch_add(sendFrames(packets, count), std::memory_order_relaxed);
+                sleepUntilNs(wakeup);
+            }
+        }
     };
 
 
     // обертки методов для экспорта в dll
-    __declspec(dllexport) int CreateSocket(Worker* instance) {
+    CAN_DLL_EXPORT int CreateSocket(Worker* instance) {
         return instance->CreateSocket();
     }
 
-    __declspec(dllexport) int ConnectToUDPServer(Worker* instance, const char* ipAddress, int port) {
+    CAN_DLL_EXPORT int ConnectToUDPServer(Worker* instance, const char* ipAddress, int port) {
         return instance->ConnectToUDPServer(ipAddress, port);
     }
 
-    __declspec(dllexport) int WriteSDO(Worker* instance, int receiverId, int index, int subIndex, const unsigned char* data, int dataSize, int timeout_ms = 1000) {
+    CAN_DLL_EXPORT int ConnectToCANInterface(Worker* instance, const char* interfaceName) {
+        return instance->ConnectToCANInterface(interfaceName);
+    }
+
+    CAN_DLL_EXPORT int WriteSDO(Worker* instance, int receiverId, int index, int subIndex, const unsigned char* data, int dataSize, int timeout_ms = 1000) {
         return instance->WriteSDO(receiverId, index, subIndex, data, dataSize, timeout_ms);
     }
 
-    __declspec(dllexport) int ReadSDO(Worker* instance, int receiverId, int index, int subIndex, unsigned char* outBuffer, int timeout_ms) {
+    CAN_DLL_EXPORT int ReadSDO(Worker* instance, int receiverId, int index, int subIndex, unsigned char* outBuffer, int timeout_ms) {
         return instance->ReadSDO(receiverId, index, subIndex, outBuffer, timeout_ms);
     }
 
-    __declspec(dllexport) int WritePDO(Worker* instance, int receiverId, int numberPDO, const unsigned char* data, int dataSize) {
+    CAN_DLL_EXPORT int SubmitReadSDO(Worker* instance, int receiverId, int index, int subIndex) {
+        return instance->SubmitSDO(false, receiverId, index, subIndex, nullptr, zero_len);
+    }
+
+    CAN_DLL_EXPORT int SubmitWriteSDO(Worker* instance, int receiverId, int index, int subIndex, const unsigned char* data, int dataSize) {
+        return instance->SubmitSDO(true, receiverId, index, subIndex, data, dataSize);
+    }
+
+    CAN_DLL_EXPORT int CompleteSDO(Worker* instance, int receiverId, unsigned char* outBuffer, int timeout_ms) {
+        return instance->CompleteSDO(receiverId, outBuffer, timeout_ms);
+    }
+
+    CAN_DLL_EXPORT int UploadSDO(Worker* instance, int receiverId, int index, int subIndex, unsigned char* buffer, int capacity, int block, int timeout_ms) {
+        return instance->UploadSDO(receiverId, index, subIndex, buffer, capacity, block != 0, timeout_ms);
+    }
+
+    CAN_DLL_EXPORT int DownloadSDO(Worker* instance, int receiverId, int index, int subIndex, const unsigned char* data, int size, int block, int timeout_ms) {
+        return instance->DownloadSDO(receiverId, index, subIndex, data, size, block != 0, timeout_ms);
+    }
+
+    CAN_DLL_EXPORT int SetSDOBlockSize(Worker* instance, int blockSize) {
+        return instance->SetSDOBlockSize(blockSize);
+    }
+
+    CAN_DLL_EXPORT int GetSDOProgress(Worker* instance, int receiverId, SdoProgress* progress) {
+        return instance->GetSDOProgress(receiverId, progress);
+    }
+
+    CAN_DLL_EXPORT int CancelSDO(Worker* instance, int receiverId) {
+        return instance->CancelSDO(receiverId);
+    }
+
+    CAN_DLL_EXPORT int ReadSDOBatch(Worker* instance, const SdoRequest* reqs, int n, SdoResult* out, int timeout_ms) {
+        return instance->TransferSDOBatch(false, reqs, n, out, timeout_ms);
+    }
+
+    CAN_DLL_EXPORT int WriteSDOBatch(Worker* instance, const SdoRequest* reqs, int n, SdoResult* out, int timeout_ms) {
+        return instance->TransferSDOBatch(true, reqs, n, out, timeout_ms);
+    }
+
+    CAN_DLL_EXPORT int ScanNetwork(Worker* instance, const ScanEntry* entries, int nEntries, ScanNode* nodes, SdoResult* out, int maxNodes, int timeout_ms) {
+        return instance->ScanNetwork(entries, nEntries, nodes, out, maxNodes, timeout_ms);
+    }
+
+    CAN_DLL_EXPORT int WritePDO(Worker* instance, int receiverId, int numberPDO, const unsigned char* data, int dataSize) {
         return instance->WritePDO(receiverId, numberPDO, data, dataSize);
     }
 
-    __declspec(dllexport) int Start_heartbeat(Worker* instance, int period_ms) {
+    CAN_DLL_EXPORT int WritePDOBatch(Worker* instance, const PdoRecord* frames, int n) {
+        return instance->WritePDOBatch(frames, n);
+    }
+
+    CAN_DLL_EXPORT int AddCyclicPDO(Worker* instance, int cobid, const unsigned char* data, int dataSize, int divider) {
+        return instance->AddCyclicPDO(cobid, data, dataSize, divider);
+    }
+
+    CAN_DLL_EXPORT int UpdateCyclicPDO(Worker* instance, int slot, const unsigned char* data, int dataSize) {
+        return instance->UpdateCyclicPDO(slot, data, dataSize);
+    }
+
+    CAN_DLL_EXPORT int RemoveCyclicPDO(Worker* instance, int slot) {
+        return instance->RemoveCyclicPDO(slot);
+    }
+
+    CAN_DLL_EXPORT int StartCyclic(Worker* instance, int period_us, int sync) {
+        return instance->StartCyclic(period_us, sync != 0);
+    }
+
+    CAN_DLL_EXPORT int StopCyclic(Worker* instance) {
+        return instance->StopCyclic();
+    }
+
+    CAN_DLL_EXPORT int GetCyclicStats(Worker* instance, CyclicStats* stats) {
+        return instance->GetCyclicStats(stats);
+    }
+
+    CAN_DLL_EXPORT int EnableTxQueue(Worker* instance, int depth) {
+        return instance->EnableTxQueue(depth);
+    }
+
+    CAN_DLL_EXPORT int SetTxPriority(Worker* instance, const int* order, int count) {
+        return instance->SetTxPriority(order, count);
+    }
+
+    CAN_DLL_EXPORT int SetTxRateLimit(Worker* instance, int txClass, int framesPerSec, int burst) {
+        return instance->SetTxRateLimit(txClass, framesPerSec, burst);
+    }
+
+    CAN_DLL_EXPORT int GetTxQueueStats(Worker* instance, TxQueueStats* stats) {
+        return instance->GetTxQueueStats(stats);
+    }
+
+    CAN_DLL_EXPORT int GetIOStats(Worker* instance, IoStats* stats) {
+        return instance->GetIOStats(stats);
+    }
+
+    CAN_DLL_EXPORT int StartCapture(Worker* instance, const char* path, int bufferRecords) {
+        return instance->StartCapture(path, bufferRecords);
+    }
+
+    CAN_DLL_EXPORT int StopCapture(Worker* instance) {
+        return instance->StopCapture();
+    }
+
+    CAN_DLL_EXPORT int GetCaptureStats(Worker* instance, CaptureStats* stats) {
+        return instance->GetCaptureStats(stats);
+    }
+
+    CAN_DLL_EXPORT int ReplayCapture(Worker* instance, const char* path, int realtime) {
+        return instance->ReplayCapture(path, realtime != 0);
+    }
+
+    CAN_DLL_EXPORT int RunBenchmark(Worker* instance, int iterations, BenchResult* results, int maxResults) {
+        return instance->RunBenchmark(iterations, results, maxResults);
+    }
+
+    CAN_DLL_EXPORT int GetStats(Worker* instance, WorkerStats* stats) {
+        return instance->GetStats(stats);
+    }
+
+    CAN_DLL_EXPORT int GetSDOLatency(Worker* instance, int receiverId, LatencyHistogram* histogram) {
+        return instance->GetSDOLatency(receiverId, histogram);
+    }
+
+    CAN_DLL_EXPORT int EnableCallbackExecutor(Worker* instance, int threads, int depth, int policy, int late_us) {
+        return instance->EnableCallbackExecutor(threads, depth, policy, late_us);
+    }
+
+    CAN_DLL_EXPORT int GetCallbackStats(Worker* instance, CallbackStats* stats) {
+        return instance->GetCallbackStats(stats);
+    }
+
+    CAN_DLL_EXPORT int ResetStats(Worker* instance) {
+        return instance->ResetStats();
+    }
+
+    CAN_DLL_EXPORT int PublishSharedImage(Worker* instance, const char* name, int journalRecords) {
+        return instance->PublishSharedImage(name, journalRecords);
+    }
+
+    CAN_DLL_EXPORT SharedImage* OpenSharedImage(const char* name) {
+        SharedImage* image = new SharedImage(name);
+        if (!image->IsOpen()) { // сегмента нет или он другой версии
+            delete image;
+            return nullptr;
+        }
+        return image;
+    }
+
+    CAN_DLL_EXPORT void CloseSharedImage(SharedImage* image) {
+        delete image;
+    }
+
+    CAN_DLL_EXPORT int SharedImageRead(SharedImage* image, int cobid, ProcessImageEntry* entry) {
+        return image->ReadEntry(cobid, entry);
+    }
+
+    CAN_DLL_EXPORT int SharedImageSnapshot(SharedImage* image, ProcessImageEntry* out, int max) {
+        return image->Snapshot(out, max);
+    }
+
+    CAN_DLL_EXPORT int SharedImageJournal(SharedImage* image, PdoRecord* out, int max, uint64_t* lost) {
+        return image->ReadJournal(out, max, lost);
+    }
+
+    CAN_DLL_EXPORT int SharedImageClosed(SharedImage* image) {
+        return image->Closed();
+    }
+
+    CAN_DLL_EXPORT int EnablePDORing(Worker* instance, int capacity) {
+        return instance->EnablePDORing(capacity);
+    }
+
+    CAN_DLL_EXPORT int DrainPDO(Worker* instance, PdoRecord* out, int max) {
+        return instance->DrainPDO(out, max);
+    }
+
+    CAN_DLL_EXPORT int GetPDORingStats(Worker* instance, PdoRingStats* stats) {
+        return instance->GetPDORingStats(stats);
+    }
+
+    CAN_DLL_EXPORT int RegisterPDOMapping(Worker* instance, int cobid, const int* bitLengths, const int* dataTypes, int count) {
+        return instance->RegisterPDOMapping(cobid, bitLengths, dataTypes, count);
+    }
+
+    CAN_DLL_EXPORT int EnableLatencyTrace(Worker* instance, int sampleEvery, int traceRecords) {
+        return instance->EnableLatencyTrace(sampleEvery, traceRecords);
+    }
+
+    CAN_DLL_EXPORT int GetTraceStats(Worker* instance, TraceStats* stats) {
+        return instance->GetTraceStats(stats);
+    }
+
+    CAN_DLL_EXPORT int ReadTrace(Worker* instance, TraceRecord* out, int max) {
+        return instance->ReadTrace(out, max);
+    }
+
+    CAN_DLL_EXPORT int SetEmcyFilter(Worker* instance, int mode, int maxPerSecond) {
+        return instance->SetEmcyFilter(mode, maxPerSecond);
+    }
+
+    CAN_DLL_EXPORT int ReadEmcyTable(Worker* instance, EmcyState* out, int max) {
+        return instance->ReadEmcyTable(out, max);
+    }
+
+    CAN_DLL_EXPORT int EnableSDOCache(Worker* instance, int ttl_ms) {
+        return instance->EnableSDOCache(ttl_ms);
+    }
+
+    CAN_DLL_EXPORT int SetSDOCacheTTL(Worker* instance, int index, int ttl_ms) {
+        return instance->SetSDOCacheTTL(index, ttl_ms);
+    }
+
+    CAN_DLL_EXPORT int InvalidateSDOCache(Worker* instance, int node) {
+        return instance->InvalidateSDOCache(node);
+    }
+
+    CAN_DLL_EXPORT int GetSDOCacheStats(Worker* instance, SdoCacheStats* stats) {
+        return instance->GetSDOCacheStats(stats);
+    }
+
+    CAN_DLL_EXPORT int EnableAggregation(Worker* instance, int cobid, int window_ms) {
+        return instance->EnableAggregation(cobid, window_ms);
+    }
+
+    CAN_DLL_EXPORT int ReadAggregates(Worker* instance, AggregateArrays* out, int max) {
+        return instance->ReadAggregates(out, max);
+    }
+
+    CAN_DLL_EXPORT int ReadPDOSignals(Worker* instance, int cobid, double* values, int max, uint32_t* updateCount, uint64_t* timestamp_ns) {
+        return instance->ReadPDOSignals(cobid, values, max, updateCount, timestamp_ns);
+    }
+
+    CAN_DLL_EXPORT int ReadSignalTable(Worker* instance, double* values, int max) {
+        return instance->ReadSignalTable(values, max);
+    }
+
+    CAN_DLL_EXPORT int SnapshotProcessImage(Worker* instance, ProcessImageEntry* out, int max) {
+        return instance->SnapshotProcessImage(out, max);
+    }
+
+    CAN_DLL_EXPORT int ReadProcessImageEntry(Worker* instance, int cobid, ProcessImageEntry* entry) {
+        return instance->ReadProcessImageEntry(cobid, entry);
+    }
+
+    CAN_DLL_EXPORT int Subscribe(Worker* instance, int cobid, int mask, int mode, CallbackFunc callback) {
+        return instance->Subscribe(cobid, mask, mode, callback);
+    }
+
+    CAN_DLL_EXPORT int AttachReactor(Worker* instance, Reactor* reactor) {
+        return instance->AttachReactor(reactor);
+    }
+
+    CAN_DLL_EXPORT Reactor* CreateReactor() {
+        return new Reactor();
+    }
+
+    CAN_DLL_EXPORT void DestroyReactor(Reactor* reactor) {
+        delete reactor;
+    }
+
+    CAN_DLL_EXPORT int GetReactorStats(Reactor* reactor, ReactorStats* stats) {
+        return reactor->GetStats(stats);
+    }
+
+    CAN_DLL_EXPORT Simulator* CreateSimulator(const char* ipAddress, int port) {
+        Simulator* simulator = new Simulator(ipAddress, port);
+        if (simulator->GetPort() < 0) { // порт занят или адрес неверный
+            delete simulator;
+            return nullptr;
+        }
+        return simulator;
+    }
+
+    CAN_DLL_EXPORT void DestroySimulator(Simulator* simulator) {
+        delete simulator;
+    }
+
+    CAN_DLL_EXPORT int GetSimulatorPort(Simulator* simulator) {
+        return simulator->GetPort();
+    }
+
+    CAN_DLL_EXPORT int SimAddNode(Simulator* simulator, int node) {
+        return simulator->AddNode(node);
+    }
+
+    CAN_DLL_EXPORT int SimSetObject(Simulator* simulator, int node, int index, int subIndex, uint32_t value, int size) {
+        return simulator->SetObject(node, index, subIndex, value, size);
+    }
+
+    CAN_DLL_EXPORT int SimGetObject(Simulator* simulator, int node, int index, int subIndex, uint32_t* value) {
+        return simulator->GetObject(node, index, subIndex, value);
+    }
+
+    CAN_DLL_EXPORT int SimSetDomain(Simulator* simulator, int node, int index, int subIndex, const unsigned char* data, int size) {
+        return simulator->SetDomain(node, index, subIndex, data, size);
+    }
+
+    CAN_DLL_EXPORT int SimGetDomain(Simulator* simulator, int node, int index, int subIndex, unsigned char* buffer, int capacity) {
+        return simulator->GetDomain(node, index, subIndex, buffer, capacity);
+    }
+
+    CAN_DLL_EXPORT int SimSetBlockCrc(Simulator* simulator, int enabled) {
+        return simulator->SetBlockCrc(enabled);
+    }
+
+    CAN_DLL_EXPORT int SimSetTPDO(Simulator* simulator, int node, int pdoNumber, int period_us, int len) {
+        return simulator->SetTPDO(node, pdoNumber, period_us, len);
+    }
+
+    CAN_DLL_EXPORT int SimInjectEmcy(Simulator* simulator, int node, int errorCode, int errorRegister) {
+        return simulator->InjectEmcy(node, errorCode, errorRegister);
+    }
+
+    CAN_DLL_EXPORT int GetSimulatorStats(Simulator* simulator, SimulatorStats* stats) {
+        return simulator->GetStats(stats);
+    }
+
+    CAN_DLL_EXPORT int Start_heartbeat(Worker* instance, int period_ms) {
         return instance->Start_heartbeat(period_ms);
     }
 
-    __declspec(dllexport) int Stop_heartbeat(Worker* instance) {
+    CAN_DLL_EXPORT int Stop_heartbeat(Worker* instance) {
         return instance->Stop_heartbeat();
     }
 
-    __declspec(dllexport) int RegisterCallback_pdo(Worker* instance, CallbackFunc callback) {
+    CAN_DLL_EXPORT int RegisterCallback_pdo(Worker* instance, CallbackFunc callback) {
         return instance->RegisterCallback_pdo(callback);
     }
 
-    __declspec(dllexport) int RegisterCallback_error(Worker* instance, CallbackFunc callback) {
+    CAN_DLL_EXPORT int RegisterCallback_error(Worker* instance, CallbackFunc callback) {
         return instance->RegisterCallback_error(callback);
     }
 
-    __declspec(dllexport) int Disconnect(Worker* instance) {
+    CAN_DLL_EXPORT int Disconnect(Worker* instance) {
         return instance->Disconnect();
     }
 
-    __declspec(dllexport) Worker* CreateWorker() {
+    CAN_DLL_EXPORT Worker* CreateWorker() {
         return new Worker();
     }
 
-    __declspec(dllexport) void DestroyWorker(Worker* worker) {
+    CAN_DLL_EXPORT void DestroyWorker(Worker* worker) {
         delete worker;
     }
 }
\ No newline at end of file
@@ -6,6 +6,121 @@ const int major_ver_socket = 2;             //мажорная версия (maj
 const int socket_init_success = 0;          //инициализация сокета прошла успешно
 
 const int protocol_socket = 0;              //протокол по умолчанию
+const int connect_timeout_ms = 2000;        //таймаут ожидания первого пакета от socat
+const int listener_poll_us = 50000;         //период пробуждения потока чтения без данных (50 ms)
+const int recv_batch_size = 64;             //максимальное количество датаграмм за одно пробуждение потока чтения
+const int send_batch_size = 64;             //максимальное количество датаграмм за один вызов отправки пачки
+const int reactor_tick_ms = 10;             //шаг колеса таймеров общего потока ввода-вывода
+const int reactor_wheel_slots = 512;        //количество ячеек колеса таймеров (один оборот 5.12 s)
+const int reactor_max_events = 64;          //максимальное количество готовых сокетов за одно пробуждение общего потока
+const int no_timer = -1;                    //таймер не зарегистрирован
+const int default_capture_records = 65536;  //размер каждого из двух буферов записи трафика в записях (2 MB)
+const int capture_flush_ms = 100;           //период сброса буфера записи трафика в файл
+const char capture_magic[8] = "CANCAP1";    //сигнатура файла записи трафика
+const uint32_t capture_version = 1;         //версия формата файла записи трафика
+const int capture_dir_rx = 0;               //принятый пакет
+const int capture_dir_tx = 1;               //отправленный пакет
+const int frame_class_pdo = 0;              //класс пакета для счетчиков: pdo
+const int frame_class_sdo = 1;              //класс пакета для счетчиков: sdo
+const int frame_class_emcy = 2;             //класс пакета для счетчиков: emcy
+const int frame_class_other = 3;            //класс пакета для счетчиков: нераспознанный (heartbeat, nmt, ...)
+const int frame_class_count = 4;            //количество классов пакетов
+const int latency_sub_bits = 3;             //бит точности гистограммы задержек (8 ячеек на каждую степень двойки, погрешность 12.5%)
+const int latency_buckets = 256;            //ячеек гистограммы задержек (до 2^34 нс, больше - в последнюю ячейку)
+const int transport_udp = 0;                //пакеты идут через socat по udp
+const int transport_socketcan = 1;          //пакеты идут напрямую через сокет AF_CAN (только Linux)
+const int can_max_filters = 512;            //максимальное количество фильтров CAN_RAW (CAN_RAW_FILTER_MAX)
+const int subscribe_default = 0;            //подписка: стандартный разбор (pdo/sdo/emcy по диапазону cobid)
+const int subscribe_drop = 1;               //подписка: пакет отбрасывается сразу после чтения
+const int subscribe_latest = 2;             //подписка: только образ процесса и маппинг pdo
+const int subscribe_ring = 3;               //подписка: образ процесса и кольцевой буфер pdo
+const int subscribe_callback = 4;           //подписка: образ процесса и собственный callback cobid
+const uint8_t route_drop = 0;               //маршрут таблицы cobid: отбросить
+const uint8_t route_pdo = 1;                //маршрут таблицы cobid: GetPDO
+const uint8_t route_sdo = 2;                //маршрут таблицы cobid: GetSDO
+const uint8_t route_emcy = 3;               //маршрут таблицы cobid: GetError
+const uint8_t route_latest = 4;             //маршрут таблицы cobid: subscribe_latest
+const uint8_t route_ring = 5;               //маршрут таблицы cobid: subscribe_ring
+const uint8_t route_callback = 6;           //маршрут таблицы cobid: subscribe_callback
+const uint8_t route_heartbeat = 7;          //маршрут таблицы cobid: состояние узла из heartbeat/boot-up
+const int sync_cobid = 0x80;                //cobid сообщения SYNC
+const int max_cyclic_pdos = 256;            //максимальное количество циклических TPDO
+const int min_cyclic_period_us = 100;       //минимальный период циклической отправки
+const int max_cyclic_period_us = 1000000;   //максимальный период циклической отправки (1 s)
+const int max_cyclic_divider = 240;         //максимальный делитель периода TPDO (как у synchronous transmission type)
+const int cyclic_priority = 50;             //приоритет SCHED_FIFO потока циклической отправки (если разрешено)
+const int tx_class_nmt = 0;                 //класс очереди отправки: nmt и sync
+const int tx_class_emcy = 1;                //класс очереди отправки: emcy
+const int tx_class_pdo = 2;                 //класс очереди отправки: pdo (и все нераспознанные cobid)
+const int tx_class_sdo = 3;                 //класс очереди отправки: sdo
+const int tx_class_heartbeat = 4;           //класс очереди отправки: heartbeat
+const int tx_class_count = 5;               //количество классов очереди отправки
+const int default_tx_queue_depth = 1024;    //размер очереди каждого класса по умолчанию
+const int max_tx_queue_depth = 1 << 16;     //максимальный размер очереди каждого класса
+const int tx_socket_buffer = 4096;          //буфер отправки сокета при включенной очереди, чтобы порядок решала очередь, а не ядро
+const int tpdo_cobid_base = 0x180;          //cobid TPDO1 узла 0 (TPDOn узла: base + (n - 1) * step + id)
+const int tpdo_cobid_step = 0x100;          //шаг cobid между TPDO узла
+const int max_sim_tpdos = 4;                //количество TPDO у виртуального узла
+const int emcy_cobid_base = 0x80;           //cobid EMCY узла 0
+const int sim_idle_ms = 10;                 //максимальный сон потока TPDO симулятора (подхват новых настроек)
+const int od_device_type = 0x1000;          //индекс объекта device type
+const int od_identity = 0x1018;             //индекс объекта identity
+const int od_identity_entries = 4;          //сабиндексов identity (vendor, product, revision, serial)
+const uint32_t sim_device_type = 0x191;     //device type виртуального узла (профиль 401)
+const int max_sim_domain_size = 1 << 20;    //максимальный размер объекта виртуального узла для сегментированной и блочной записи
+const int sim_sdo_idle = 0;                 //виртуальный узел: нет многокадровой передачи
+const int sim_sdo_upload_segment = 1;       //виртуальный узел: отдает сегменты чтения
+const int sim_sdo_download_segment = 2;     //виртуальный узел: принимает сегменты записи
+const int sim_sdo_block_upload_start = 3;   //виртуальный узел: ждет старта блочного чтения
+const int sim_sdo_block_upload_ack = 4;     //виртуальный узел: ждет подтверждения отправленного блока
+const int sim_sdo_block_upload_end = 5;     //виртуальный узел: ждет подтверждения завершения блочного чтения
+const int sim_sdo_block_download = 6;       //виртуальный узел: принимает сегменты блока записи
+const int sim_sdo_block_download_end = 7;   //виртуальный узел: ждет завершения блочной записи
+const int bench_frames = 256;               //синтетических пакетов в наборе микробенчмарка (перебираются по кругу)
+const int bench_name_len = 32;              //длина имени результата бенчмарка
+const int bench_results = 8;                //количество результатов RunBenchmark
+const int heartbeat_mask_state = 0x7F;      //маска состояния NMT в heartbeat (старший бит - toggle)
+const int node_state_unknown = -1;          //от узла не было heartbeat/boot-up
+const int node_state_bootup = 0x00;         //состояние NMT boot-up в heartbeat (узел перезагрузился)
+const int scan_flag_heartbeat = 1;          //флаг сканирования: узел прислал heartbeat/boot-up
+const int scan_flag_sdo = 2;                //флаг сканирования: узел ответил на sdo (в том числе прерыванием)
+const int scan_default_entries = 5;         //объектов identity по умолчанию (0x1000, 0x1018:1..4)
+const int max_callback_threads = 8;         //максимальное количество потоков callback'ов
+const int default_callback_queue_depth = 1024; //размер очереди каждого потока callback'ов по умолчанию
+const int max_callback_queue_depth = 1 << 16; //максимальный размер очереди каждого потока callback'ов
+const int callback_policy_drop = 0;         //очередь callback'ов заполнена: новый пакет отбрасывается
+const int callback_policy_coalesce = 1;     //очередь callback'ов заполнена: cobid позже получит последнее значение из образа процесса
+const int default_callback_late_us = 1000;  //callback опоздал, если вызван позже этого времени после приема пакета
+const int callback_idle_ms = 10;            //максимальный сон потока callback'ов без пакетов (страховка от потерянного пробуждения)
+const uint8_t callback_format_pdo = 1;      //буфер callback в формате pdobuffer (cobid, длина, данные)
+const uint8_t callback_format_error = 2;    //буфер callback в формате errorbuffer (cobid, данные)
+const int default_shm_journal_records = 65536; //записей журнала пакетов общей памяти по умолчанию (2 MB)
+const int max_shm_journal_records = 1 << 22; //максимальное количество записей журнала пакетов общей памяти
+const char shm_magic[8] = "CANSHM1";        //сигнатура сегмента общей памяти
+const uint32_t shm_version = 1;             //версия разметки общей памяти
+const int shm_read_attempts = 1000;         //попыток чтения слота общей памяти, пока писатель пишет
+const int max_sdo_cache_entries = 65536;    //максимальное количество объектов в кэше sdo (новые сверх него не кэшируются)
+const int sdo_cache_ttl_forever = -1;       //ttl кэша sdo: объект не устаревает по времени
+const int sdo_cache_ttl_default = -2;       //ttl индекса в кэше sdo: как у всего кэша (снять переопределение)
+const int sdo_cache_all_nodes = 0;          //сбросить кэш sdo всех узлов
+const int max_od_index = 0xFFFF;            //максимальный индекс объекта словаря
+const int emcy_deliver_all = 0;             //доставка emcy в errorbuffer/callback_error: каждый пакет
+const int emcy_deliver_on_change = 1;       //доставка emcy: только при смене кода ошибки или регистра ошибок узла
+const int max_emcy_rate = 100000;           //максимальный лимит доставки emcy одного узла в секунду
+const int emcy_offset_register = 2;         //смещение регистра ошибок в данных emcy (после кода ошибки)
+const int trace_disabled = -1;              //EnableLatencyTrace: выключить трассировку задержек
+const int default_trace_records = 4096;     //записей выборочной трассы пакетов по умолчанию
+const int max_trace_records = 1 << 20;      //максимальное количество записей выборочной трассы пакетов
+const int trace_stage_kernel = 0;           //этап: прием датаграммы ядром -> поток чтения забрал ее
+const int trace_stage_dispatch = 1;         //этап: поток чтения забрал пакет -> пакет передан потребителю (образ, кольцо, слот sdo, callback)
+const int trace_stage_callback_wait = 2;    //этап: пакет передан -> поток callback'ов вызвал callback (очередь)
+const int trace_stage_callback_run = 3;     //этап: callback вызван -> callback вернул управление (время python)
+const int trace_stage_sdo_wake = 4;         //этап: ответ sdo разложен в слот -> ожидающий поток забрал его
+const int trace_stage_total = 5;            //весь путь: прием ядром (без отметки ядра - потоком чтения) -> конец пути пакета
+const int trace_stage_count = 6;            //количество этапов трассировки
+const int ms_in_sec = 1000;                 //миллисекунд в секунде
+const int us_in_ms = 1000;                  //микросекунд в миллисекунде
+const int ns_in_us = 1000;                  //наносекунд в микросекунде
 
 const int udp_len_package = 16;             //длинна используемых в canopen udp пакетов
 
@@ -80,3 +195,431 @@ const int command_write_payload_sdo = 0x23; //максимальное коли
 const int max_count_byte_payload = 4;       //максимальная длина данных для sdo пакета
 const int shift_command_len_payload = 2;    //сдвиг для формирования команды записи с учетом протокола canopen
 const int command_sdo_read = 0x40;          //команда чтения sdo
+
+const int min_node_id = 1;                  //минимальный id узла canopen
+const int max_node_id = 127;                //максимальный id узла canopen
+const int sdo_pending = 0;                  //ответ на асинхронный sdo запрос еще не получен
+
+const int batch_end = -1;                   //конец очереди запросов узла в пакетном sdo запросе
+
+const int sdo_flag_size_indicated = 0x01;   //бит команды ответа sdo: размер данных указан
+const int sdo_mask_unused_bytes = 0x03;     //маска количества незначимых байт в команде ответа sdo
+
+const int sdo_mask_scs = 0xE0;              //маска кода команды сервера sdo
+const int sdo_scs_upload_segment = 0x00;    //сервер: сегмент чтения
+const int sdo_scs_download_segment = 0x20;  //сервер: подтверждение сегмента записи
+const int sdo_scs_upload_initiate = 0x40;   //сервер: ответ на начало чтения
+const int sdo_scs_block_download = 0xA0;    //сервер: блочная запись
+const int sdo_scs_block_upload = 0xC0;      //сервер: блочное чтение
+const int sdo_command_abort = 0x80;         //команда прерывания передачи sdo
+const int sdo_flag_expedited = 0x02;        //бит команды sdo: данные в самом пакете (expedited)
+const int sdo_flag_toggle = 0x10;           //бит переключения сегментированной передачи
+const int sdo_flag_last_segment = 0x01;     //бит последнего сегмента сегментированной передачи
+const int sdo_shift_toggle = 4;             //сдвиг бита переключения
+const int sdo_shift_segment_unused = 1;     //сдвиг количества незначимых байт сегмента
+const int sdo_mask_segment_unused = 0x07;   //маска количества незначимых байт сегмента
+const int sdo_segment_payload = 7;          //байт данных в одном сегменте
+const int first_byte_segment = 9;           //номер байта пакета с первым байтом данных сегмента
+const int sdo_ccs_download_segmented = 0x21;//клиент: начало сегментированной записи с указанием размера
+const int sdo_ccs_upload_segment = 0x60;    //клиент: запрос сегмента чтения
+const int sdo_block_upload_initiate = 0xA4; //клиент: начало блочного чтения с поддержкой crc
+const int sdo_block_upload_start = 0xA3;    //клиент: старт передачи блоков чтения
+const int sdo_block_ack = 0xA2;             //подтверждение блока (клиент при чтении, сервер при записи)
+const int sdo_block_end_ack = 0xA1;         //подтверждение завершения блочной передачи
+const int sdo_block_download_initiate = 0xC6; //клиент: начало блочной записи с crc и размером
+const int sdo_block_download_end = 0xC1;    //клиент: завершение блочной записи
+const int sdo_mask_block_download = 0xE3;   //маска команды сервера блочной записи
+const int sdo_mask_block_upload = 0xE1;     //маска команды сервера блочного чтения
+const int sdo_block_flag_crc = 0x04;        //бит поддержки crc в блочной передаче
+const int sdo_block_flag_last = 0x80;       //бит последнего сегмента блока
+const int sdo_block_mask_seqno = 0x7F;      //маска номера сегмента блока
+const int sdo_block_shift_unused = 2;       //сдвиг количества незначимых байт в завершении блочной передачи
+const int num_byte_block_ackseq = 9;        //номер байта номера последнего принятого сегмента
+const int num_byte_block_blksize = 10;      //номер байта размера следующего блока в подтверждении
+const int num_byte_block_size_initiate = 12;//номер байта размера блока в начале блочного чтения
+const int num_byte_block_crc = 9;           //номер байта crc в завершении блочной передачи
+const int max_sdo_block_size = 127;         //максимальное количество сегментов в блоке
+const int crc16_poly = 0x1021;              //полином crc16-ccitt блочной передачи
+const int crc16_top_bit = 0x8000;           //старший бит crc16
+
+const uint32_t sdo_abort_toggle = 0x05030000;  //код прерывания: бит переключения не изменился
+const uint32_t sdo_abort_timeout = 0x05040000; //код прерывания: таймаут протокола sdo
+const uint32_t sdo_abort_crc = 0x05040004;     //код прерывания: ошибка crc
+const uint32_t sdo_abort_memory = 0x05040005;  //код прерывания: не хватает памяти
+const uint32_t sdo_abort_command = 0x05040001; //код прерывания: неизвестная или неподдерживаемая команда
+const uint32_t sdo_abort_no_object = 0x06020000; //код прерывания: объект отсутствует в словаре
+const uint32_t sdo_abort_general = 0x08000000; //код прерывания: общая ошибка
+
+const int sdo_mode_expedited = 0;           //передача sdo в одном пакете
+const int sdo_mode_segmented = 1;           //сегментированная передача sdo
+const int sdo_mode_block = 2;               //блочная передача sdo
+const int sdo_state_initiate = 0;           //ждем ответ на начало передачи
+const int sdo_state_segment = 1;            //ждем сегмент или подтверждение сегмента
+const int sdo_state_block_data = 2;         //принимаем сегменты блока
+const int sdo_state_block_ack = 3;          //ждем подтверждения отправленного блока
+const int sdo_state_block_end = 4;          //ждем завершения блочной передачи
+
+/**
+    * Ход последней многокадровой SDO передачи узла.
+*/
+struct SdoProgress {
+    uint32_t transferred;                   // передано байт
+    uint32_t total;                         // размер объекта (0 - узел не сообщил)
+    uint64_t elapsed_ns;                    // длительность передачи, нс
+    uint32_t abortCode;                     // код прерывания последней передачи (0 - нет)
+    int32_t active;                         // 1 - передача идет
+};
+
+const int max_len_pdo_payload = 8;          //максимальная длина payload pdo пакета
+const int max_pdo_ring_capacity = 1 << 20;  //максимальное количество записей в кольцевом буфере pdo
+const int cache_line_size = 64;             //размер кэш-линии для разнесения счетчиков потоков
+
+const int max_cobid = 0x7FF;                //максимальный 11-битный cobid
+const int max_pdo_mappings = 512;           //максимальное количество cobid с зарегистрированным маппингом
+const int max_pdo_signals = 4096;           //максимальное количество сигналов во всех маппингах
+const int max_pdo_bits = 64;                //максимальная длина payload pdo в битах
+const int no_pdo_mapping = -1;              //у cobid нет маппинга
+const int pdo_type_unsigned = 0;            //тип сигнала pdo: беззнаковое целое
+const int pdo_type_signed = 1;              //тип сигнала pdo: знаковое целое
+const int pdo_type_float32 = 2;             //тип сигнала pdo: float32 (только 32 бита)
+const int max_aggregate_window_ms = 60000;  //максимальное окно агрегации сигналов pdo (1 мин)
+
+const int image_pdo_slots = max_cobid_pdo - min_cobid_pdo + 1;       //количество слотов образа процесса для pdo
+const int image_error_slots = max_cobid_error - min_cobid_error + 1; //количество слотов образа процесса для emcy
+const int image_slots = image_pdo_slots + image_error_slots;          //всего слотов образа процесса
+
+/**
+    * Состояние одного cobid в образе процесса.
+*/
+struct ProcessImageEntry {
+    uint16_t cobid;                         // cobid пакета
+    uint8_t len;                            // количество значимых байт последнего пакета
+    uint8_t reserved;                       // выравнивание
+    uint32_t updates;                       // количество принятых пакетов
+    uint64_t timestamp_ns;                  // время приема последнего пакета (steady_clock), нс
+    uint8_t data[max_len_pdo_payload];      // payload последнего пакета
+};
+
+/**
+    * Запись кольцевого буфера принятых PDO.
+*/
+struct PdoRecord {
+    uint64_t timestamp_ns;                  // время приема пакета (steady_clock), нс
+    uint16_t cobid;                         // cobid пакета
+    uint8_t len;                            // количество значимых байт
+    uint8_t reserved[5];                    // выравнивание
+    uint8_t data[max_len_pdo_payload];      // payload пакета
+};
+
+/**
+    * Счетчики кольцевого буфера принятых PDO.
+*/
+struct PdoRingStats {
+    uint32_t capacity;                      // размер буфера в записях
+    uint32_t size;                          // записей ожидает выборки
+    uint32_t highWater;                     // максимальное заполнение буфера
+    uint32_t reserved;                      // выравнивание
+    uint64_t pushed;                        // записей положено в буфер
+    uint64_t overflows;                     // пакетов потеряно из-за переполнения буфера
+};
+
+/**
+    * Счетчики системных вызовов и датаграмм приема/передачи.
+*/
+struct IoStats {
+    uint64_t rxSyscalls;                    // вызовов приема
+    uint64_t rxFrames;                      // принятых датаграмм
+    uint64_t txSyscalls;                    // вызовов отправки pdo
+    uint64_t txFrames;                      // отправленных pdo
+};
+
+/**
+    * Запрос пакетного чтения/записи SDO.
+*/
+struct SdoRequest {
+    int32_t receiverId;                     // ID узла назначения
+    int32_t index;                          // индекс SDO объекта
+    int32_t subIndex;                       // сабиндекс SDO объекта
+    int32_t dataSize;                       // количество байт данных (только для записи)
+    uint8_t data[max_count_byte_payload];   // данные для записи (только для записи)
+};
+
+/**
+    * Результаты пакетного чтения/записи SDO в виде отдельных массивов по n элементов.
+    * Массивы выделяет вызывающий (например numpy), ненужные поля могут быть nullptr.
+*/
+struct SdoResult {
+    int32_t* status;                        // код результата каждого запроса (как у ReadSDO/WriteSDO)
+    int32_t* dataSize;                      // количество значимых байт в прочитанном значении
+    uint32_t* value;                        // прочитанное значение (little-endian, незначимые байты обнулены)
+};
+
+/**
+    * Счетчики общего потока ввода-вывода (Reactor).
+*/
+struct ReactorStats {
+    uint64_t wakeups;                       // пробуждений потока
+    uint64_t readyEvents;                   // готовых к чтению сокетов
+    uint64_t timerFires;                    // срабатываний таймеров
+    uint32_t sources;                       // обслуживаемых сокетов
+    uint32_t timers;                        // активных таймеров
+};
+
+/**
+    * Заголовок файла записи трафика, за ним идут записи CaptureRecord до конца файла.
+*/
+struct CaptureHeader {
+    char magic[8];                          // capture_magic
+    uint32_t version;                       // capture_version
+    uint32_t recordSize;                    // sizeof(CaptureRecord)
+    uint64_t startTimestamp_ns;             // время начала записи (steady_clock)
+    uint64_t reserved;
+};
+
+/**
+    * Запись файла трафика: сырой пакет socat с временем и направлением.
+*/
+struct CaptureRecord {
+    uint64_t timestamp_ns;                  // время приема/отправки (steady_clock)
+    uint8_t direction;                      // capture_dir_rx или capture_dir_tx
+    uint8_t reserved[7];
+    uint8_t frame[udp_len_package];         // пакет как он пришел/ушел в сокет
+};
+
+/**
+    * Счетчики записи трафика.
+*/
+struct CaptureStats {
+    uint64_t records;                       // записей передано в файл
+    uint64_t dropped;                       // записей потеряно, фоновый поток не успел сбросить буфер
+    uint64_t flushes;                       // сбросов буфера в файл
+    int32_t active;                         // 1 - запись идет
+    int32_t reserved;
+};
+
+/**
+    * Гистограмма задержек в наносекундах с логарифмически-линейными ячейками (как HdrHistogram).
+    * Значения меньше 2^latency_sub_bits лежат в ячейке со своим номером, дальше каждая степень двойки
+    * делится на 2^latency_sub_bits равных ячеек. Нижняя граница ячейки i >= 8: (8 + i % 8) << (i / 8 - 1).
+*/
+struct LatencyHistogram {
+    uint64_t count;                         // количество измерений
+    uint64_t sum_ns;                        // сумма измерений
+    uint64_t buckets[latency_buckets];      // количество измерений в ячейке
+};
+
+/**
+    * Счетчики и гистограммы Worker.
+*/
+struct WorkerStats {
+    uint64_t rxFrames[frame_class_count];   // принятые пакеты по классам frame_class_*
+    uint64_t txFrames[frame_class_count];   // отправленные пакеты по классам frame_class_*
+    uint64_t rxSyscalls;                    // вызовов приема
+    uint64_t txSyscalls;                    // вызовов отправки pdo
+    uint64_t listenerWakeups;               // пробуждений потока чтения с данными
+    uint64_t idleWakeups;                   // пробуждений потока чтения по таймауту без данных
+    uint64_t shortDatagrams;                // датаграмм короче udp_len_package
+    uint64_t sdoUnmatched;                  // ответов sdo, которые никто не ждал
+    uint64_t sdoTimeouts;                   // sdo запросов без ответа
+    uint64_t sdoAborts;                     // sdo передач, завершенных прерыванием
+    uint64_t pdoLengthErrors;               // pdo с маппингом другой длины
+    uint64_t pdoRingOverflows;              // pdo потерянных при переполнении кольцевого буфера
+    uint64_t captureDropped;                // пакетов потерянных записью трафика
+    LatencyHistogram sdoRoundTrip;          // от отправки expedited sdo запроса до ответа, все узлы
+    LatencyHistogram callback;              // время выполнения callback_pdo и callback_error
+};
+
+/**
+    * Счетчики потока циклической отправки TPDO и SYNC.
+*/
+struct CyclicStats {
+    uint64_t cycles;                        // отработанных периодов
+    uint64_t overruns;                      // пропущенных периодов (поток проснулся позже следующего срока)
+    uint64_t framesSent;                    // отправленных пакетов (SYNC и TPDO)
+    uint64_t sendErrors;                    // ошибок отправки пачки
+    uint64_t maxLateness_ns;                // максимальное опоздание пробуждения относительно срока
+    uint32_t period_us;                     // период, 0 - поток не запущен
+    uint32_t pdos;                          // зарегистрированных TPDO
+    LatencyHistogram lateness;              // опоздание пробуждения относительно срока каждого периода
+};
+
+/**
+    * Счетчики очереди отправки по классам tx_class_*.
+*/
+struct TxQueueStats {
+    uint64_t enqueued[tx_class_count];      // пакетов поставлено в очередь
+    uint64_t sent[tx_class_count];          // пакетов отправлено
+    uint64_t dropped[tx_class_count];       // пакетов отброшено (очередь заполнена или отключились)
+    uint32_t depth[tx_class_count];         // пакетов ждет отправки
+    uint32_t highWater[tx_class_count];     // максимальное заполнение очереди
+    uint64_t batches;                       // вызовов отправки пачки
+    LatencyHistogram latency[tx_class_count]; // время от постановки в очередь до отправки
+};
+
+/**
+    * Счетчики симулятора узлов CANopen.
+*/
+struct SimulatorStats {
+    uint64_t rxFrames;                      // принятых от dll пакетов
+    uint64_t txFrames;                      // отправленных в dll пакетов
+    uint64_t sdoRequests;                   // обработанных sdo запросов
+    uint64_t sdoAborts;                     // ответов sdo с прерыванием
+    uint64_t tpdoFrames;                    // отправленных TPDO
+    uint64_t emcyFrames;                    // отправленных EMCY
+    uint64_t txSyscalls;                    // вызовов отправки
+    uint64_t overruns;                      // сроков TPDO, пропущенных из-за опоздания потока
+};
+
+/**
+    * Результат одного микробенчмарка RunBenchmark.
+*/
+struct BenchResult {
+    char name[bench_name_len];              // имя измерения
+    uint64_t iterations;                    // количество операций
+    uint64_t total_ns;                      // время всех операций
+};
+
+/**
+    * Объект словаря для чтения со всех узлов при сканировании сети.
+*/
+struct ScanEntry {
+    int32_t index;                          // индекс SDO объекта
+    int32_t subIndex;                       // сабиндекс SDO объекта
+};
+
+/**
+    * Найденный при сканировании сети узел.
+*/
+struct ScanNode {
+    int32_t nodeId;                         // ID узла
+    int32_t state;                          // последнее состояние NMT из heartbeat, node_state_unknown - heartbeat не было
+    int32_t flags;                          // scan_flag_*
+    uint32_t heartbeatAge_ms;               // сколько прошло с последнего heartbeat к концу сканирования
+};
+
+/**
+    * Счетчики потоков callback'ов.
+*/
+struct CallbackStats {
+    uint64_t enqueued;                      // пакетов поставлено в очереди
+    uint64_t delivered;                     // вызовов callback из потоков callback'ов
+    uint64_t dropped;                       // пакетов отброшено (очередь заполнена или отключились)
+    uint64_t coalesced;                     // пакетов заменено последним значением cobid (callback_policy_coalesce)
+    uint64_t late;                          // callback'ов вызвано позже порога опоздания
+    uint32_t threads;                       // потоков callback'ов, 0 - callback'и вызывает поток чтения
+    uint32_t highWater;                     // максимальное заполнение очереди
+    LatencyHistogram delay;                 // от приема пакета до вызова callback
+};
+
+/**
+    * Заголовок сегмента общей памяти с образом процесса. За ним идут slotCount слотов ShmSlot (смещение slotsOffset)
+    * и журнал из journalCapacity записей ShmRecord (смещение journalOffset). Все числа пишет только Worker,
+    * поля journalHead, closed и поля слотов/записей меняются атомарно.
+*/
+struct ShmHeader {
+    char magic[8];                          // shm_magic
+    uint32_t version;                       // shm_version
+    uint32_t headerSize;                    // sizeof(ShmHeader)
+    uint32_t slotCount;                     // image_slots
+    uint32_t slotSize;                      // sizeof(ShmSlot)
+    uint32_t journalCapacity;               // записей журнала (степень двойки)
+    uint32_t recordSize;                    // sizeof(ShmRecord)
+    uint64_t slotsOffset;                   // смещение первого слота от начала сегмента
+    uint64_t journalOffset;                 // смещение первой записи журнала от начала сегмента
+    uint64_t journalHead;                   // записей журнала всего, запись n лежит в ячейке n % journalCapacity
+    uint64_t created_ns;                    // время создания сегмента (steady_clock писателя)
+    uint32_t writerPid;                     // процесс Worker
+    uint32_t closed;                        // 1 - Worker закрыл сегмент, новых данных не будет
+};
+
+/**
+    * Слот образа процесса в общей памяти (seqlock: нечетный seq - идет запись), по одному на кэш-линию.
+*/
+struct ShmSlot {
+    uint32_t seq;                           // счетчик версий
+    uint32_t updates;                       // количество принятых пакетов
+    uint64_t timestamp_ns;                  // время приема последнего пакета (steady_clock)
+    uint16_t cobid;                         // cobid слота (не меняется)
+    uint8_t len;                            // количество значимых байт
+    uint8_t reserved[5];
+    uint8_t data[max_len_pdo_payload];      // payload последнего пакета
+    uint8_t padding[32];
+};
+
+/**
+    * Запись журнала пакетов в общей памяти.
+*/
+struct ShmRecord {
+    uint64_t seq;                           // номер записи + 1, 0 - запись идет
+    uint64_t timestamp_ns;                  // время приема (steady_clock)
+    uint16_t cobid;                         // cobid пакета
+    uint8_t len;                            // количество значимых байт
+    uint8_t reserved[5];
+    uint8_t data[max_len_pdo_payload];      // payload пакета
+};
+
+/**
+    * Массивы агрегатов сигналов PDO за последнее завершенное окно (индекс - номер сигнала, как в ReadSignalTable).
+    * Массивы выделяет вызывающий (например numpy), ненужные поля могут быть nullptr.
+*/
+struct AggregateArrays {
+    double* min;                            // минимум за окно
+    double* max;                            // максимум за окно
+    double* mean;                           // среднее за окно
+    double* last;                           // последнее значение окна
+    uint32_t* count;                        // пакетов в окне, 0 - у cobid нет агрегации или окно еще не завершилось
+    uint64_t* windowEnd_ns;                 // конец окна (steady_clock, кратно длине окна)
+};
+
+/**
+    * Статистика кэша SDO.
+*/
+struct SdoCacheStats {
+    uint64_t hits;                          // ReadSDO ответил из кэша без обмена с узлом
+    uint64_t misses;                        // объекта не было в кэше
+    uint64_t stale;                         // объект был, но устарел по ttl или узел перезагрузился/сменил состояние NMT
+    uint64_t writeThrough;                  // успешных записей sdo, обновивших кэш
+    uint64_t invalidations;                 // объектов удалено InvalidateSDOCache и неудачными записями
+    uint32_t entries;                       // объектов в кэше сейчас
+    uint32_t reserved;
+};
+
+/**
+    * Состояние ошибок узла по его EMCY.
+*/
+struct EmcyState {
+    int32_t nodeId;
+    uint16_t errorCode;                     // код ошибки последнего emcy (0 - ошибки сброшены)
+    uint8_t errorRegister;                  // регистр ошибок последнего emcy
+    uint8_t reserved;
+    uint64_t occurrences;                   // emcy с текущими кодом и регистром подряд
+    uint64_t total;                         // всех emcy узла
+    uint64_t delivered;                     // emcy, переданных в errorbuffer/callback_error
+    uint64_t suppressed;                    // emcy, отброшенных фильтром повторов и лимитом
+    uint64_t firstSeen_ns;                  // первый emcy с текущими кодом и регистром (steady_clock)
+    uint64_t lastSeen_ns;                   // последний emcy
+};
+
+/**
+    * Выборочная трасса одного пакета, время steady_clock в наносекундах, 0 - пакет не проходил этап.
+*/
+struct TraceRecord {
+    uint32_t cobid;
+    uint32_t reserved;
+    uint64_t kernel_ns;                     // прием ядром (SO_TIMESTAMPNS)
+    uint64_t received_ns;                   // поток чтения забрал датаграмму
+    uint64_t dispatched_ns;                 // пакет передан потребителю
+    uint64_t callbackEntered_ns;            // callback вызван
+    uint64_t callbackReturned_ns;           // callback вернул управление
+};
+
+/**
+    * Разбивка задержек принятых пакетов по этапам trace_stage_*.
+*/
+struct TraceStats {
+    uint64_t stamped;                       // пакетов с временем приема ядром
+    uint64_t unstamped;                     // пакетов без него (транспорт или ОС не дали отметку)
+    uint64_t sampled;                       // записей выборочной трассы
+    uint64_t dropped;                       // записей трассы, затертых до ReadTrace
+    LatencyHistogram stages[trace_stage_count];
+};
@@ -44,8 +44,307 @@ TYPES_MAP = {
     'float64': ('d',8),
 }
 
+# коды типов сигналов для RegisterPDOMapping (pdo_type_* в can_dll.h)
+PDO_TYPE_CODES = {
+    'uint8': 0, 'uint16': 0, 'uint32': 0, 'uint64': 0,
+    'int8': 1, 'int16': 1, 'int32': 1, 'int64': 1,
+    'float32': 2,
+}
+
 CALLBACK_FUNC = ctypes.CFUNCTYPE(None,POINTER(c_ubyte))
 
+# режимы Subscribe (subscribe_* в can_dll.h)
+SUBSCRIBE_MODES = {
+    'default': 0,   # стандартный разбор по диапазону cobid
+    'drop': 1,      # отбросить сразу после чтения
+    'latest': 2,    # только образ процесса и маппинг pdo
+    'ring': 3,      # кольцевой буфер pdo
+    'callback': 4,  # собственный callback cobid
+}
+
+# записи файла трафика (struct CaptureRecord в can_dll.h), direction: 0 - прием, 1 - отправка
+CAPTURE_HEADER_SIZE = 32
+CAPTURE_DTYPE = np.dtype([('timestamp_ns', '<u8'),
+                          ('direction', 'u1'),
+                          ('reserved', 'u1', 7),
+                          ('frame', 'u1', 16)])
+
+class SdoRequest(ctypes.Structure):
+    """
+    Запрос пакетного чтения/записи SDO (struct SdoRequest в can_dll.h).
+    """
+    _fields_ = [('receiverId', ctypes.c_int32),
+                ('index', ctypes.c_int32),
+                ('subIndex', ctypes.c_int32),
+                ('dataSize', ctypes.c_int32),
+                ('data', c_ubyte * 4)]
+
+class PdoRecord(ctypes.Structure):
+    """
+    Запись кольцевого буфера принятых PDO (struct PdoRecord в can_dll.h).
+    """
+    _fields_ = [('timestamp_ns', ctypes.c_uint64),
+                ('cobid', ctypes.c_uint16),
+                ('len', ctypes.c_uint8),
+                ('reserved', c_ubyte * 5),
+                ('data', c_ubyte * 8)]
+
+class ProcessImageEntry(ctypes.Structure):
+    """
+    Состояние одного cobid в образе процесса (struct ProcessImageEntry в can_dll.h).
+    """
+    _fields_ = [('cobid', ctypes.c_uint16),
+                ('len', ctypes.c_uint8),
+                ('reserved', ctypes.c_uint8),
+                ('updates', ctypes.c_uint32),
+                ('timestamp_ns', ctypes.c_uint64),
+                ('data', c_ubyte * 8)]
+
+class PdoRingStats(ctypes.Structure):
+    """
+    Счетчики кольцевого буфера принятых PDO (struct PdoRingStats в can_dll.h).
+    """
+    _fields_ = [('capacity', ctypes.c_uint32),
+                ('size', ctypes.c_uint32),
+                ('highWater', ctypes.c_uint32),
+                ('reserved', ctypes.c_uint32),
+                ('pushed', ctypes.c_uint64),
+                ('overflows', ctypes.c_uint64)]
+
+class IoStats(ctypes.Structure):
+    """
+    Счетчики системных вызовов приема/передачи (struct IoStats в can_dll.h).
+    """
+    _fields_ = [('rxSyscalls', ctypes.c_uint64),
+                ('rxFrames', ctypes.c_uint64),
+                ('txSyscalls', ctypes.c_uint64),
+                ('txFrames', ctypes.c_uint64)]
+
+class SdoProgress(ctypes.Structure):
+    """
+    Ход многокадровой SDO передачи (struct SdoProgress в can_dll.h).
+    """
+    _fields_ = [('transferred', ctypes.c_uint32),
+                ('total', ctypes.c_uint32),
+                ('elapsed_ns', ctypes.c_uint64),
+                ('abortCode', ctypes.c_uint32),
+                ('active', ctypes.c_int32)]
+
+class ReactorStats(ctypes.Structure):
+    """
+    Счетчики общего потока ввода-вывода (struct ReactorStats в can_dll.h).
+    """
+    _fields_ = [('wakeups', ctypes.c_uint64),
+                ('readyEvents', ctypes.c_uint64),
+                ('timerFires', ctypes.c_uint64),
+                ('sources', ctypes.c_uint32),
+                ('timers', ctypes.c_uint32)]
+
+class CaptureStats(ctypes.Structure):
+    """
+    Счетчики записи трафика (struct CaptureStats в can_dll.h).
+    """
+    _fields_ = [('records', ctypes.c_uint64),
+                ('dropped', ctypes.c_uint64),
+                ('flushes', ctypes.c_uint64),
+                ('active', ctypes.c_int32),
+                ('reserved', ctypes.c_int32)]
+
+class LatencyHistogram(ctypes.Structure):
+    """
+    Гистограмма задержек в наносекундах (struct LatencyHistogram в can_dll.h).
+    """
+    _fields_ = [('count', ctypes.c_uint64),
+                ('sum_ns', ctypes.c_uint64),
+                ('buckets', ctypes.c_uint64 * 256)]
+
+FRAME_CLASSES = ('pdo', 'sdo', 'emcy', 'other')  # порядок frame_class_* в can_dll.h
+
+class WorkerStats(ctypes.Structure):
+    """
+    Счетчики и гистограммы Worker (struct WorkerStats в can_dll.h).
+    """
+    _fields_ = [('rxFrames', ctypes.c_uint64 * 4),
+                ('txFrames', ctypes.c_uint64 * 4),
+                ('rxSyscalls', ctypes.c_uint64),
+                ('txSyscalls', ctypes.c_uint64),
+                ('listenerWakeups', ctypes.c_uint64),
+                ('idleWakeups', ctypes.c_uint64),
+                ('shortDatagrams', ctypes.c_uint64),
+                ('sdoUnmatched', ctypes.c_uint64),
+                ('sdoTimeouts', ctypes.c_uint64),
+                ('sdoAborts', ctypes.c_uint64),
+                ('pdoLengthErrors', ctypes.c_uint64),
+                ('pdoRingOverflows', ctypes.c_uint64),
+                ('captureDropped', ctypes.c_uint64),
+                ('sdoRoundTrip', LatencyHistogram),
+                ('callback', LatencyHistogram)]
+
+class CyclicStats(ctypes.Structure):
+    """
+    Счетчики потока циклической отправки TPDO и SYNC (struct CyclicStats в can_dll.h).
+    """
+    _fields_ = [('cycles', ctypes.c_uint64),
+                ('overruns', ctypes.c_uint64),
+                ('framesSent', ctypes.c_uint64),
+                ('sendErrors', ctypes.c_uint64),
+                ('maxLateness_ns', ctypes.c_uint64),
+                ('period_us', ctypes.c_uint32),
+                ('pdos', ctypes.c_uint32),
+                ('lateness', LatencyHistogram)]
+
+TX_CLASSES = ('nmt', 'emcy', 'pdo', 'sdo', 'heartbeat')  # порядок tx_class_* в can_dll.h
+
+class TxQueueStats(ctypes.Structure):
+    """
+    Счетчики очереди отправки по классам (struct TxQueueStats в can_dll.h).
+    """
+    _fields_ = [('enqueued', ctypes.c_uint64 * 5),
+                ('sent', ctypes.c_uint64 * 5),
+                ('dropped', ctypes.c_uint64 * 5),
+                ('depth', ctypes.c_uint32 * 5),
+                ('highWater', ctypes.c_uint32 * 5),
+                ('batches', ctypes.c_uint64),
+                ('latency', LatencyHistogram * 5)]
+
+# этапы трассировки задержек (trace_stage_* в can_dll.h)
+TRACE_STAGES = ['kernel', 'dispatch', 'callback_wait', 'callback_run', 'sdo_wake', 'total']
+
+class TraceRecord(ctypes.Structure):
+    """
+    Выборочная трасса одного пакета (struct TraceRecord в can_dll.h).
+    """
+    _fields_ = [('cobid', ctypes.c_uint32),
+                ('reserved', ctypes.c_uint32),
+                ('kernel_ns', ctypes.c_uint64),
+                ('received_ns', ctypes.c_uint64),
+                ('dispatched_ns', ctypes.c_uint64),
+                ('callbackEntered_ns', ctypes.c_uint64),
+                ('callbackReturned_ns', ctypes.c_uint64)]
+
+class TraceStats(ctypes.Structure):
+    """
+    Разбивка задержек принятых пакетов по этапам (struct TraceStats в can_dll.h).
+    """
+    _fields_ = [('stamped', ctypes.c_uint64),
+                ('unstamped', ctypes.c_uint64),
+                ('sampled', ctypes.c_uint64),
+                ('dropped', ctypes.c_uint64),
+                ('stages', LatencyHistogram * len(TRACE_STAGES))]
+
+class EmcyState(ctypes.Structure):
+    """
+    Состояние ошибок узла по его EMCY (struct EmcyState в can_dll.h).
+    """
+    _fields_ = [('nodeId', ctypes.c_int32),
+                ('errorCode', ctypes.c_uint16),
+                ('errorRegister', ctypes.c_uint8),
+                ('reserved', ctypes.c_uint8),
+                ('occurrences', ctypes.c_uint64),
+                ('total', ctypes.c_uint64),
+                ('delivered', ctypes.c_uint64),
+                ('suppressed', ctypes.c_uint64),
+                ('firstSeen_ns', ctypes.c_uint64),
+                ('lastSeen_ns', ctypes.c_uint64)]
+
+class SdoCacheStats(ctypes.Structure):
+    """
+    Статистика кэша SDO (struct SdoCacheStats в can_dll.h).
+    """
+    _fields_ = [('hits', ctypes.c_uint64),
+                ('misses', ctypes.c_uint64),
+                ('stale', ctypes.c_uint64),
+                ('writeThrough', ctypes.c_uint64),
+                ('invalidations', ctypes.c_uint64),
+                ('entries', ctypes.c_uint32),
+                ('reserved', ctypes.c_uint32)]
+
+class CallbackStats(ctypes.Structure):
+    """
+    Счетчики потоков callback'ов (struct CallbackStats в can_dll.h).
+    """
+    _fields_ = [('enqueued', ctypes.c_uint64),
+                ('delivered', ctypes.c_uint64),
+                ('dropped', ctypes.c_uint64),
+                ('coalesced', ctypes.c_uint64),
+                ('late', ctypes.c_uint64),
+                ('threads', ctypes.c_uint32),
+                ('highWater', ctypes.c_uint32),
+                ('delay', LatencyHistogram)]
+
+class BenchResult(ctypes.Structure):
+    """
+    Результат микробенчмарка (struct BenchResult в can_dll.h).
+    """
+    _fields_ = [('name', ctypes.c_char * 32),
+                ('iterations', ctypes.c_uint64),
+                ('total_ns', ctypes.c_uint64)]
+
+
+class SimulatorStats(ctypes.Structure):
+    """
+    Счетчики симулятора узлов CANopen (struct SimulatorStats в can_dll.h).
+    """
+    _fields_ = [('rxFrames', ctypes.c_uint64),
+                ('txFrames', ctypes.c_uint64),
+                ('sdoRequests', ctypes.c_uint64),
+                ('sdoAborts', ctypes.c_uint64),
+                ('tpdoFrames', ctypes.c_uint64),
+                ('emcyFrames', ctypes.c_uint64),
+                ('txSyscalls', ctypes.c_uint64),
+                ('overruns', ctypes.c_uint64)]
+
+def histogram_percentile(histogram: LatencyHistogram, p: float) -> int:
+    """
+    Перцентиль гистограммы задержек dll (нижняя граница ячейки, погрешность до 12.5%).
+
+    @param histogram: Гистограмма из GetStats/GetSDOLatency.
+    @param p: Перцентиль от 0 до 1.
+    @return: Задержка в наносекундах, 0 если измерений нет.
+    """
+    target = histogram.count * p
+    accumulated = 0
+    for i, count in enumerate(histogram.buckets):
+        accumulated += count
+        if count and accumulated >= target:
+            return i if i < 8 else (8 + i % 8) << (i // 8 - 1)
+    return 0
+
+class SdoResult(ctypes.Structure):
+    """
+    Указатели на массивы результатов пакетного чтения/записи SDO (struct SdoResult в can_dll.h).
+    """
+    _fields_ = [('status', POINTER(ctypes.c_int32)),
+                ('dataSize', POINTER(ctypes.c_int32)),
+                ('value', POINTER(ctypes.c_uint32))]
+
+class AggregateArrays(ctypes.Structure):
+    """
+    Указатели на массивы агрегатов сигналов PDO за последнее окно (struct AggregateArrays в can_dll.h).
+    """
+    _fields_ = [('min', POINTER(ctypes.c_double)),
+                ('max', POINTER(ctypes.c_double)),
+                ('mean', POINTER(ctypes.c_double)),
+                ('last', POINTER(ctypes.c_double)),
+                ('count', POINTER(ctypes.c_uint32)),
+                ('windowEnd_ns', POINTER(ctypes.c_uint64))]
+
+class ScanEntry(ctypes.Structure):
+    """
+    Объект словаря для чтения при сканировании сети (struct ScanEntry в can_dll.h).
+    """
+    _fields_ = [('index', ctypes.c_int32),
+                ('subIndex', ctypes.c_int32)]
+
+class ScanNode(ctypes.Structure):
+    """
+    Найденный при сканировании сети узел (struct ScanNode в can_dll.h).
+    """
+    _fields_ = [('nodeId', ctypes.c_int32),
+                ('state', ctypes.c_int32),
+                ('flags', ctypes.c_int32),
+                ('heartbeatAge_ms', ctypes.c_uint32)]
+
 # загружаем dll
 def load_dll(name_dll: str) -> int:
     """
@@ -97,15 +396,242 @@ def load_functions(dll : ctypes.CDLL) -> int:
         dll.ConnectToUDPServer.argtypes = [POINTER(c_void_p), c_char_p, c_int]
         dll.ConnectToUDPServer.restype = c_int
 
+        dll.ConnectToCANInterface.argtypes = [POINTER(c_void_p), c_char_p]
+        dll.ConnectToCANInterface.restype = c_int
+
         dll.WriteSDO.argtypes = [POINTER(c_void_p), c_int, c_int, c_int, POINTER(c_ubyte), c_int, c_int]
         dll.WriteSDO.restype = c_int
 
         dll.ReadSDO.argtypes = [POINTER(c_void_p), c_int, c_int, c_int, POINTER(c_ubyte), c_int]
         dll.ReadSDO.restype = c_int
 
+        dll.SubmitReadSDO.argtypes = [POINTER(c_void_p), c_int, c_int, c_int]
+        dll.SubmitReadSDO.restype = c_int
+
+        dll.SubmitWriteSDO.argtypes = [POINTER(c_void_p), c_int, c_int, c_int, POINTER(c_ubyte), c_int]
+        dll.SubmitWriteSDO.restype = c_int
+
+        dll.CompleteSDO.argtypes = [POINTER(c_void_p), c_int, POINTER(c_ubyte), c_int]
+        dll.CompleteSDO.restype = c_int
+
+        dll.CancelSDO.argtypes = [POINTER(c_void_p), c_int]
+        dll.CancelSDO.restype = c_int
+
+        dll.UploadSDO.argtypes = [POINTER(c_void_p), c_int, c_int, c_int, POINTER(c_ubyte), c_int, c_int, c_int]
+        dll.UploadSDO.restype = c_int
+
+        dll.DownloadSDO.argtypes = [POINTER(c_void_p), c_int, c_int, c_int, POINTER(c_ubyte), c_int, c_int, c_int]
+        dll.DownloadSDO.restype = c_int
+
+        dll.SetSDOBlockSize.argtypes = [POINTER(c_void_p), c_int]
+        dll.SetSDOBlockSize.restype = c_int
+
+        dll.GetSDOProgress.argtypes = [POINTER(c_void_p), c_int, POINTER(SdoProgress)]
+        dll.GetSDOProgress.restype = c_int
+
+        dll.ReadSDOBatch.argtypes = [POINTER(c_void_p), POINTER(SdoRequest), c_int, POINTER(SdoResult), c_int]
+        dll.ReadSDOBatch.restype = c_int
+
+        dll.ScanNetwork.argtypes = [POINTER(c_void_p), POINTER(ScanEntry), c_int, POINTER(ScanNode), POINTER(SdoResult), c_int, c_int]
+        dll.ScanNetwork.restype = c_int
+
+        dll.WriteSDOBatch.argtypes = [POINTER(c_void_p), POINTER(SdoRequest), c_int, POINTER(SdoResult), c_int]
+        dll.WriteSDOBatch.restype = c_int
+
         dll.WritePDO.argtypes = [POINTER(c_void_p), c_int, c_int, POINTER(c_ubyte), c_int]
         dll.WritePDO.restype = c_int
 
+        dll.WritePDOBatch.argtypes = [POINTER(c_void_p), POINTER(PdoRecord), c_int]
+        dll.WritePDOBatch.restype = c_int
+
+        dll.AddCyclicPDO.argtypes = [POINTER(c_void_p), c_int, POINTER(c_ubyte), c_int, c_int]
+        dll.AddCyclicPDO.restype = c_int
+
+        dll.UpdateCyclicPDO.argtypes = [POINTER(c_void_p), c_int, POINTER(c_ubyte), c_int]
+        dll.UpdateCyclicPDO.restype = c_int
+
+        dll.RemoveCyclicPDO.argtypes = [POINTER(c_void_p), c_int]
+        dll.RemoveCyclicPDO.restype = c_int
+
+        dll.StartCyclic.argtypes = [POINTER(c_void_p), c_int, c_int]
+        dll.StartCyclic.restype = c_int
+
+        dll.StopCyclic.argtypes = [POINTER(c_void_p)]
+        dll.StopCyclic.restype = c_int
+
+        dll.GetCyclicStats.argtypes = [POINTER(c_void_p), POINTER(CyclicStats)]
+        dll.GetCyclicStats.restype = c_int
+
+        dll.EnableTxQueue.argtypes = [POINTER(c_void_p), c_int]
+        dll.EnableTxQueue.restype = c_int
+
+        dll.SetTxPriority.argtypes = [POINTER(c_void_p), POINTER(c_int), c_int]
+        dll.SetTxPriority.restype = c_int
+
+        dll.SetTxRateLimit.argtypes = [POINTER(c_void_p), c_int, c_int, c_int]
+        dll.SetTxRateLimit.restype = c_int
+
+        dll.GetTxQueueStats.argtypes = [POINTER(c_void_p), POINTER(TxQueueStats)]
+        dll.GetTxQueueStats.restype = c_int
+
+        dll.EnableCallbackExecutor.argtypes = [POINTER(c_void_p), c_int, c_int, c_int, c_int]
+        dll.EnableCallbackExecutor.restype = c_int
+
+        dll.GetCallbackStats.argtypes = [POINTER(c_void_p), POINTER(CallbackStats)]
+        dll.GetCallbackStats.restype = c_int
+
+        dll.EnableLatencyTrace.argtypes = [POINTER(c_void_p), c_int, c_int]
+        dll.EnableLatencyTrace.restype = c_int
+
+        dll.GetTraceStats.argtypes = [POINTER(c_void_p), POINTER(TraceStats)]
+        dll.GetTraceStats.restype = c_int
+
+        dll.ReadTrace.argtypes = [POINTER(c_void_p), POINTER(TraceRecord), c_int]
+        dll.ReadTrace.restype = c_int
+
+        dll.SetEmcyFilter.argtypes = [POINTER(c_void_p), c_int, c_int]
+        dll.SetEmcyFilter.restype = c_int
+
+        dll.ReadEmcyTable.argtypes = [POINTER(c_void_p), POINTER(EmcyState), c_int]
+        dll.ReadEmcyTable.restype = c_int
+
+        dll.EnableSDOCache.argtypes = [POINTER(c_void_p), c_int]
+        dll.EnableSDOCache.restype = c_int
+
+        dll.SetSDOCacheTTL.argtypes = [POINTER(c_void_p), c_int, c_int]
+        dll.SetSDOCacheTTL.restype = c_int
+
+        dll.InvalidateSDOCache.argtypes = [POINTER(c_void_p), c_int]
+        dll.InvalidateSDOCache.restype = c_int
+
+        dll.GetSDOCacheStats.argtypes = [POINTER(c_void_p), POINTER(SdoCacheStats)]
+        dll.GetSDOCacheStats.restype = c_int
+
+        dll.GetIOStats.argtypes = [POINTER(c_void_p), POINTER(IoStats)]
+        dll.GetIOStats.restype = c_int
+
+        dll.EnablePDORing.argtypes = [POINTER(c_void_p), c_int]
+        dll.EnablePDORing.restype = c_int
+
+        dll.DrainPDO.argtypes = [POINTER(c_void_p), POINTER(PdoRecord), c_int]
+        dll.DrainPDO.restype = c_int
+
+        dll.GetPDORingStats.argtypes = [POINTER(c_void_p), POINTER(PdoRingStats)]
+        dll.GetPDORingStats.restype = c_int
+
+        dll.RegisterPDOMapping.argtypes = [POINTER(c_void_p), c_int, POINTER(c_int), POINTER(c_int), c_int]
+        dll.RegisterPDOMapping.restype = c_int
+
+        dll.ReadPDOSignals.argtypes = [POINTER(c_void_p), c_int, POINTER(ctypes.c_double), c_int, POINTER(ctypes.c_uint32), POINTER(ctypes.c_uint64)]
+        dll.ReadPDOSignals.restype = c_int
+
+        dll.ReadSignalTable.argtypes = [POINTER(c_void_p), POINTER(ctypes.c_double), c_int]
+        dll.ReadSignalTable.restype = c_int
+
+        dll.EnableAggregation.argtypes = [POINTER(c_void_p), c_int, c_int]
+        dll.EnableAggregation.restype = c_int
+
+        dll.ReadAggregates.argtypes = [POINTER(c_void_p), POINTER(AggregateArrays), c_int]
+        dll.ReadAggregates.restype = c_int
+
+        dll.SnapshotProcessImage.argtypes = [POINTER(c_void_p), POINTER(ProcessImageEntry), c_int]
+        dll.SnapshotProcessImage.restype = c_int
+
+        dll.ReadProcessImageEntry.argtypes = [POINTER(c_void_p), c_int, POINTER(ProcessImageEntry)]
+        dll.ReadProcessImageEntry.restype = c_int
+
+        dll.PublishSharedImage.argtypes = [POINTER(c_void_p), c_char_p, c_int]
+        dll.PublishSharedImage.restype = c_int
+
+        dll.OpenSharedImage.argtypes = [c_char_p]
+        dll.OpenSharedImage.restype = c_void_p
+
+        dll.CloseSharedImage.argtypes = [c_void_p]
+
+        dll.SharedImageRead.argtypes = [c_void_p, c_int, POINTER(ProcessImageEntry)]
+        dll.SharedImageRead.restype = c_int
+
+        dll.SharedImageSnapshot.argtypes = [c_void_p, POINTER(ProcessImageEntry), c_int]
+        dll.SharedImageSnapshot.restype = c_int
+
+        dll.SharedImageJournal.argtypes = [c_void_p, POINTER(PdoRecord), c_int, POINTER(ctypes.c_uint64)]
+        dll.SharedImageJournal.restype = c_int
+
+        dll.SharedImageClosed.argtypes = [c_void_p]
+        dll.SharedImageClosed.restype = c_int
+
+        dll.GetStats.argtypes = [POINTER(c_void_p), POINTER(WorkerStats)]
+        dll.GetStats.restype = c_int
+
+        dll.GetSDOLatency.argtypes = [POINTER(c_void_p), c_int, POINTER(LatencyHistogram)]
+        dll.GetSDOLatency.restype = c_int
+
+        dll.ResetStats.argtypes = [POINTER(c_void_p)]
+        dll.ResetStats.restype = c_int
+
+        dll.StartCapture.argtypes = [POINTER(c_void_p), c_char_p, c_int]
+        dll.StartCapture.restype = c_int
+
+        dll.StopCapture.argtypes = [POINTER(c_void_p)]
+        dll.StopCapture.restype = c_int
+
+        dll.GetCaptureStats.argtypes = [POINTER(c_void_p), POINTER(CaptureStats)]
+        dll.GetCaptureStats.restype = c_int
+
+        dll.ReplayCapture.argtypes = [POINTER(c_void_p), c_char_p, c_int]
+        dll.ReplayCapture.restype = c_int
+
+        dll.RunBenchmark.argtypes = [POINTER(c_void_p), c_int, POINTER(BenchResult), c_int]
+        dll.RunBenchmark.restype = c_int
+
+        dll.CreateReactor.restype = c_void_p
+
+        dll.DestroyReactor.argtypes = [c_void_p]
+
+        dll.Subscribe.argtypes = [POINTER(c_void_p), c_int, c_int, c_int, CALLBACK_FUNC]
+        dll.Subscribe.restype = c_int
+
+        dll.AttachReactor.argtypes = [POINTER(c_void_p), c_void_p]
+        dll.AttachReactor.restype = c_int
+
+        dll.GetReactorStats.argtypes = [c_void_p, POINTER(ReactorStats)]
+        dll.GetReactorStats.restype = c_int
+
+        dll.CreateSimulator.argtypes = [c_char_p, c_int]
+        dll.CreateSimulator.restype = c_void_p
+
+        dll.DestroySimulator.argtypes = [c_void_p]
+
+        dll.GetSimulatorPort.argtypes = [c_void_p]
+        dll.GetSimulatorPort.restype = c_int
+
+        dll.SimAddNode.argtypes = [c_void_p, c_int]
+        dll.SimAddNode.restype = c_int
+
+        dll.SimSetObject.argtypes = [c_void_p, c_int, c_int, c_int, ctypes.c_uint32, c_int]
+        dll.SimSetObject.restype = c_int
+
+        dll.SimGetObject.argtypes = [c_void_p, c_int, c_int, c_int, POINTER(ctypes.c_uint32)]
+        dll.SimGetObject.restype = c_int
+
+        dll.SimSetDomain.argtypes = [c_void_p, c_int, c_int, c_int, POINTER(c_ubyte), c_int]
+        dll.SimSetDomain.restype = c_int
+
+        dll.SimGetDomain.argtypes = [c_void_p, c_int, c_int, c_int, POINTER(c_ubyte), c_int]
+        dll.SimGetDomain.restype = c_int
+
+        dll.SimSetBlockCrc.argtypes = [c_void_p, c_int]
+        dll.SimSetBlockCrc.restype = c_int
+
+        dll.SimSetTPDO.argtypes = [c_void_p, c_int, c_int, c_int, c_int]
+        dll.SimSetTPDO.restype = c_int
+
+        dll.SimInjectEmcy.argtypes = [c_void_p, c_int, c_int, c_int]
+        dll.SimInjectEmcy.restype = c_int
+
+        dll.GetSimulatorStats.argtypes = [c_void_p, POINTER(SimulatorStats)]
+        dll.GetSimulatorStats.restype = c_int
+
         dll.Start_heartbeat.argtypes = [POINTER(c_void_p), c_int]
         dll.Start_heartbeat.restype = c_int
 
@@ -157,6 +683,162 @@ def is_convertible_to_float32(value : float) -> bool:
         logger.error(f"Ошибка преобразования числа типа float: {e}")
         return False
 
+def read_capture(path: str) -> np.ndarray:
+    """
+    Открывает файл записи трафика dll (StartCapture) без чтения в память.
+
+    @param path: Путь к файлу.
+    @return: Массив записей CAPTURE_DTYPE поверх файла (np.memmap).
+    """
+    return np.memmap(path, dtype=CAPTURE_DTYPE, mode='r', offset=CAPTURE_HEADER_SIZE)
+
+class SharedImageReader():
+    def __init__(self, dll: ctypes.CDLL, name: str='/can_image'):
+        """
+            Читатель образа процесса и журнала пакетов, которые публикует CanWorker другого процесса
+            (publish_shared_image). Своего подключения к socat не нужно.
+
+            @param dll: Экземпляр загруженной DLL.
+            @param name: Имя сегмента общей памяти.
+        """
+        self.dll = dll
+        self.instance = self.dll.OpenSharedImage(name.encode('utf-8'))
+        if not self.instance:
+            raise OSError(f"Сегмент общей памяти {name} не найден или создан другой версией dll")
+
+    def __del__(self):
+        """
+        Деструктор, снимает отображение сегмента.
+        """
+        if getattr(self, 'instance', None):
+            self.dll.CloseSharedImage(self.instance)
+            self.instance = None
+
+    def read(self, cobid: int):
+        """
+        Читает последнее значение cobid (PDO или EMCY).
+
+        @return: ProcessImageEntry или None, если cobid вне образа процесса.
+        """
+        entry = ProcessImageEntry()
+        return entry if self.dll.SharedImageRead(self.instance, cobid, ctypes.byref(entry)) > 0 else None
+
+    def snapshot(self) -> dict:
+        """
+        Копирует образ процесса: словарь cobid -> ProcessImageEntry всех cobid, от которых что-то приходило.
+        """
+        entries = (ProcessImageEntry * 1200)()
+        count = self.dll.SharedImageSnapshot(self.instance, entries, len(entries))
+        return {entry.cobid: entry for entry in entries[:count]}
+
+    def journal(self, max_records: int=4096) -> tuple:
+        """
+        Забирает новые пакеты журнала с прошлого вызова.
+
+        @return: Список PdoRecord и количество пакетов, перезаписанных до чтения.
+        """
+        records = (PdoRecord * max_records)()
+        lost = ctypes.c_uint64()
+        count = self.dll.SharedImageJournal(self.instance, records, max_records, ctypes.byref(lost))
+        return records[:count], lost.value
+
+    def closed(self) -> bool:
+        """
+        Возвращает True, если публикующий процесс закрыл сегмент.
+        """
+        return self.dll.SharedImageClosed(self.instance) == 1
+
+class CanSimulator():
+    def __init__(self, dll: ctypes.CDLL, ip: str='127.0.0.1', port: int=0):
+        """
+            Виртуальные узлы CANopen внутри dll вместо ПЛК с socat. CanWorker подключается к ним
+            через connect_to_udp_server(ip, self.port).
+
+            @param dll: Экземпляр загруженной DLL.
+            @param ip: Адрес для привязки.
+            @param port: Порт, 0 - любой свободный.
+        """
+        self.dll = dll
+        self.instance = self.dll.CreateSimulator(ip.encode('utf-8'), port)
+        if not self.instance:
+            raise OSError(f"Не удалось привязать симулятор к {ip}:{port}")
+        self.port = self.dll.GetSimulatorPort(self.instance)
+
+    def __del__(self):
+        """
+        Деструктор, останавливает потоки симулятора.
+        """
+        if getattr(self, 'instance', None):
+            self.dll.DestroySimulator(self.instance)
+            self.instance = None
+
+    def add_nodes(self, nodes) -> int:
+        """
+        Добавляет виртуальные узлы (объекты 0x1000 и 0x1018 заполняются автоматически).
+
+        @param nodes: Итерируемое с id узлов.
+        @return: 1 если все узлы добавлены, иначе код ошибки.
+        """
+        for node in nodes:
+            res = self.dll.SimAddNode(self.instance, node)
+            if res < 0: return res
+        return 1
+
+    def set_object(self, node: int, index: int, sub_index: int, value: int, size: int=4) -> int:
+        """
+        Записывает объект словаря виртуального узла.
+        """
+        return self.dll.SimSetObject(self.instance, node, index, sub_index, value, size)
+
+    def get_object(self, node: int, index: int, sub_index: int) -> int:
+        """
+        Читает объект словаря виртуального узла (например после WriteSDO), отрицательное значение - код ошибки.
+        """
+        value = ctypes.c_uint32()
+        res = self.dll.SimGetObject(self.instance, node, index, sub_index, ctypes.byref(value))
+        return value.value if res > 0 else res
+
+    def set_domain(self, node: int, index: int, sub_index: int, data: bytes) -> int:
+        """
+        Записывает объект словаря виртуального узла произвольного размера (для UploadSDO).
+        """
+        buffer = (c_ubyte * len(data)).from_buffer_copy(data)
+        return self.dll.SimSetDomain(self.instance, node, index, sub_index, buffer, len(data))
+
+    def get_domain(self, node: int, index: int, sub_index: int, capacity: int=1 << 20) -> bytes | int:
+        """
+        Читает объект словаря виртуального узла произвольного размера (например после DownloadSDO), int - код ошибки.
+        """
+        buffer = (c_ubyte * capacity)()
+        res = self.dll.SimGetDomain(self.instance, node, index, sub_index, buffer, capacity)
+        return bytes(buffer[:res]) if res >= 0 else res
+
+    def set_block_crc(self, enabled: bool) -> int:
+        """
+        Включает или выключает поддержку crc блочной передачи у виртуальных узлов.
+        """
+        return self.dll.SimSetBlockCrc(self.instance, 1 if enabled else 0)
+
+    def set_tpdo(self, node: int, number_pdo: int, period_us: int, length: int=8) -> int:
+        """
+        Включает периодическую отправку TPDO узла (payload - счетчик отправок), period_us = 0 выключает.
+        """
+        return self.dll.SimSetTPDO(self.instance, node, number_pdo, period_us, length)
+
+    def inject_emcy(self, node: int, error_code: int, error_register: int=1) -> int:
+        """
+        Отправляет EMCY от имени узла.
+        """
+        return self.dll.SimInjectEmcy(self.instance, node, error_code, error_register)
+
+    def get_stats(self) -> dict:
+        """
+        Возвращает счетчики симулятора.
+        """
+        stats = SimulatorStats()
+        self.dll.GetSimulatorStats(self.instance, ctypes.byref(stats))
+        return {name: getattr(stats, name) for name, _ in SimulatorStats._fields_}
+
 class CanWorker():
     def __init__(self, dll: ctypes.CDLL, pdo_objects: dict, ssh_ip: str, ssh_port: int=22, usr: str='root', psw: str='1'):
         """
@@ -185,6 +867,7 @@ class CanWorker():
 
         self.callback_func = None
         self.callback_func_error = None
+        self.subscriptions = {} # ссылки на callback'и подписок, чтобы их не собрал сборщик мусора
 
     def __del__(self):
         """
@@ -280,6 +963,31 @@ class CanWorker():
         else:
             return -1
 
+    def connect_to_can_interface(self, interface: str) -> int:
+        """
+        Подключение напрямую к CAN интерфейсу Linux (SocketCAN, например vcan0) без socat.
+
+        @param interface: Имя интерфейса.
+        @return: 1 если подключение успешно, иначе код ошибки dll, -5 если уже подключено.
+        """
+
+        if self.isConnected: return -5
+
+        res = self.dll.ConnectToCANInterface(self.worker_instance, interface.encode('utf-8'))
+        if res > 0:
+            self.isConnected = True
+        return res
+
+    def attach_reactor(self, reactor: int) -> int:
+        """
+        Передает сокет в общий поток ввода-вывода (dll.CreateReactor) вместо собственного потока чтения.
+        Вызывается до подключения, один общий поток может обслуживать все шины стенда.
+
+        @param reactor: Указатель, который вернул dll.CreateReactor, или None.
+        @return: 1 если успешно, -1 если уже подключены.
+        """
+        return self.dll.AttachReactor(self.worker_instance, reactor)
+
     def WriteSDO(self,node_id: int, index: int, sub_index: int, data:int | float, data_type: str, timeout_ms: int) -> int:
         """
         Записывает данные в объект SDO (Service Data Object).
@@ -347,6 +1055,127 @@ class CanWorker():
         else:
             return read_result
 
+    def UploadSDO(self, node_id: int, index: int, sub_index: int, capacity: int, timeout_ms: int, block: bool=False) -> bytes | int:
+        """
+        Читает SDO объект любого размера (строки, массивы, файлы) сегментированной или блочной передачей.
+
+        @param node_id: Идентификатор узла.
+        @param index: Индекс объекта.
+        @param sub_index: Подиндекс объекта.
+        @param capacity: Максимальный ожидаемый размер объекта в байтах.
+        @param timeout_ms: Время ожидания очередного пакета от узла в миллисекундах.
+        @param block: True - блочная передача.
+        @return: Прочитанные байты или код ошибки.
+        """
+
+        if not self.isConnected: return -1
+
+        buffer = (c_ubyte * capacity)()
+        read_result = self.dll.UploadSDO(self.worker_instance, node_id, index, sub_index, buffer, capacity, int(block), timeout_ms)
+        if read_result < 0:
+            return read_result
+        return bytes(buffer[:read_result])
+
+    def DownloadSDO(self, node_id: int, index: int, sub_index: int, data: bytes, timeout_ms: int, block: bool=False) -> int:
+        """
+        Записывает SDO объект любого размера сегментированной или блочной передачей.
+
+        @param node_id: Идентификатор узла.
+        @param index: Индекс объекта.
+        @param sub_index: Подиндекс объекта.
+        @param data: Данные объекта.
+        @param timeout_ms: Время ожидания очередного пакета от узла в миллисекундах.
+        @param block: True - блочная передача.
+        @return: 1 если запись успешна, иначе код ошибки.
+        """
+
+        if not self.isConnected: return -1
+
+        buffer = (c_ubyte * len(data)).from_buffer_copy(data)
+        return self.dll.DownloadSDO(self.worker_instance, node_id, index, sub_index, buffer, len(data), int(block), timeout_ms)
+
+    def GetSDOProgress(self, node_id: int) -> SdoProgress:
+        """
+        Возвращает ход текущей или последней многокадровой передачи узла (можно вызывать из другого потока).
+        """
+        progress = SdoProgress()
+        self.dll.GetSDOProgress(self.worker_instance, node_id, ctypes.byref(progress))
+        return progress
+
+    def ReadSDOBatch(self, requests: list, timeout_ms: int) -> tuple[np.ndarray, np.ndarray]:
+        """
+        Читает несколько SDO объектов одним вызовом dll.
+
+        @param requests: Список кортежей (node_id, index, sub_index).
+        @param timeout_ms: Время ожидания ответа на каждый запрос в миллисекундах.
+        @return: Массивы кодов результата и прочитанных значений.
+        """
+        n = len(requests)
+        status = np.full(n, -2, dtype=np.int32)
+        values = np.zeros(n, dtype=np.uint32)
+        if not self.isConnected: return status, values
+
+        reqs = (SdoRequest * n)(*[SdoRequest(node_id, index, sub_index, 0) for node_id, index, sub_index in requests])
+        result = SdoResult(status.ctypes.data_as(POINTER(ctypes.c_int32)), None, values.ctypes.data_as(POINTER(ctypes.c_uint32)))
+        self.dll.ReadSDOBatch(self.worker_instance, reqs, n, ctypes.byref(result), timeout_ms)
+        return status, values
+
+    def ScanNetwork(self, entries: list=None, timeout_ms: int=200) -> list:
+        """
+        Ищет узлы 1..127 и читает с каждого найденного список объектов словаря. Все сканирование занимает
+        не больше timeout_ms, сколько бы узлов ни отсутствовало.
+
+        @param entries: Список кортежей (index, sub_index), None - 0x1000 и 0x1018:1..4.
+        @param timeout_ms: Время сканирования в миллисекундах.
+        @return: Список словарей найденных узлов: node_id, state (None - heartbeat не было), heartbeat, sdo,
+                 values - словарь (index, sub_index) -> значение или отрицательный код ошибки.
+        """
+        if not self.isConnected: return []
+        if entries is None:
+            entries = [(0x1000, 0)] + [(0x1018, sub_index) for sub_index in range(1, 5)]
+        n = len(entries)
+        table = (ScanEntry * n)(*[ScanEntry(index, sub_index) for index, sub_index in entries])
+        nodes = (ScanNode * 127)()
+        status = np.zeros(127 * n, dtype=np.int32)
+        values = np.zeros(127 * n, dtype=np.uint32)
+        result = SdoResult(status.ctypes.data_as(POINTER(ctypes.c_int32)), None, values.ctypes.data_as(POINTER(ctypes.c_uint32)))
+        found = self.dll.ScanNetwork(self.worker_instance, table, n, nodes, ctypes.byref(result), len(nodes), timeout_ms)
+        scan = []
+        for k in range(max(found, 0)):
+            node = nodes[k]
+            row = range(k * n, (k + 1) * n)
+            scan.append({'node_id': node.nodeId,
+                         'state': node.state if node.state >= 0 else None,
+                         'heartbeat': bool(node.flags & 1),
+                         'sdo': bool(node.flags & 2),
+                         'values': {entry: int(values[i]) if status[i] == 1 else int(status[i]) for entry, i in zip(entries, row)}})
+        return scan
+
+    def WriteSDOBatch(self, requests: list, data_type: str, timeout_ms: int) -> np.ndarray:
+        """
+        Записывает несколько SDO объектов одного типа одним вызовом dll.
+
+        @param requests: Список кортежей (node_id, index, sub_index, data).
+        @param data_type: Тип данных ('uint8', 'uint16', 'uint32', 'float32').
+        @param timeout_ms: Время ожидания ответа на каждый запрос в миллисекундах.
+        @return: Массив кодов результата.
+        """
+        n = len(requests)
+        status = np.full(n, -2, dtype=np.int32)
+        if not self.isConnected: return status
+
+        reqs = (SdoRequest * n)()
+        for i, (node_id, index, sub_index, data) in enumerate(requests):
+            res, raw = number_to_bytes(data, data_type)
+            if res < 0:
+                logger.error(f"Ошибка упаковки данных в пакет значение:{data} тип:{data_type}")
+                status[i] = -5
+                raw = b''
+            reqs[i] = SdoRequest(node_id, index, sub_index, len(raw), (c_ubyte * 4)(*raw))
+        result = SdoResult(status.ctypes.data_as(POINTER(ctypes.c_int32)), None, None)
+        self.dll.WriteSDOBatch(self.worker_instance, reqs, n, ctypes.byref(result), timeout_ms)
+        return status
+
     def WritePDO(self, node_id: int, number_pdo: int, pdo_data: c_ubyte):
         """
         Запись PDO пакета в шину
@@ -357,6 +1186,241 @@ class CanWorker():
         res = dll.WritePDO(self.worker_instance, node_id, number_pdo, pdo_data, data_size)
         return res
 
+    def enable_tx_queue(self, depth: int=0) -> int:
+        """
+        Включает очередь отправки dll: пакеты уходят в порядке приоритета классов, SDO и heartbeat не ждут за пачками PDO.
+        Вызывать до connect.
+
+        @param depth: Размер очереди каждого класса, 0 - по умолчанию, -1 - выключить.
+        @return: 1 если успешно, иначе код ошибки.
+        """
+        return self.dll.EnableTxQueue(self.worker_instance, depth)
+
+    def set_tx_priority(self, order: list) -> int:
+        """
+        Задает порядок классов очереди отправки.
+
+        @param order: Имена классов из TX_CLASSES от высшего приоритета к низшему.
+        @return: 1 если успешно, -2 если порядок неверный.
+        """
+        if sorted(order) != sorted(TX_CLASSES): return -2
+        return self.dll.SetTxPriority(self.worker_instance, (c_int * len(order))(*[TX_CLASSES.index(name) for name in order]), len(order))
+
+    def set_tx_rate_limit(self, tx_class: str, frames_per_sec: int, burst: int=1) -> int:
+        """
+        Ограничивает скорость отправки класса.
+
+        @param tx_class: Имя класса из TX_CLASSES.
+        @param frames_per_sec: Пакетов в секунду, 0 - без ограничения.
+        @param burst: Пакетов подряд после простоя.
+        @return: 1 если успешно, иначе код ошибки.
+        """
+        return self.dll.SetTxRateLimit(self.worker_instance, TX_CLASSES.index(tx_class), frames_per_sec, burst)
+
+    def get_tx_queue_stats(self) -> dict:
+        """
+        Возвращает счетчики очереди отправки по классам.
+
+        @return: Словарь класс -> счетчики, время ожидания в очереди в микросекундах.
+        """
+        stats = TxQueueStats()
+        self.dll.GetTxQueueStats(self.worker_instance, ctypes.byref(stats))
+        result = {'batches': stats.batches}
+        for i, name in enumerate(TX_CLASSES):
+            result[name] = {'enqueued': stats.enqueued[i], 'sent': stats.sent[i], 'dropped': stats.dropped[i],
+                            'depth': stats.depth[i], 'highWater': stats.highWater[i],
+                            'wait_p50_us': histogram_percentile(stats.latency[i], 0.50) / 1e3,
+                            'wait_p99_us': histogram_percentile(stats.latency[i], 0.99) / 1e3}
+        return result
+
+    def enable_callback_executor(self, threads: int=1, depth: int=0, policy: str='drop', late_us: int=0) -> int:
+        """
+        Переносит вызов callback'ов PDO/ошибок/подписок из потока чтения dll в отдельные потоки: медленный callback
+        (GIL, логирование) больше не задерживает прием пакетов, ответы SDO и heartbeat. Callback'и одного cobid
+        вызываются по порядку. Вызывать до connect.
+
+        @param threads: Количество потоков, 0 - callback'и вызывает поток чтения.
+        @param depth: Размер очереди каждого потока, 0 - по умолчанию.
+        @param policy: 'drop' - при переполнении пакет теряется, 'coalesce' - cobid позже получит последнее значение.
+        @param late_us: Порог опоздания callback'а от приема пакета, 0 - по умолчанию (1 мс).
+        @return: 1 если успешно, иначе код ошибки.
+        """
+        return self.dll.EnableCallbackExecutor(self.worker_instance, threads, depth, ['drop', 'coalesce'].index(policy), late_us)
+
+    def get_callback_stats(self) -> dict:
+        """
+        Возвращает счетчики потоков callback'ов, задержка от приема пакета до вызова в микросекундах.
+        """
+        stats = CallbackStats()
+        self.dll.GetCallbackStats(self.worker_instance, ctypes.byref(stats))
+        result = {name: getattr(stats, name) for name, _ in CallbackStats._fields_ if name != 'delay'}
+        result['delay_p50_us'] = histogram_percentile(stats.delay, 0.50) / 1e3
+        result['delay_p99_us'] = histogram_percentile(stats.delay, 0.99) / 1e3
+        return result
+
+    def enable_latency_trace(self, sample_every: int=0, records: int=0) -> int:
+        """
+        Включает в dll трассировку задержек принятых пакетов по этапам: прием ядром, поток чтения, передача потребителю,
+        очередь и выполнение callback'а, пробуждение ожидающего SDO. Вызывать до connect.
+
+        @param sample_every: -1 - выключить, 0 - только гистограммы этапов, N - еще и каждый N пакет в выборочную трассу.
+        @param records: Размер кольца выборочной трассы, 0 - по умолчанию.
+        @return: 1 если успешно, иначе код ошибки.
+        """
+        return self.dll.EnableLatencyTrace(self.worker_instance, sample_every, records)
+
+    def get_trace_stats(self) -> dict:
+        """
+        Возвращает разбивку задержек по этапам: для каждого этапа количество, p50 и p99 в микросекундах.
+        """
+        stats = TraceStats()
+        self.dll.GetTraceStats(self.worker_instance, ctypes.byref(stats))
+        result = {'stamped': stats.stamped, 'unstamped': stats.unstamped, 'sampled': stats.sampled, 'dropped': stats.dropped}
+        for stage, histogram in zip(TRACE_STAGES, stats.stages):
+            result[stage] = {'count': histogram.count,
+                             'p50_us': histogram_percentile(histogram, 0.50) / 1e3,
+                             'p99_us': histogram_percentile(histogram, 0.99) / 1e3}
+        return result
+
+    def read_trace(self, max_records: int=4096) -> list:
+        """
+        Забирает накопленные записи выборочной трассы пакетов.
+
+        @param max_records: Максимум записей за вызов.
+        @return: Список словарей: cobid и длительности этапов в микросекундах (None - пакет не проходил этап).
+        """
+        records = (TraceRecord * max_records)()
+        count = self.dll.ReadTrace(self.worker_instance, records, max_records)
+        trace = []
+        for record in records[:max(count, 0)]:
+            def span(start, end):
+                return (end - start) / 1e3 if start and end else None
+            trace.append({'cobid': record.cobid,
+                          'kernel_us': span(record.kernel_ns, record.received_ns),
+                          'dispatch_us': span(record.received_ns, record.dispatched_ns),
+                          'callback_wait_us': span(record.dispatched_ns, record.callbackEntered_ns),
+                          'callback_run_us': span(record.callbackEntered_ns, record.callbackReturned_ns),
+                          'received_ns': record.received_ns})
+        return trace
+
+    def set_emcy_filter(self, on_change: bool=True, max_per_second: int=0) -> int:
+        """
+        Настраивает доставку EMCY в get_error: повторы одной ошибки и сверх лимита отбрасываются в dll, таблица ошибок
+        узлов (read_emcy_table) при этом обновляется каждым пакетом. Можно вызывать и после connect.
+
+        @param on_change: True - только при смене кода ошибки или регистра узла, False - каждый пакет.
+        @param max_per_second: Не больше стольких EMCY одного узла в секунду, 0 - без лимита.
+        @return: 1 если успешно, иначе код ошибки.
+        """
+        return self.dll.SetEmcyFilter(self.worker_instance, 1 if on_change else 0, max_per_second)
+
+    def read_emcy_table(self) -> dict:
+        """
+        Читает текущее состояние ошибок всех узлов, присылавших EMCY.
+
+        @return: Словарь ID узла -> EmcyState.
+        """
+        table = (EmcyState * 127)()
+        count = self.dll.ReadEmcyTable(self.worker_instance, table, len(table))
+        return {table[k].nodeId: table[k] for k in range(min(max(count, 0), len(table)))}
+
+    def enable_sdo_cache(self, ttl_ms: int, index_ttl_ms: dict=None) -> int:
+        """
+        Включает кэш SDO в dll: повторный ReadSDO того же объекта отвечает без обмена с узлом, пока не истек ttl
+        и узел не прислал boot-up или не сменил состояние NMT. Успешные записи SDO обновляют кэш.
+
+        @param ttl_ms: Время жизни объекта в миллисекундах, -1 - бесконечно, 0 - выключить кэш.
+        @param index_ttl_ms: Словарь индекс -> ttl для отдельных индексов (0 - не кэшировать, -2 - как у всего кэша).
+        @return: 1 если успешно, иначе код ошибки.
+        """
+        res = self.dll.EnableSDOCache(self.worker_instance, ttl_ms)
+        for index, index_ttl in (index_ttl_ms or {}).items():
+            if res < 0: break
+            res = self.dll.SetSDOCacheTTL(self.worker_instance, index, index_ttl)
+        return res
+
+    def invalidate_sdo_cache(self, node_id: int=0) -> int:
+        """
+        Удаляет из кэша SDO объекты узла.
+
+        @param node_id: Идентификатор узла, 0 - все узлы.
+        @return: Количество удаленных объектов или код ошибки.
+        """
+        return self.dll.InvalidateSDOCache(self.worker_instance, node_id)
+
+    def get_sdo_cache_stats(self) -> dict:
+        """
+        Возвращает счетчики кэша SDO: попадания, промахи, устаревшие объекты (hits - сколько обменов с узлами сэкономлено).
+        """
+        stats = SdoCacheStats()
+        self.dll.GetSDOCacheStats(self.worker_instance, ctypes.byref(stats))
+        result = {name: getattr(stats, name) for name, _ in SdoCacheStats._fields_ if name != 'reserved'}
+        lookups = stats.hits + stats.misses + stats.stale
+        result['hit_ratio'] = stats.hits / lookups if lookups else 0.0
+        return result
+
+    def add_cyclic_pdo(self, cobid: int, pdo_data: bytes, divider: int=1) -> int:
+        """
+        Регистрирует TPDO, который dll отправляет сама из потока циклической отправки (start_cyclic).
+
+        @param cobid: cobid TPDO.
+        @param pdo_data: Начальные данные (до 8 байт), например результат packing_pdo.
+        @param divider: Отправка раз в divider периодов.
+        @return: Номер TPDO для update_cyclic_pdo или код ошибки.
+        """
+        data = bytes(pdo_data)
+        buffer = (c_ubyte * max(len(data), 1)).from_buffer_copy(data.ljust(1, b'\x00'))
+        return self.dll.AddCyclicPDO(self.worker_instance, cobid, buffer, len(data), divider)
+
+    def update_cyclic_pdo(self, slot: int, pdo_data: bytes) -> int:
+        """
+        Атомарно заменяет данные циклического TPDO, следующий период уйдет уже с ними.
+
+        @param slot: Номер TPDO из add_cyclic_pdo.
+        @param pdo_data: Новые данные (до 8 байт).
+        @return: 1 если успешно, иначе код ошибки.
+        """
+        data = bytes(pdo_data)
+        buffer = (c_ubyte * max(len(data), 1)).from_buffer_copy(data.ljust(1, b'\x00'))
+        return self.dll.UpdateCyclicPDO(self.worker_instance, slot, buffer, len(data))
+
+    def remove_cyclic_pdo(self, slot: int) -> int:
+        """
+        Убирает TPDO из циклической отправки.
+        """
+        return self.dll.RemoveCyclicPDO(self.worker_instance, slot)
+
+    def start_cyclic(self, period_us: int, sync: bool=True) -> int:
+        """
+        Запускает поток dll, который каждый период отправляет SYNC и зарегистрированные TPDO независимо от Python.
+
+        @param period_us: Период в микросекундах (100..1000000).
+        @param sync: True - отправлять SYNC (0x80) в начале периода.
+        @return: 1 если поток запущен, иначе код ошибки.
+        """
+        if not self.isConnected: return -1
+        return self.dll.StartCyclic(self.worker_instance, period_us, int(sync))
+
+    def stop_cyclic(self) -> int:
+        """
+        Останавливает поток циклической отправки.
+        """
+        return self.dll.StopCyclic(self.worker_instance)
+
+    def get_cyclic_stats(self) -> dict:
+        """
+        Возвращает счетчики потока циклической отправки и джиттер пробуждения.
+
+        @return: Словарь со счетчиками, опоздания в микросекундах.
+        """
+        stats = CyclicStats()
+        self.dll.GetCyclicStats(self.worker_instance, ctypes.byref(stats))
+        result = {name: getattr(stats, name) for name, _ in CyclicStats._fields_ if name != 'lateness'}
+        result['lateness_p50_us'] = histogram_percentile(stats.lateness, 0.50) / 1e3
+        result['lateness_p99_us'] = histogram_percentile(stats.lateness, 0.99) / 1e3
+        result['lateness_max_us'] = stats.maxLateness_ns / 1e3
+        return result
+
     def Stop_ReadPDO(self,th : threading.Thread) -> int:
         """
         Останавливает процесс чтения PDO.
@@ -468,6 +1532,189 @@ class CanWorker():
         data = bytearray(pointer_to_array[i] for i in range(length))
         logger.error(f"Ошибка на шине {data}")
 
+    def EnablePDORing(self, capacity: int) -> int:
+        """
+        Включает кольцевой буфер PDO вместо callback'а на каждый пакет. Вызывать до connect.
+
+        @param capacity: Размер буфера в записях, 0 - выключить.
+        """
+        res = self.dll.EnablePDORing(self.worker_instance, capacity)
+        if res > 0:
+            self.pdo_records = (PdoRecord * max(capacity, 1))()
+        return res
+
+    def DrainPDO(self) -> list:
+        """
+        Забирает все накопленные в кольцевом буфере PDO за один вызов dll.
+
+        @return: Список записей PdoRecord.
+        """
+        count = self.dll.DrainPDO(self.worker_instance, self.pdo_records, len(self.pdo_records))
+        return self.pdo_records[:count] if count > 0 else []
+
+    def RegisterPDOMappings(self) -> int:
+        """
+        Регистрирует в dll маппинги всех PDO из pdo_objects, после этого dll сама разбирает эти PDO. Вызывать до connect.
+
+        @return: 1 если все маппинги зарегистрированы, иначе код ошибки RegisterPDOMapping.
+        """
+        for cobid, pdo in self.pdo_objects.items():
+            count = len(pdo['mapping'])
+            bit_lengths = (c_int * count)(*pdo['mapping'])
+            data_types = (c_int * count)(*[PDO_TYPE_CODES[t] for t in pdo['data_types']])
+            res = self.dll.RegisterPDOMapping(self.worker_instance, cobid, bit_lengths, data_types, count)
+            if res < 0:
+                logger.error(f"Не удалось зарегистрировать маппинг PDO {hex(cobid)} код {res}")
+                return res
+        return 1
+
+    def ReadPDOSignals(self, cobid: int) -> tuple[int, list]:
+        """
+        Читает последние разобранные dll значения сигналов PDO.
+
+        @param cobid: cobid PDO с зарегистрированным маппингом.
+        @return: Количество принятых пакетов и список значений.
+        """
+        count = len(self.pdo_objects[cobid]['mapping'])
+        values = (ctypes.c_double * count)()
+        updates = ctypes.c_uint32()
+        if self.dll.ReadPDOSignals(self.worker_instance, cobid, values, count, ctypes.byref(updates), None) < 0:
+            return 0, []
+        return updates.value, list(values)
+
+    def enable_aggregation(self, cobid: int, window_ms: int) -> int:
+        """
+        Включает в dll агрегацию сигналов PDO по окнам (min/max/среднее/последнее), чтобы не читать каждый пакет из python.
+        Вызывать до connect после RegisterPDOMappings.
+
+        @param cobid: cobid PDO с зарегистрированным маппингом.
+        @param window_ms: Длина окна в миллисекундах, 0 - выключить.
+        @return: 1 если успешно, иначе код ошибки.
+        """
+        return self.dll.EnableAggregation(self.worker_instance, cobid, window_ms)
+
+    def read_aggregates(self) -> dict:
+        """
+        Читает агрегаты всех сигналов за последнее завершенное окно одним вызовом dll.
+
+        @return: Словарь 'min', 'max', 'mean', 'last', 'count', 'window_end_ns' -> массив numpy,
+                 индекс - номер сигнала в порядке регистрации маппингов, count 0 - окна еще не было.
+        """
+        n = sum(len(pdo['mapping']) for pdo in self.pdo_objects.values())
+        result = {name: np.zeros(n, dtype=np.float64) for name in ('min', 'max', 'mean', 'last')}
+        result['count'] = np.zeros(n, dtype=np.uint32)
+        result['window_end_ns'] = np.zeros(n, dtype=np.uint64)
+        arrays = AggregateArrays(*[result[name].ctypes.data_as(POINTER(ctypes.c_double)) for name in ('min', 'max', 'mean', 'last')],
+                                 result['count'].ctypes.data_as(POINTER(ctypes.c_uint32)),
+                                 result['window_end_ns'].ctypes.data_as(POINTER(ctypes.c_uint64)))
+        copied = self.dll.ReadAggregates(self.worker_instance, ctypes.byref(arrays), n)
+        return {name: values[:max(copied, 0)] for name, values in result.items()}
+
+    def publish_shared_image(self, name: str='/can_image', journal_records: int=0) -> int:
+        """
+        Публикует образ процесса PDO/EMCY и журнал принятых пакетов в общую память, другие процессы
+        читают их через SharedImageReader без своего подключения. Вызывать до connect.
+
+        @param name: Имя сегмента, None - перестать публиковать.
+        @param journal_records: Записей журнала, 0 - по умолчанию.
+        @return: 1 если успешно, -4 если имя занято сегментом работающего процесса, иначе код ошибки.
+        """
+        return self.dll.PublishSharedImage(self.worker_instance, name.encode('utf-8') if name else None, journal_records)
+
+    def SnapshotProcessImage(self) -> dict:
+        """
+        Копирует образ процесса dll: последние PDO и EMCY всех cobid, от которых что-то приходило.
+
+        @return: Словарь cobid -> ProcessImageEntry.
+        """
+        entries = (ProcessImageEntry * 1200)()
+        count = self.dll.SnapshotProcessImage(self.worker_instance, entries, len(entries))
+        return {entry.cobid: entry for entry in entries[:count]}
+
+    def GetStats(self) -> dict:
+        """
+        Возвращает счетчики dll: пакеты по классам, пробуждения потока чтения, потери и перцентили задержек.
+
+        @return: Словарь со счетчиками, задержки в микросекундах.
+        """
+        stats = WorkerStats()
+        self.dll.GetStats(self.worker_instance, ctypes.byref(stats))
+        result = {name: getattr(stats, name) for name, _ in WorkerStats._fields_ if name not in ('rxFrames', 'txFrames', 'sdoRoundTrip', 'callback')}
+        for i, name in enumerate(FRAME_CLASSES):
+            result[f'rx_{name}'] = stats.rxFrames[i]
+            result[f'tx_{name}'] = stats.txFrames[i]
+        for name in ('sdoRoundTrip', 'callback'):
+            histogram = getattr(stats, name)
+            result[f'{name}_count'] = histogram.count
+            result[f'{name}_p50_us'] = histogram_percentile(histogram, 0.50) / 1e3
+            result[f'{name}_p99_us'] = histogram_percentile(histogram, 0.99) / 1e3
+        return result
+
+    def ResetStats(self) -> int:
+        """
+        Обнуляет счетчики и гистограммы dll.
+        """
+        return self.dll.ResetStats(self.worker_instance)
+
+    def start_capture(self, path: str, buffer_records: int=0) -> int:
+        """
+        Начинает запись всех принятых и отправленных пакетов в бинарный файл (читается через read_capture).
+
+        @param path: Путь к файлу.
+        @param buffer_records: Размер буфера в записях, 0 - по умолчанию.
+        @return: 1 если запись начата, иначе код ошибки.
+        """
+        return self.dll.StartCapture(self.worker_instance, path.encode('utf-8'), buffer_records)
+
+    def stop_capture(self) -> int:
+        """
+        Останавливает запись трафика.
+
+        @return: Количество записанных пакетов или -1 если запись не шла.
+        """
+        return self.dll.StopCapture(self.worker_instance)
+
+    def replay_capture(self, path: str, realtime: bool=False) -> int:
+        """
+        Прогоняет запись трафика через разбор пакетов dll (callback'и, кольцевой буфер, маппинги PDO, образ процесса).
+        Вызывается без подключения.
+
+        @param path: Путь к файлу.
+        @param realtime: True - с исходными интервалами, False - с максимальной скоростью.
+        @return: Количество разобранных пакетов или код ошибки.
+        """
+        if self.isConnected: return -1
+        return self.dll.ReplayCapture(self.worker_instance, path.encode('utf-8'), int(realtime))
+
+    def run_benchmark(self, iterations: int=1000000) -> dict:
+        """
+        Микробенчмарк разбора пакетов в dll на синтетических кадрах (заголовок и проверка SDO, классификация cobid,
+        разбор PDO/EMCY с callback и без). Идет на временном Worker в dll и не меняет состояние подключения,
+        полный набор измерений - can_bench.py.
+
+        @param iterations: Количество операций в каждом измерении.
+        @return: Словарь имя измерения - наносекунд на операцию, пустой при ошибке.
+        """
+        results = (BenchResult * 8)()
+        count = self.dll.RunBenchmark(self.worker_instance, iterations, results, len(results))
+        return {result.name.decode(): result.total_ns / result.iterations for result in results[:max(count, 0)]}
+
+    def subscribe(self, cobid: int, mode: str, func=None, mask: int=0x7FF) -> int:
+        """
+        Настраивает маршрут пакетов cobid в dll (на SocketCAN еще и фильтр ядра).
+
+        @param cobid: cobid подписки.
+        @param mode: Режим из SUBSCRIBE_MODES.
+        @param func: Функция func(buffer) для режима 'callback', формат буфера как у callback_pdo.
+        @param mask: Маска сравнения cobid (0x7FF - один cobid).
+        @return: Количество cobid с новым маршрутом или код ошибки.
+        """
+        callback = CALLBACK_FUNC(func) if func else CALLBACK_FUNC()
+        result = self.dll.Subscribe(self.worker_instance, cobid, mask, SUBSCRIBE_MODES[mode], callback)
+        if result > 0:
+            self.subscriptions[(cobid, mask)] = callback
+        return result
+
     def register_callbac_pdo(self,func):
         dll.RegisterCallback_pdo(self.worker_instance,func)
 